@@ -14,6 +14,8 @@ Debugger::Debugger()
 	m_PPUMemoryEditor.WriteFn = [](ImU8* data, size_t offset, ImU8 byte) -> void { ((NESDevice*)data)->PPUWrite((uint16_t)offset, byte); };
 
 	m_OAMMemoryEditor.Cols = 8;
+	m_OAMMemoryEditor.ReadFn = [](const ImU8* data, size_t offset) -> ImU8 { return ((NESPPU*)data)->OAMData[offset]; };
+	m_OAMMemoryEditor.WriteFn = [](ImU8* data, size_t offset, ImU8 byte) -> void { ((NESPPU*)data)->WriteOAMByte((uint8_t)offset, byte); };
 	m_OAMMemoryEditor.OptMidColsCount = 4;
 	m_OAMMemoryEditor.OptShowAscii = false;
 	m_OAMMemoryEditor.OptShowDataPreview = false;
@@ -216,6 +218,8 @@ bool Debugger::ShowCPUControls()
 		//Status register
 		if (isRegistersVisible)
 		{
+			//SR is shown and edited directly
+			nesCPU.SyncFlags();
 			ImGui::TextUnformatted("Flags :"); ImGui::SameLine();
 
 			ImGui::PushStyleColor(ImGuiCol_Text, nesCPU.getFlag(NESCPU::SRFlag::NegativeBit) ? ImVec4(0, 1, 0, 1) : ImVec4(1, 0, 0, 1));
@@ -314,9 +318,12 @@ bool Debugger::ShowCPUControls()
 		}
 		if (isStatusVisible)
 		{
-			ImGui::Text("M.  Cycle # : %d", m_NESDevicePtr->DeviceCycle);
+			ImGui::Text("M.  Cycle # : %llu", (unsigned long long)m_NESDevicePtr->DeviceCycle);
 			ImGui::Text("CPU Cycle # : %d", nesCPU.State.CyclesTotal);
 			ImGui::Text("CPU C.Queue : %d", nesCPU.State.CycleCounter);
+			ImGui::Text("Idle skip.  : %llu", (unsigned long long)m_NESDevicePtr->IdleLoopCyclesSkipped);
+			ImGui::Text("JIT instr.  : %llu", (unsigned long long)m_NESDevicePtr->GetJIT().InstructionsExecuted);
+			ImGui::Text("Static ins. : %llu", (unsigned long long)m_NESDevicePtr->StaticCodeInstructions);
 			ImGui::TextUnformatted("CPU State :"); ImGui::SameLine();
 			
 			if (nesCPU.State.Halted)
@@ -616,7 +623,7 @@ bool Debugger::ShowPPUData()
 		}
 		if (isReservedVisible)
 		{
-			m_OAMMemoryEditor.DrawContents(nesPPU.OAMData, 256);
+			m_OAMMemoryEditor.DrawContents((ImU8*)&nesPPU, 256);
 			//m_OAMMemoryEditor.DrawContents(nesPPU.SecondOAMData, 32);
 		}
 		ImGui::EndChild();
@@ -649,6 +656,7 @@ void Debugger::Update()
 			//----------
 
 			auto lst = m_NESDevicePtr->GetCPU().Disassemble(m_NESDevicePtr->GetCPU().Registers.PC, 1, false);
+			m_NESDevicePtr->GetCPU().SyncFlags();
 			printf("%-48s\tA:%.2X X:%.2X Y:%.2X P:%.2X SP:%.2X PPU:%3d,%3d CYC:%d\n",
 				lst[0].c_str(),
 				m_NESDevicePtr->GetCPU().Registers.AC,
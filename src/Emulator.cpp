@@ -510,6 +510,17 @@ void Emulator::ProcessWindows()
 			{
 				m_NESDevice.Reset();
 			}
+
+			bool perCycleMode = (m_NESDevice.ExecutionMode == NESDevice::ExecutionMode::PerCycle);
+			if (ImGui::MenuItem("Per-cycle CPU", NULL, &perCycleMode))
+			{
+				m_NESDevice.ExecutionMode = perCycleMode ? NESDevice::ExecutionMode::PerCycle : NESDevice::ExecutionMode::PerInstruction;
+			}
+			ImGui::MenuItem("Skip idle loops", NULL, &m_NESDevice.IdleLoopSkipping, !perCycleMode);
+			ImGui::MenuItem("Fuse instruction pairs", NULL, &m_NESDevice.InstructionFusion, !perCycleMode);
+			ImGui::MenuItem("Render whole scanlines", NULL, &m_NESDevice.ScanlineRendering, !perCycleMode);
+			ImGui::MenuItem("Recompile ROM code (JIT)", NULL, &m_NESDevice.JITEnabled, !perCycleMode && m_NESDevice.GetJIT().IsSupported());
+			ImGui::MenuItem("Use static recompiled code", NULL, &m_NESDevice.StaticCodeEnabled, !perCycleMode && m_NESDevice.GetStaticCode() != nullptr);
 			ImGui::EndMenu();
 		}
 
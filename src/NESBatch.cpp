@@ -0,0 +1,737 @@
+#include "NESBatch.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef NES_BATCH_AVX2
+#include <immintrin.h>
+#define NES_BATCH_AVX2_FN __attribute__((target("avx2")))
+#endif
+
+using am = NESCPU::AddrMode;
+
+NESBatch::NESBatch(uint32_t lanes) :
+	LockstepEnabled(true),
+	LockstepInstructions(0),
+	LockstepBlocks(0),
+	m_Remaining(0)
+{
+	if (lanes == 0) lanes = 1;
+	for (uint32_t lane = 0; lane < lanes; lane++)
+	{
+		m_Lanes.push_back(std::make_unique<NESDevice>());
+		m_Lanes.back()->SetLeanMode(true);
+		m_RAM.push_back(m_Lanes.back()->GetRAM());
+	}
+
+	m_PaddedCount = (lanes + VectorLanes - 1) / VectorLanes * VectorLanes;
+	for (std::vector<uint8_t>* array : { &m_AC, &m_XR, &m_YR, &m_SR, &m_SP, &m_Operand, &m_Mask })
+		array->assign(m_PaddedCount, 0);
+
+	m_Address.resize(lanes);
+	m_NextPC.resize(lanes);
+	m_Penalty.resize(lanes);
+	m_Cycles.resize(lanes);
+	m_LastCycles.resize(lanes);
+	m_Budget.resize(lanes);
+	m_IsDone.resize(lanes);
+
+#ifdef NES_BATCH_AVX2
+	__builtin_cpu_init();
+	m_IsAVX2 = __builtin_cpu_supports("avx2") != 0;
+#else
+	m_IsAVX2 = false;
+#endif
+	prepare_table();
+}
+
+bool NESBatch::LoadCartrige(const std::string& file_name)
+{
+	for (std::unique_ptr<NESDevice>& device : m_Lanes)
+	{
+		if (!device->GetCartrige().LoadCartrige(file_name))
+			return false;
+	}
+	return true;
+}
+
+void NESBatch::Reset()
+{
+	for (std::unique_ptr<NESDevice>& device : m_Lanes)
+		device->Reset();
+	LockstepInstructions = 0;
+	LockstepBlocks = 0;
+}
+
+uint32_t NESBatch::GetLaneCount()
+{
+	return (uint32_t)m_Lanes.size();
+}
+
+NESDevice& NESBatch::GetLane(uint32_t lane)
+{
+	return *m_Lanes[lane];
+}
+
+bool NESBatch::IsAVX2Supported()
+{
+	return m_IsAVX2;
+}
+
+void NESBatch::Update()
+{
+	m_Remaining = 0;
+	for (uint32_t lane = 0; lane < m_Lanes.size(); lane++)
+	{
+		NESDevice& device = *m_Lanes[lane];
+		if (device.DeviceMode == NESDevice::DeviceMode::Running && device.ExecutionMode == NESDevice::ExecutionMode::PerInstruction)
+		{
+			device.BeginFrame();
+			m_IsDone[lane] = 0;
+			m_Remaining++;
+		}
+		else
+		{
+			//Paused or per-cycle lanes go the regular way
+			device.Update();
+			m_IsDone[lane] = 1;
+		}
+	}
+
+	uint32_t leader = 0;
+	while (m_Remaining > 0)
+	{
+		while (m_IsDone[leader]) leader++;
+
+		if (LockstepEnabled)
+		{
+			find_group(leader);
+			if (m_Group.size() >= MinLockstepLanes)
+			{
+				//Group sits at instruction lockstep core can't run, every lane steps it on its own
+				if (!run_block())
+				{
+					for (uint32_t lane : m_Group)
+						step_lane(lane);
+				}
+				continue;
+			}
+			if (m_Group.empty())
+			{
+				//Leader has to go through device (interrupt, event, code in RAM)
+				step_lane(leader);
+				continue;
+			}
+		}
+
+		//No partner at this PC, leader runs on its own for a while
+		for (uint32_t step = 0; !m_IsDone[leader] && (!LockstepEnabled || step < ScalarBurst); step++)
+			step_lane(leader);
+	}
+}
+
+void NESBatch::prepare_table()
+{
+	static const struct
+	{
+		const char* Name;
+		Operation Op;
+		OpClass Class;
+	} names[] =
+	{
+		{ "LDA", Operation::LDA, OpClass::Read }, { "LDX", Operation::LDX, OpClass::Read }, { "LDY", Operation::LDY, OpClass::Read },
+		{ "STA", Operation::STA, OpClass::Store }, { "STX", Operation::STX, OpClass::Store }, { "STY", Operation::STY, OpClass::Store },
+		{ "ORA", Operation::ORA, OpClass::Read }, { "AND", Operation::AND, OpClass::Read }, { "EOR", Operation::EOR, OpClass::Read },
+		{ "ADC", Operation::ADC, OpClass::Read }, { "SBC", Operation::SBC, OpClass::Read }, { "CMP", Operation::CMP, OpClass::Read },
+		{ "CPX", Operation::CPX, OpClass::Read }, { "CPY", Operation::CPY, OpClass::Read }, { "BIT", Operation::BIT, OpClass::Read },
+		{ "ASL", Operation::ASL, OpClass::Modify }, { "LSR", Operation::LSR, OpClass::Modify }, { "ROL", Operation::ROL, OpClass::Modify },
+		{ "ROR", Operation::ROR, OpClass::Modify }, { "INC", Operation::INC, OpClass::Modify }, { "DEC", Operation::DEC, OpClass::Modify },
+		{ "TAX", Operation::TAX, OpClass::Register }, { "TXA", Operation::TXA, OpClass::Register }, { "TAY", Operation::TAY, OpClass::Register },
+		{ "TYA", Operation::TYA, OpClass::Register }, { "TSX", Operation::TSX, OpClass::Register }, { "TXS", Operation::TXS, OpClass::Register },
+		{ "INX", Operation::INX, OpClass::Register }, { "INY", Operation::INY, OpClass::Register }, { "DEX", Operation::DEX, OpClass::Register },
+		{ "DEY", Operation::DEY, OpClass::Register }, { "CLC", Operation::CLC, OpClass::Register }, { "SEC", Operation::SEC, OpClass::Register },
+		{ "CLV", Operation::CLV, OpClass::Register }, { "CLD", Operation::CLD, OpClass::Register }, { "SED", Operation::SED, OpClass::Register },
+		{ "NOP", Operation::NOP, OpClass::Register },
+		{ "PHA", Operation::PHA, OpClass::Stack }, { "PHP", Operation::PHP, OpClass::Stack }, { "PLA", Operation::PLA, OpClass::Stack },
+		{ "BPL", Operation::BPL, OpClass::Branch }, { "BMI", Operation::BMI, OpClass::Branch }, { "BVC", Operation::BVC, OpClass::Branch },
+		{ "BVS", Operation::BVS, OpClass::Branch }, { "BCC", Operation::BCC, OpClass::Branch }, { "BCS", Operation::BCS, OpClass::Branch },
+		{ "BNE", Operation::BNE, OpClass::Branch }, { "BEQ", Operation::BEQ, OpClass::Branch },
+		{ "JMP", Operation::JMP, OpClass::Jump }, { "JSR", Operation::JSR, OpClass::Jump }, { "RTS", Operation::RTS, OpClass::Jump },
+	};
+
+	NESCPU& cpu = m_Lanes[0]->GetCPU();
+	for (uint32_t opcode = 0; opcode < 256; opcode++)
+	{
+		OpInfo info;
+		const char* name = cpu.GetInstructionName((uint8_t)opcode);
+		for (const auto& entry : names)
+		{
+			if (!strcmp(name, entry.Name))
+			{
+				info.Op = entry.Op;
+				info.Class = entry.Class;
+				break;
+			}
+		}
+		info.Mode = cpu.GetInstructionMode((uint8_t)opcode);
+		info.Size = cpu.GetInstructionSize((uint8_t)opcode);
+
+		//JMP (ind) is left to device
+		if (info.Op == Operation::None || info.Mode == am::IND)
+			continue;
+
+		switch (info.Class)
+		{
+		case OpClass::Read:
+			switch (info.Mode)
+			{
+			case am::IMM: info.Cycles = 2; break;
+			case am::ZPG: info.Cycles = 3; break;
+			case am::ZPX: case am::ZPY: case am::ABS: info.Cycles = 4; break;
+			case am::ABX: case am::ABY: info.Cycles = 4; info.Extra = 1; break;
+			case am::XIN: info.Cycles = 6; break;
+			case am::INY: info.Cycles = 5; info.Extra = 1; break;
+			default: continue;
+			}
+			break;
+		case OpClass::Store:
+			switch (info.Mode)
+			{
+			case am::ZPG: info.Cycles = 3; break;
+			case am::ZPX: case am::ZPY: case am::ABS: info.Cycles = 4; break;
+			case am::ABX: case am::ABY: info.Cycles = 5; break;
+			case am::XIN: case am::INY: info.Cycles = 6; break;
+			default: continue;
+			}
+			break;
+		case OpClass::Modify:
+			switch (info.Mode)
+			{
+			case am::ACC: info.Cycles = 2; break;
+			case am::ZPG: info.Cycles = 5; break;
+			case am::ZPX: case am::ABS: info.Cycles = 6; break;
+			case am::ABX: info.Cycles = 7; break;
+			default: continue;
+			}
+			break;
+		case OpClass::Register:
+			info.Cycles = 2;
+			break;
+		case OpClass::Stack:
+			info.Cycles = (info.Op == Operation::PLA) ? 4 : 3;
+			break;
+		case OpClass::Branch:
+			info.Cycles = 2;
+			info.Extra = 2;
+			break;
+		case OpClass::Jump:
+			info.Cycles = (info.Op == Operation::JMP) ? 3 : 6;
+			break;
+		}
+		m_OpTable[opcode] = info;
+	}
+}
+
+void NESBatch::step_lane(uint32_t lane)
+{
+	NESDevice& device = *m_Lanes[lane];
+	if (device.StepInstruction() || device.DeviceMode != NESDevice::DeviceMode::Running)
+	{
+		m_IsDone[lane] = 1;
+		m_Remaining--;
+	}
+}
+
+void NESBatch::find_group(uint32_t leader)
+{
+	m_Group.clear();
+
+	NESDevice& device = *m_Lanes[leader];
+	const uint16_t pc = device.GetCPU().Registers.PC;
+	if (device.GetCPUROM(pc) == nullptr) return;
+	const uint32_t budget = device.ExternalCPUBudget();
+	if (budget == 0) return;
+
+	m_Budget[leader] = budget;
+	m_Group.push_back(leader);
+	for (uint32_t lane = leader + 1; lane < m_Lanes.size(); lane++)
+	{
+		if (m_IsDone[lane] || m_Lanes[lane]->GetCPU().Registers.PC != pc) continue;
+		m_Budget[lane] = m_Lanes[lane]->ExternalCPUBudget();
+		if (m_Budget[lane] != 0)
+			m_Group.push_back(lane);
+	}
+}
+
+bool NESBatch::run_block()
+{
+	NESDevice& leader = *m_Lanes[m_Group[0]];
+	const uint16_t pc = leader.GetCPU().Registers.PC;
+	const uint8_t* code = leader.GetCPUROM(pc);
+
+	uint32_t budget = UINT32_MAX;
+	for (uint32_t lane : m_Group)
+		budget = std::min(budget, m_Budget[lane]);
+
+	//Straight-line code within single ROM page which fits into every lane's budget
+	const uint32_t page_left = 0x0400 - (pc & 0x03FF);
+	uint16_t offsets[MaxBlockInstructions];
+	uint32_t count = 0;
+	uint32_t span = 0;
+	uint32_t worst_cycles = 0;
+	while (count < MaxBlockInstructions)
+	{
+		const OpInfo& info = m_OpTable[code[span]];
+		if (info.Op == Operation::None || span + info.Size > page_left) break;
+		if (worst_cycles + info.Cycles + info.Extra > budget) break;
+		worst_cycles += info.Cycles + info.Extra;
+		offsets[count++] = (uint16_t)span;
+		span += info.Size;
+		if (info.Class == OpClass::Branch || info.Class == OpClass::Jump) break;
+	}
+	if (count == 0) return false;
+
+	//Lanes may have different bank mapped in
+	m_Group.erase(std::remove_if(m_Group.begin() + 1, m_Group.end(), [&](uint32_t lane)
+	{
+		const uint8_t* lane_code = m_Lanes[lane]->GetCPUROM(pc);
+		return lane_code == nullptr || memcmp(lane_code, code, span) != 0;
+	}), m_Group.end());
+	if (m_Group.size() < MinLockstepLanes) return false;
+
+	//Gather register file
+	memset(m_Mask.data(), 0, m_PaddedCount);
+	for (uint32_t lane : m_Group)
+	{
+		NESCPU& cpu = m_Lanes[lane]->GetCPU();
+		cpu.SyncFlags();
+		m_AC[lane] = cpu.Registers.AC;
+		m_XR[lane] = cpu.Registers.XR;
+		m_YR[lane] = cpu.Registers.YR;
+		m_SR[lane] = cpu.Registers.SR;
+		m_SP[lane] = cpu.Registers.SP;
+		m_Mask[lane] = 0xFF;
+		m_NextPC[lane] = (uint16_t)(pc + span);
+		m_Cycles[lane] = 0;
+	}
+
+	uint32_t executed = 0;
+	while (executed < count)
+	{
+		const uint8_t* instruction = code + offsets[executed];
+		if (!execute(m_OpTable[instruction[0]], instruction + 1, (uint16_t)(pc + offsets[executed])))
+			break;
+		executed++;
+	}
+	if (executed == 0) return false;
+	if (executed < count)
+	{
+		for (uint32_t lane : m_Group)
+			m_NextPC[lane] = (uint16_t)(pc + offsets[executed]);
+	}
+
+	//Scatter register file and account cycles
+	const uint8_t last_opcode = code[offsets[executed - 1]];
+	for (uint32_t lane : m_Group)
+	{
+		NESDevice& device = *m_Lanes[lane];
+		NESCPU& cpu = device.GetCPU();
+		cpu.Registers.AC = m_AC[lane];
+		cpu.Registers.XR = m_XR[lane];
+		cpu.Registers.YR = m_YR[lane];
+		cpu.Registers.SR = m_SR[lane];
+		cpu.Registers.SP = m_SP[lane];
+		cpu.Registers.PC = m_NextPC[lane];
+
+		const uint32_t history = std::min<uint32_t>(executed, 8);
+		memmove(cpu.State.LastOperations, &cpu.State.LastOperations[history], sizeof(uint16_t) * (8 - history));
+		for (uint32_t index = 0; index < history; index++)
+			cpu.State.LastOperations[8 - history + index] = (uint16_t)(pc + offsets[executed - history + index]);
+		cpu.State.CurrentOpCode = last_opcode;
+		cpu.State.CurrentAddrMode = m_OpTable[last_opcode].Mode;
+		cpu.State.CycleCounter = (uint8_t)m_LastCycles[lane];
+
+		if (device.ExternalCPUCycles(m_Cycles[lane]))
+		{
+			m_IsDone[lane] = 1;
+			m_Remaining--;
+		}
+	}
+
+	LockstepInstructions += (uint64_t)executed * m_Group.size();
+	LockstepBlocks++;
+	return true;
+}
+
+bool NESBatch::resolve_addresses(const OpInfo& info, const uint8_t* operand)
+{
+	const uint8_t zpg = operand[0];
+	const uint16_t abs = (uint16_t)operand[0] | (info.Size > 2 ? (uint16_t)operand[1] << 8 : 0);
+	const bool is_write = info.Class != OpClass::Read;
+
+	for (uint32_t lane : m_Group)
+	{
+		const uint8_t* ram = m_RAM[lane];
+		uint16_t address = 0;
+		uint16_t base = 0;
+		switch (info.Mode)
+		{
+		case am::ZPG: address = zpg; base = address; break;
+		case am::ZPX: address = (uint8_t)(zpg + m_XR[lane]); base = address; break;
+		case am::ZPY: address = (uint8_t)(zpg + m_YR[lane]); base = address; break;
+		case am::ABS: address = abs; base = address; break;
+		case am::ABX: address = (uint16_t)(abs + m_XR[lane]); base = abs; break;
+		case am::ABY: address = (uint16_t)(abs + m_YR[lane]); base = abs; break;
+		case am::XIN:
+		{
+			const uint8_t ptr = (uint8_t)(zpg + m_XR[lane]);
+			address = (uint16_t)ram[ptr] | ((uint16_t)ram[(uint8_t)(ptr + 1)] << 8);
+			base = address;
+			break;
+		}
+		case am::INY:
+			base = (uint16_t)ram[zpg] | ((uint16_t)ram[(uint8_t)(zpg + 1)] << 8);
+			address = (uint16_t)(base + m_YR[lane]);
+			break;
+		default:
+			return false;
+		}
+
+		//Only internal RAM may be written, ROM read, anything else needs device
+		if (address >= 0x2000 && (is_write || m_Lanes[lane]->GetCPUROM(address) == nullptr))
+			return false;
+		m_Address[lane] = address;
+		m_Penalty[lane] = (info.Extra != 0 && ((base ^ address) & 0xFF00) != 0) ? 1 : 0;
+	}
+
+	if (info.Class == OpClass::Read || info.Class == OpClass::Modify)
+	{
+		for (uint32_t lane : m_Group)
+		{
+			const uint16_t address = m_Address[lane];
+			m_Operand[lane] = (address < 0x2000) ? m_RAM[lane][address & 0x07FF] : *m_Lanes[lane]->GetCPUROM(address);
+		}
+	}
+	return true;
+}
+
+bool NESBatch::execute(const OpInfo& info, const uint8_t* operand, uint16_t pc)
+{
+	const bool is_memory = (info.Class == OpClass::Read || info.Class == OpClass::Store || info.Class == OpClass::Modify) &&
+		info.Mode != am::IMM && info.Mode != am::ACC;
+	if (is_memory)
+	{
+		if (!resolve_addresses(info, operand))
+			return false;
+	}
+	else
+	{
+		for (uint32_t lane : m_Group)
+			m_Penalty[lane] = 0;
+	}
+
+	switch (info.Class)
+	{
+	case OpClass::Read:
+		if (info.Mode == am::IMM)
+			memset(m_Operand.data(), operand[0], m_PaddedCount);
+		execute_alu(info.Op, false);
+		break;
+	case OpClass::Store:
+	{
+		const std::vector<uint8_t>& source = (info.Op == Operation::STA) ? m_AC : (info.Op == Operation::STX) ? m_XR : m_YR;
+		for (uint32_t lane : m_Group)
+			m_RAM[lane][m_Address[lane] & 0x07FF] = source[lane];
+		break;
+	}
+	case OpClass::Modify:
+		if (info.Mode == am::ACC)
+		{
+			memcpy(m_Operand.data(), m_AC.data(), m_PaddedCount);
+			execute_alu(info.Op, true);
+		}
+		else
+		{
+			execute_alu(info.Op, false);
+			for (uint32_t lane : m_Group)
+				m_RAM[lane][m_Address[lane] & 0x07FF] = m_Operand[lane];
+		}
+		break;
+	case OpClass::Register:
+		execute_alu(info.Op, false);
+		break;
+	case OpClass::Stack:
+		if (info.Op == Operation::PLA)
+		{
+			for (uint32_t lane : m_Group)
+				m_Operand[lane] = m_RAM[lane][0x0100 | ++m_SP[lane]];
+			execute_alu(Operation::LDA, false);
+		}
+		else
+		{
+			const bool is_status = info.Op == Operation::PHP;
+			for (uint32_t lane : m_Group)
+				m_RAM[lane][0x0100 | m_SP[lane]--] = is_status ? (m_SR[lane] | 0x20) : m_AC[lane];
+		}
+		break;
+	case OpClass::Branch:
+	{
+		static const uint8_t flags[] = { 0x80, 0x80, 0x40, 0x40, 0x01, 0x01, 0x02, 0x02 };
+		const uint32_t index = (uint32_t)info.Op - (uint32_t)Operation::BPL;
+		const uint8_t flag = flags[index];
+		const bool is_set = (index & 1) != 0;
+		const uint16_t next = (uint16_t)(pc + 2);
+		const uint16_t target = (uint16_t)(next + (int8_t)operand[0]);
+		const uint8_t penalty = ((next ^ target) & 0xFF00) ? 2 : 1;
+		for (uint32_t lane : m_Group)
+		{
+			const bool is_taken = ((m_SR[lane] & flag) != 0) == is_set;
+			m_NextPC[lane] = is_taken ? target : next;
+			m_Penalty[lane] = is_taken ? penalty : 0;
+		}
+		break;
+	}
+	case OpClass::Jump:
+	{
+		const uint16_t target = (uint16_t)operand[0] | ((uint16_t)operand[1] << 8);
+		for (uint32_t lane : m_Group)
+		{
+			uint8_t* ram = m_RAM[lane];
+			if (info.Op == Operation::JMP)
+			{
+				m_NextPC[lane] = target;
+			}
+			else if (info.Op == Operation::JSR)
+			{
+				const uint16_t ret = (uint16_t)(pc + 2);
+				ram[0x0100 | m_SP[lane]--] = (uint8_t)(ret >> 8);
+				ram[0x0100 | m_SP[lane]--] = (uint8_t)ret;
+				m_NextPC[lane] = target;
+			}
+			else
+			{
+				uint16_t ret = ram[0x0100 | ++m_SP[lane]];
+				ret |= (uint16_t)ram[0x0100 | ++m_SP[lane]] << 8;
+				m_NextPC[lane] = (uint16_t)(ret + 1);
+			}
+		}
+		break;
+	}
+	}
+
+	for (uint32_t lane : m_Group)
+	{
+		m_LastCycles[lane] = info.Cycles + m_Penalty[lane];
+		m_Cycles[lane] += m_LastCycles[lane];
+	}
+	return true;
+}
+
+void NESBatch::execute_alu(Operation op, bool accumulator)
+{
+#ifdef NES_BATCH_AVX2
+	if (m_IsAVX2)
+	{
+		execute_alu_avx2(op, accumulator);
+		return;
+	}
+#endif
+	for (uint32_t lane : m_Group)
+		execute_alu_scalar(op, accumulator, lane);
+}
+
+void NESBatch::execute_alu_scalar(Operation op, bool accumulator, uint32_t lane)
+{
+	uint8_t& ac = m_AC[lane];
+	uint8_t& xr = m_XR[lane];
+	uint8_t& yr = m_YR[lane];
+	uint8_t& sr = m_SR[lane];
+	uint8_t& sp = m_SP[lane];
+	uint8_t& m = m_Operand[lane];
+
+	auto set_nz = [&sr](uint8_t value) { sr = (sr & 0x7D) | (value & 0x80) | (value == 0 ? 0x02 : 0x00); };
+	auto set_c = [&sr](bool value) { sr = (sr & 0xFE) | (value ? 0x01 : 0x00); };
+	auto add = [&](uint8_t value)
+	{
+		const uint16_t result = (uint16_t)ac + value + (sr & 0x01);
+		sr = (sr & 0xBF) | ((~(ac ^ value) & (ac ^ result) & 0x80) ? 0x40 : 0x00);
+		set_c(result > 0xFF);
+		ac = (uint8_t)result;
+		set_nz(ac);
+	};
+	auto compare = [&](uint8_t reg)
+	{
+		set_c(reg >= m);
+		set_nz((uint8_t)(reg - m));
+	};
+
+	switch (op)
+	{
+	case Operation::LDA: ac = m; set_nz(ac); break;
+	case Operation::LDX: xr = m; set_nz(xr); break;
+	case Operation::LDY: yr = m; set_nz(yr); break;
+	case Operation::ORA: ac |= m; set_nz(ac); break;
+	case Operation::AND: ac &= m; set_nz(ac); break;
+	case Operation::EOR: ac ^= m; set_nz(ac); break;
+	case Operation::ADC: add(m); break;
+	case Operation::SBC: add((uint8_t)~m); break;
+	case Operation::CMP: compare(ac); break;
+	case Operation::CPX: compare(xr); break;
+	case Operation::CPY: compare(yr); break;
+	case Operation::BIT: sr = (sr & 0x3D) | (m & 0xC0) | ((ac & m) == 0 ? 0x02 : 0x00); break;
+	case Operation::ASL: set_c(m & 0x80); m = (uint8_t)(m << 1); set_nz(m); break;
+	case Operation::LSR: set_c(m & 0x01); m >>= 1; set_nz(m); break;
+	case Operation::ROL: { const uint8_t c = sr & 0x01; set_c(m & 0x80); m = (uint8_t)(m << 1) | c; set_nz(m); break; }
+	case Operation::ROR: { const uint8_t c = sr & 0x01; set_c(m & 0x01); m = (m >> 1) | (c << 7); set_nz(m); break; }
+	case Operation::INC: m++; set_nz(m); break;
+	case Operation::DEC: m--; set_nz(m); break;
+	case Operation::TAX: xr = ac; set_nz(xr); break;
+	case Operation::TXA: ac = xr; set_nz(ac); break;
+	case Operation::TAY: yr = ac; set_nz(yr); break;
+	case Operation::TYA: ac = yr; set_nz(ac); break;
+	case Operation::TSX: xr = sp; set_nz(xr); break;
+	case Operation::TXS: sp = xr; break;
+	case Operation::INX: xr++; set_nz(xr); break;
+	case Operation::INY: yr++; set_nz(yr); break;
+	case Operation::DEX: xr--; set_nz(xr); break;
+	case Operation::DEY: yr--; set_nz(yr); break;
+	case Operation::CLC: sr &= 0xFE; break;
+	case Operation::SEC: sr |= 0x01; break;
+	case Operation::CLV: sr &= 0xBF; break;
+	case Operation::CLD: sr &= 0xF7; break;
+	case Operation::SED: sr |= 0x08; break;
+	default: break;
+	}
+	if (accumulator) ac = m;
+}
+
+#ifdef NES_BATCH_AVX2
+//Byte-wise helpers, AVX2 has no 8 bit shifts so 16 bit ones are masked
+NES_BATCH_AVX2_FN static inline __m256i avx2_set_nz(__m256i sr, __m256i value)
+{
+	const __m256i n = _mm256_and_si256(value, _mm256_set1_epi8((char)0x80));
+	const __m256i z = _mm256_and_si256(_mm256_cmpeq_epi8(value, _mm256_setzero_si256()), _mm256_set1_epi8(0x02));
+	return _mm256_or_si256(_mm256_and_si256(sr, _mm256_set1_epi8(0x7D)), _mm256_or_si256(n, z));
+}
+//'carry' holds 0/1 per byte
+NES_BATCH_AVX2_FN static inline __m256i avx2_set_c(__m256i sr, __m256i carry)
+{
+	return _mm256_or_si256(_mm256_and_si256(sr, _mm256_set1_epi8((char)0xFE)), carry);
+}
+NES_BATCH_AVX2_FN static inline __m256i avx2_bit7(__m256i value)
+{
+	return _mm256_and_si256(_mm256_srli_epi16(value, 7), _mm256_set1_epi8(0x01));
+}
+NES_BATCH_AVX2_FN static inline __m256i avx2_shr1(__m256i value)
+{
+	return _mm256_and_si256(_mm256_srli_epi16(value, 1), _mm256_set1_epi8(0x7F));
+}
+NES_BATCH_AVX2_FN static inline __m256i avx2_add(__m256i& sr, __m256i ac, __m256i value)
+{
+	const __m256i sum = _mm256_add_epi8(_mm256_add_epi8(ac, value), _mm256_and_si256(sr, _mm256_set1_epi8(0x01)));
+	//Carry out of bit 7 and signed overflow
+	const __m256i carry = avx2_bit7(_mm256_or_si256(_mm256_and_si256(ac, value), _mm256_andnot_si256(sum, _mm256_or_si256(ac, value))));
+	const __m256i overflow = _mm256_andnot_si256(_mm256_xor_si256(ac, value), _mm256_xor_si256(ac, sum));
+	sr = _mm256_and_si256(sr, _mm256_set1_epi8((char)0xBE));
+	sr = _mm256_or_si256(sr, _mm256_or_si256(carry, _mm256_and_si256(_mm256_srli_epi16(overflow, 1), _mm256_set1_epi8(0x40))));
+	sr = avx2_set_nz(sr, sum);
+	return sum;
+}
+NES_BATCH_AVX2_FN static inline __m256i avx2_compare(__m256i sr, __m256i reg, __m256i value)
+{
+	const __m256i carry = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_max_epu8(reg, value), reg), _mm256_set1_epi8(0x01));
+	return avx2_set_nz(avx2_set_c(sr, carry), _mm256_sub_epi8(reg, value));
+}
+
+NES_BATCH_AVX2_FN void NESBatch::execute_alu_avx2(Operation op, bool accumulator)
+{
+	const __m256i one = _mm256_set1_epi8(0x01);
+	for (uint32_t base = 0; base < m_PaddedCount; base += VectorLanes)
+	{
+		const __m256i mask = _mm256_loadu_si256((const __m256i*)&m_Mask[base]);
+		if (_mm256_testz_si256(mask, mask)) continue;
+
+		const __m256i ac_in = _mm256_loadu_si256((const __m256i*)&m_AC[base]);
+		const __m256i xr_in = _mm256_loadu_si256((const __m256i*)&m_XR[base]);
+		const __m256i yr_in = _mm256_loadu_si256((const __m256i*)&m_YR[base]);
+		const __m256i sr_in = _mm256_loadu_si256((const __m256i*)&m_SR[base]);
+		const __m256i sp_in = _mm256_loadu_si256((const __m256i*)&m_SP[base]);
+		const __m256i m_in = _mm256_loadu_si256((const __m256i*)&m_Operand[base]);
+		__m256i ac = ac_in, xr = xr_in, yr = yr_in, sr = sr_in, sp = sp_in, m = m_in;
+
+		switch (op)
+		{
+		case Operation::LDA: ac = m; sr = avx2_set_nz(sr, ac); break;
+		case Operation::LDX: xr = m; sr = avx2_set_nz(sr, xr); break;
+		case Operation::LDY: yr = m; sr = avx2_set_nz(sr, yr); break;
+		case Operation::ORA: ac = _mm256_or_si256(ac, m); sr = avx2_set_nz(sr, ac); break;
+		case Operation::AND: ac = _mm256_and_si256(ac, m); sr = avx2_set_nz(sr, ac); break;
+		case Operation::EOR: ac = _mm256_xor_si256(ac, m); sr = avx2_set_nz(sr, ac); break;
+		case Operation::ADC: ac = avx2_add(sr, ac, m); break;
+		case Operation::SBC: ac = avx2_add(sr, ac, _mm256_xor_si256(m, _mm256_set1_epi8((char)0xFF))); break;
+		case Operation::CMP: sr = avx2_compare(sr, ac, m); break;
+		case Operation::CPX: sr = avx2_compare(sr, xr, m); break;
+		case Operation::CPY: sr = avx2_compare(sr, yr, m); break;
+		case Operation::BIT:
+		{
+			const __m256i z = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(ac, m), _mm256_setzero_si256()), _mm256_set1_epi8(0x02));
+			sr = _mm256_or_si256(_mm256_and_si256(sr, _mm256_set1_epi8(0x3D)), _mm256_or_si256(_mm256_and_si256(m, _mm256_set1_epi8((char)0xC0)), z));
+			break;
+		}
+		case Operation::ASL:
+			sr = avx2_set_c(sr, avx2_bit7(m));
+			m = _mm256_add_epi8(m, m);
+			sr = avx2_set_nz(sr, m);
+			break;
+		case Operation::LSR:
+			sr = avx2_set_c(sr, _mm256_and_si256(m, one));
+			m = avx2_shr1(m);
+			sr = avx2_set_nz(sr, m);
+			break;
+		case Operation::ROL:
+		{
+			const __m256i carry = _mm256_and_si256(sr, one);
+			sr = avx2_set_c(sr, avx2_bit7(m));
+			m = _mm256_or_si256(_mm256_add_epi8(m, m), carry);
+			sr = avx2_set_nz(sr, m);
+			break;
+		}
+		case Operation::ROR:
+		{
+			const __m256i carry = _mm256_and_si256(_mm256_slli_epi16(_mm256_and_si256(sr, one), 7), _mm256_set1_epi8((char)0x80));
+			sr = avx2_set_c(sr, _mm256_and_si256(m, one));
+			m = _mm256_or_si256(avx2_shr1(m), carry);
+			sr = avx2_set_nz(sr, m);
+			break;
+		}
+		case Operation::INC: m = _mm256_add_epi8(m, one); sr = avx2_set_nz(sr, m); break;
+		case Operation::DEC: m = _mm256_sub_epi8(m, one); sr = avx2_set_nz(sr, m); break;
+		case Operation::TAX: xr = ac; sr = avx2_set_nz(sr, xr); break;
+		case Operation::TXA: ac = xr; sr = avx2_set_nz(sr, ac); break;
+		case Operation::TAY: yr = ac; sr = avx2_set_nz(sr, yr); break;
+		case Operation::TYA: ac = yr; sr = avx2_set_nz(sr, ac); break;
+		case Operation::TSX: xr = sp; sr = avx2_set_nz(sr, xr); break;
+		case Operation::TXS: sp = xr; break;
+		case Operation::INX: xr = _mm256_add_epi8(xr, one); sr = avx2_set_nz(sr, xr); break;
+		case Operation::INY: yr = _mm256_add_epi8(yr, one); sr = avx2_set_nz(sr, yr); break;
+		case Operation::DEX: xr = _mm256_sub_epi8(xr, one); sr = avx2_set_nz(sr, xr); break;
+		case Operation::DEY: yr = _mm256_sub_epi8(yr, one); sr = avx2_set_nz(sr, yr); break;
+		case Operation::CLC: sr = _mm256_and_si256(sr, _mm256_set1_epi8((char)0xFE)); break;
+		case Operation::SEC: sr = _mm256_or_si256(sr, one); break;
+		case Operation::CLV: sr = _mm256_and_si256(sr, _mm256_set1_epi8((char)0xBF)); break;
+		case Operation::CLD: sr = _mm256_and_si256(sr, _mm256_set1_epi8((char)0xF7)); break;
+		case Operation::SED: sr = _mm256_or_si256(sr, _mm256_set1_epi8(0x08)); break;
+		default: break;
+		}
+		if (accumulator) ac = m;
+
+		//Lanes outside of group keep their values
+		_mm256_storeu_si256((__m256i*)&m_AC[base], _mm256_blendv_epi8(ac_in, ac, mask));
+		_mm256_storeu_si256((__m256i*)&m_XR[base], _mm256_blendv_epi8(xr_in, xr, mask));
+		_mm256_storeu_si256((__m256i*)&m_YR[base], _mm256_blendv_epi8(yr_in, yr, mask));
+		_mm256_storeu_si256((__m256i*)&m_SR[base], _mm256_blendv_epi8(sr_in, sr, mask));
+		_mm256_storeu_si256((__m256i*)&m_SP[base], _mm256_blendv_epi8(sp_in, sp, mask));
+		_mm256_storeu_si256((__m256i*)&m_Operand[base], _mm256_blendv_epi8(m_in, m, mask));
+	}
+}
+#endif
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "NESDevice.h"
+
+//AVX2 register kernels need x86-64 host (and cpu support checked at runtime),
+// everywhere else lockstep blocks run register work lane by lane
+#if (defined(__x86_64__) || defined(_M_X64)) && (defined(__GNUC__) || defined(__clang__))
+#define NES_BATCH_AVX2
+#endif
+
+//Batch of devices running the same ROM (search, reinforcement learning, regression runs)
+// every lane is complete NESDevice (PPU, APU, cartrige and controllers stay per instance, so I/O
+// goes through regular device sync), only cpu register file is gathered into structure-of-arrays.
+// Lanes which sit at the same PC in the same PRG ROM code are stepped together: straight-line code
+// working with RAM/ROM runs for all of them at once, register and ALU work in AVX2 vectors
+// (32 lanes per vector), memory operands are gathered lane by lane. Block ends at branch/jump/return,
+// before I/O access, interrupt or anything the lockstep core doesn't handle - such instruction
+// (and every lane which diverged from the group) is executed by its own device.
+class NESBatch
+{
+public:
+	NESBatch(uint32_t lanes);
+
+	bool LoadCartrige(const std::string& file_name);
+	void Reset();
+
+	uint32_t GetLaneCount();
+	NESDevice& GetLane(uint32_t lane);
+
+	//Runs single frame on every lane (lanes with halted cpu are left alone)
+	void Update();
+
+	//Step lanes at the same PC together, register work is vectorized if host supports AVX2
+	bool LockstepEnabled;
+	bool IsAVX2Supported();
+
+	//Statistics, instructions are counted per lane
+	uint64_t LockstepInstructions;
+	uint64_t LockstepBlocks;
+
+protected:
+	enum class Operation : uint8_t
+	{
+		None,
+		LDA, LDX, LDY, STA, STX, STY,
+		ORA, AND, EOR, ADC, SBC, CMP, CPX, CPY, BIT,
+		ASL, LSR, ROL, ROR, INC, DEC,
+		TAX, TXA, TAY, TYA, TSX, TXS, INX, INY, DEX, DEY,
+		CLC, SEC, CLV, CLD, SED, NOP,
+		PHA, PHP, PLA,
+		BPL, BMI, BVC, BVS, BCC, BCS, BNE, BEQ,
+		JMP, JSR, RTS,
+	};
+	enum class OpClass : uint8_t
+	{
+		Read,		//Operand from memory or immediate
+		Store,		//Register to memory
+		Modify,		//Read-modify-write (accumulator or memory)
+		Register,	//Implied register/flag operation
+		Stack,		//PHA, PHP, PLA
+		Branch,
+		Jump,		//JMP, JSR, RTS
+	};
+	struct OpInfo
+	{
+		Operation Op = Operation::None;
+		OpClass	 Class = OpClass::Register;
+		NESCPU::AddrMode Mode = NESCPU::AddrMode::XXX;
+		uint8_t  Size = 1;
+		uint8_t  Cycles = 2;	//Base cycles
+		uint8_t  Extra = 0;		//Worst case extra cycles (page crossing, taken branch)
+	};
+
+	static const uint32_t VectorLanes = 32;
+	static const uint32_t MaxBlockInstructions = 32;
+	static const uint32_t MinLockstepLanes = 2;
+	//Instructions lane without partner runs on its own before groups are looked for again
+	static const uint32_t ScalarBurst = 64;
+
+	std::vector<std::unique_ptr<NESDevice>> m_Lanes;
+	std::vector<uint8_t*> m_RAM;
+	uint32_t m_Remaining;				//Lanes which haven't completed frame yet
+	uint32_t m_PaddedCount;
+	bool m_IsAVX2;
+	OpInfo m_OpTable[256];
+
+	//Structure of arrays (padded to VectorLanes), valid only during lockstep block
+	std::vector<uint8_t> m_AC, m_XR, m_YR, m_SR, m_SP;
+	std::vector<uint8_t> m_Operand;		//Memory operand / result of current instruction
+	std::vector<uint8_t> m_Mask;		//0xFF for lanes in group
+
+	//Per lane state (not padded)
+	std::vector<uint16_t> m_Address;
+	std::vector<uint16_t> m_NextPC;
+	std::vector<uint8_t>  m_Penalty;	//Extra cycles of current instruction
+	std::vector<uint32_t> m_Cycles;
+	std::vector<uint32_t> m_LastCycles;
+	std::vector<uint32_t> m_Budget;
+	std::vector<uint8_t>  m_IsDone;		//Frame completed (or cpu halted)
+	std::vector<uint32_t> m_Group;		//Lanes of current lockstep group
+
+	void prepare_table();
+	//Runs single instruction of lane through its device
+	void step_lane(uint32_t lane);
+
+	//Collects lanes at the same PC as 'leader' into m_Group
+	void find_group(uint32_t leader);
+	//Runs lockstep block for m_Group, false if nothing was executed
+	bool run_block();
+	//Computes (and checks) effective address of instruction for every lane in group
+	bool resolve_addresses(const OpInfo& info, const uint8_t* operand);
+	bool execute(const OpInfo& info, const uint8_t* operand, uint16_t pc);
+	//Register/ALU part of instruction on whole arrays, result of Modify ops is left in m_Operand
+	void execute_alu(Operation op, bool accumulator);
+#ifdef NES_BATCH_AVX2
+	void execute_alu_avx2(Operation op, bool accumulator);
+#endif
+	void execute_alu_scalar(Operation op, bool accumulator, uint32_t lane);
+};
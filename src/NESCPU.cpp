@@ -15,8 +15,57 @@ NESCPU::NESCPU(NESDevice* nesDevice)
 	State.CycleSkip = 0;
 	State.Halted = false;
 	State.DMATransfer = false;
+	FusedInstructions = 0;
+	m_NZResult = 0;
+	m_IsNZPending = false;
 	
 	prepare_table();
+	m_DecodeCache.resize(DecodeCacheSize);
+}
+
+inline uint8_t NESCPU::fetch_operand()
+{
+	const uint16_t index = Registers.PC - m_DecodedPC - 1;
+	if (m_Decoded != nullptr && index < 2)
+	{
+		Registers.PC++;
+		return m_Decoded->Operand[index];
+	}
+	return ReadBus(Registers.PC++);
+}
+
+const NESCPU::DecodedInstruction* NESCPU::decode_cached(uint16_t address)
+{
+	//Whole instruction has to be in the same page of readonly memory
+	if ((address & 0x03FF) > 0x03FD) return nullptr;
+	const uint8_t* source = m_NESDevicePtr->GetCPUROM(address);
+	if (source == nullptr) return nullptr;
+
+	DecodedInstruction& entry = m_DecodeCache[address & (DecodeCacheSize - 1)];
+	if (entry.Source != source)
+	{
+		entry.Source = source;
+		entry.OpCode = source[0];
+		entry.Inst = &m_InstructionLookup[source[0]];
+		entry.Operand[0] = source[1];
+		entry.Operand[1] = source[2];
+
+		//Following instruction has to be in the same page as well
+		entry.Fused = nullptr;
+		const uint8_t size = entry.Inst->Size;
+		const std::vector<Fusion>& fusions = m_Fusions[entry.OpCode];
+		if (!fusions.empty() && (address & 0x03FF) + size + 3 <= 0x0400)
+		{
+			for (const Fusion& fusion : fusions)
+			{
+				if (fusion.NextOpCode != source[size]) continue;
+				entry.Fused = &fusion;
+				entry.NextOperand[0] = source[size + 1];
+				entry.NextOperand[1] = source[size + 2];
+			}
+		}
+	}
+	return &entry;
 }
 
 void NESCPU::Reset()
@@ -26,6 +75,7 @@ void NESCPU::Reset()
 	Registers.XR = 0;
 	Registers.YR = 0;
 	Registers.SR = 0x20;
+	m_IsNZPending = false;
 	Registers.SP = 0xFD;
 
 	
@@ -45,6 +95,11 @@ void NESCPU::Reset()
 	State.CycleInternal = 0;
 	State.CycleSkip = 8;
 	State.Ready = true;
+
+	FusedInstructions = 0;
+
+	//ROM may be different
+	this->FlushDecodeCache();
 }
 
 void NESCPU::Update()
@@ -87,6 +142,7 @@ void NESCPU::Update()
 							State.LastOperations[i - 1] = State.LastOperations[i];
 						State.LastOperations[7] = Registers.PC;
 
+						m_Decoded = nullptr;
 						uint8_t opcode = ReadBus(Registers.PC++);
 						auto& inst = m_InstructionLookup[opcode];
 
@@ -151,13 +207,167 @@ void NESCPU::Update()
 	State.CyclesTotal++;
 }
 
+uint32_t NESCPU::Step(uint32_t fusion_cycles)
+{
+	if (State.Halted) return 0;
+
+	const uint32_t cycles_start = State.CyclesTotal;
+
+	//OAM DMA from plain memory - whole page is copied at once,
+	// cycles are counted same way as in Update (request cycle, alignment, 256 read/write pairs)
+	if (State.DMARequest && IsReady() && !State.DMATransfer && DMA.SkipCycle && (DMA.Address & 0x00FF) == 0)
+	{
+		const uint32_t cycles = 1 + ((State.CyclesTotal & 0x01) ? 1 : 2) + 512;
+		if (m_NESDevicePtr->OAMDMA(DMA.Address, cycles))
+		{
+			State.DMARequest = false;
+			DMA.Buffer = m_NESDevicePtr->CPUPeek(DMA.Address | 0x00FF);
+			DMA.Address += 0x0100;
+			State.CycleCounter++;
+			State.CyclesTotal += cycles;
+			return cycles;
+		}
+	}
+
+	//Not on instruction boundary (reset delay, DMA or instruction 
+	// left unfinished by per-cycle mode) - finish it cycle by cycle
+	if (!IsReady() || State.DMATransfer || State.DMARequest)
+	{
+		do
+		{
+			Update();
+		} while ((!IsReady() || State.DMATransfer) && !State.Halted);
+
+		return State.CyclesTotal - cycles_start;
+	}
+
+	State.CycleCounter = 0;
+	State.CycleInternal = 0;
+	State.Ready = false;
+
+	if (State.NMIRequest)
+	{
+		State.NMIRequest = false;
+		State.NMIActive = true;
+		execute_cycles(&NESCPU::execute_nmi);
+	}
+	else if (State.IRQRequest && !getFlag(SRFlag::InterruptBit))
+	{
+		State.IRQRequest = false;
+		State.IRQActive = true;
+		execute_cycles(&NESCPU::execute_irq);
+	}
+	else
+	{
+		for (uint32_t i = 1; i < 8; i++)
+			State.LastOperations[i - 1] = State.LastOperations[i];
+		State.LastOperations[7] = Registers.PC;
+
+		//Hot code in ROM skips fetching and decoding
+		m_DecodedPC = Registers.PC;
+		m_Decoded = decode_cached(Registers.PC);
+
+		//Nothing can happen between fused instructions (interrupt, I/O side effect) if pair fits before next event
+		if (m_Decoded != nullptr && m_Decoded->Fused != nullptr && m_Decoded->Fused->MaxCycles <= fusion_cycles)
+		{
+			if ((this->*m_Decoded->Fused->fn)() != 0)
+				return State.CyclesTotal - cycles_start;
+		}
+
+		uint8_t opcode;
+		const Instruction* inst;
+		if (m_Decoded != nullptr)
+		{
+			opcode = m_Decoded->OpCode;
+			inst = m_Decoded->Inst;
+			Registers.PC++;
+		}
+		else
+		{
+			opcode = ReadBus(Registers.PC++);
+			inst = &m_InstructionLookup[opcode];
+		}
+
+		State.CurrentOpCode = opcode;
+		State.CurrentAddrMode = inst->AddressMode;
+
+		//Opcode fetch cycle
+		State.CycleInternal++;
+		State.CycleCounter++;
+		State.CyclesTotal++;
+
+		execute_cycles(inst->fn);
+	}
+
+	//Dummy cycles queued by instruction (branches, stack operations)
+	State.CycleCounter += State.CycleSkip;
+	State.CyclesTotal += State.CycleSkip;
+	State.CycleSkip = 0;
+
+	return State.CyclesTotal - cycles_start;
+}
+
+void NESCPU::execute_cycles(bool(NESCPU::* fn)(void))
+{
+	//Same rules as in Update : handler returning true ends cpu cycle,
+	// returning false continues with next step in the same cycle
+	while (!State.Ready)
+	{
+		if ((this->*fn)())
+		{
+			State.CycleCounter++;
+			State.CyclesTotal++;
+		}
+		State.CycleInternal++;
+	}
+}
+
 bool NESCPU::IsReady()
 {
 	return State.Ready && State.CycleSkip == 0;
 }
 
+uint32_t NESCPU::DetectIdleLoop(uint16_t address)
+{
+	//Peek - detection must not touch anything
+	uint8_t opcode = m_NESDevicePtr->CPUPeek(address);
+	uint16_t operand = m_NESDevicePtr->CPUPeek(address + 1) | (m_NESDevicePtr->CPUPeek(address + 2) << 8);
+
+	// JMP *
+	if (opcode == 0x4C)
+		return (operand == address) ? 1 : 0;
+
+	//Instruction reading memory (without changing it) followed by branch back to it
+	uint16_t size;
+	switch (opcode)
+	{
+	case 0xA5: case 0xA6: case 0xA4: case 0xC5: case 0xE4: case 0xC4: case 0x24: case 0x25: // LDA, LDX, LDY, CMP, CPX, CPY, BIT, AND (zeropage)
+		size = 2;
+		operand &= 0x00FF;
+		break;
+	case 0xAD: case 0xAE: case 0xAC: case 0xCD: case 0xEC: case 0xCC: case 0x2C: case 0x2D: // Same (absolute)
+		size = 3;
+		break;
+	default:
+		return 0;
+	}
+
+	uint8_t branch = m_NESDevicePtr->CPUPeek(address + size);
+	uint8_t offset = m_NESDevicePtr->CPUPeek(address + size + 1);
+	//Any of BPL, BMI, BVC, BVS, BCC, BCS, BNE, BEQ
+	if ((branch & 0x1F) != 0x10 || (uint8_t)(offset + size + 2) != 0) return 0;
+
+	//Internal RAM changes only by interrupt handlers (or DMA)
+	if (operand <= 0x1FFF) return 2;
+	//PPUSTATUS vblank flag is set only on vblank
+	if (operand == 0x2002 && branch == 0x10) return 2;
+
+	return 0;
+}
+
 bool NESCPU::SaveState(NESState& state)
 {
+	SyncFlags();
 	state.Write(&State,		sizeof(NESCPU::State));
 	state.Write(&DMA,		sizeof(NESCPU::DMA));
 	state.Write(&Registers,	sizeof(NESCPU::Registers));
@@ -173,11 +383,45 @@ bool NESCPU::LoadState(NESState& state)
 	state.Read(&Registers,	sizeof(NESCPU::Registers));
 	state.Read(&DataBus,	sizeof(NESCPU::DataBus));
 
+	m_IsNZPending = false;
+	m_Decoded = nullptr;
 	return true;
 }
 
+void NESCPU::CloneInto(NESCPU& target)
+{
+	target.State = State;
+	target.DMA = DMA;
+	target.Registers = Registers;
+	target.DataBus = DataBus;
+	target.FusedInstructions = FusedInstructions;
+	target.m_NZResult = m_NZResult;
+	target.m_IsNZPending = m_IsNZPending;
+	//Clone happens between instructions, target keeps its own decode cache
+	target.m_Decoded = nullptr;
+}
+
+void NESCPU::FlushDecodeCache()
+{
+	m_DecodeCache.assign(DecodeCacheSize, DecodedInstruction());
+	m_Decoded = nullptr;
+}
+
+void NESCPU::SyncFlags()
+{
+	if (m_IsNZPending)
+	{
+		Registers.SR = (Registers.SR & 0x7D) | (m_NZResult & 0x80) | (m_NZResult == 0 ? 0x02 : 0x00);
+		m_IsNZPending = false;
+	}
+}
+
 void NESCPU::setFlag(SRFlag flag, bool val)
 {
+	//Pending N/Z would overwrite flag later
+	if (flag == SRFlag::NegativeBit || flag == SRFlag::ZeroBit)
+		SyncFlags();
+
 	if (val)
 		Registers.SR |= static_cast<uint8_t>(flag);
 	else
@@ -186,6 +430,11 @@ void NESCPU::setFlag(SRFlag flag, bool val)
 
 bool NESCPU::getFlag(SRFlag flag)
 {
+	if (m_IsNZPending)
+	{
+		if (flag == SRFlag::ZeroBit) return m_NZResult == 0;
+		if (flag == SRFlag::NegativeBit) return (m_NZResult & 0x80) != 0;
+	}
 	return (Registers.SR & static_cast<uint8_t>(flag));
 }
 
@@ -199,6 +448,28 @@ void NESCPU::WriteBus(uint16_t address, uint8_t byte)
 	m_NESDevicePtr->CPUWrite(address, byte);
 }
 
+size_t NESCPU::GetMemoryFootprint()
+{
+	return m_DecodeCache.capacity() * sizeof(DecodedInstruction);
+}
+
+const char* NESCPU::GetInstructionName(uint8_t opcode)
+{
+	//Table names are padded with leading space for disassembly
+	const char* name = m_InstructionLookup[opcode].Name;
+	return (name[0] == ' ') ? name + 1 : name;
+}
+
+uint8_t NESCPU::GetInstructionSize(uint8_t opcode)
+{
+	return m_InstructionLookup[opcode].Size;
+}
+
+NESCPU::AddrMode NESCPU::GetInstructionMode(uint8_t opcode)
+{
+	return m_InstructionLookup[opcode].AddressMode;
+}
+
 std::vector<std::string> NESCPU::Disassemble(uint16_t address, uint32_t count, bool include_previous)
 {
 	std::vector<std::string> listing;
@@ -267,9 +538,10 @@ std::string NESCPU::disassemble_op(uint16_t address, uint16_t* next_address)
 	return std::string(buffer);
 }
 
-bool NESCPU::execute_type_0(std::function<void(void)> op_lambda)
+template<NESCPU::AddrMode Mode, void(NESCPU::* Op)(void)>
+bool NESCPU::execute_type_0()
 {
-	switch (State.CurrentAddrMode)
+	switch (Mode)
 	{
 		//--------------------------------
 		case AddrMode::IMM:
@@ -277,8 +549,8 @@ bool NESCPU::execute_type_0(std::function<void(void)> op_lambda)
 			switch (State.CycleInternal)
 			{
 			case 1:	
-					DataBus.Data = ReadBus(Registers.PC++);	
-					op_lambda(); 
+					DataBus.Data = fetch_operand();	
+					(this->*Op)(); 
 					State.Ready = true; 
 					return true;
 			default: printf("cycle assert: %s %d\n", __FILE__, __LINE__); return true;
@@ -293,11 +565,11 @@ bool NESCPU::execute_type_0(std::function<void(void)> op_lambda)
 			switch (State.CycleInternal)
 			{
 			case 1:	
-					DataBus.Address = ReadBus(Registers.PC++);	
+					DataBus.Address = fetch_operand();	
 					return true;
 			case 2:	
 					DataBus.Data = ReadBus(DataBus.Address); 
-					op_lambda(); 
+					(this->*Op)(); 
 					State.Ready = true; 
 					return true;
 			default: printf("cycle assert: %s %d\n", __FILE__, __LINE__); return true;
@@ -309,14 +581,14 @@ bool NESCPU::execute_type_0(std::function<void(void)> op_lambda)
 			switch (State.CycleInternal)
 			{
 			case 1:	
-					DataBus.Address = ReadBus(Registers.PC++); 
+					DataBus.Address = fetch_operand(); 
 					return true;
 			case 2:	
 					DataBus.Address = (DataBus.Address + Registers.XR) & 0x00FF;
 					return true;
 			case 3:	
 					DataBus.Data = ReadBus(DataBus.Address);
-					op_lambda(); 
+					(this->*Op)(); 
 					State.Ready = true; 
 					return true;
 			default: printf("cycle assert: %s %d\n", __FILE__, __LINE__); return true;
@@ -328,14 +600,14 @@ bool NESCPU::execute_type_0(std::function<void(void)> op_lambda)
 			switch (State.CycleInternal)
 			{
 			case 1:	
-					DataBus.Address = ReadBus(Registers.PC++); 
+					DataBus.Address = fetch_operand(); 
 					return true;
 			case 2:	
 					DataBus.Address = (DataBus.Address + Registers.YR) & 0x00FF;
 					return true;
 			case 3:	
 					DataBus.Data = ReadBus(DataBus.Address);
-					op_lambda(); 
+					(this->*Op)(); 
 					State.Ready = true; 
 					return true;
 			default: printf("cycle assert: %s %d\n", __FILE__, __LINE__); return true;
@@ -347,14 +619,14 @@ bool NESCPU::execute_type_0(std::function<void(void)> op_lambda)
 			switch (State.CycleInternal)
 			{
 			case 1:	
-					DataBus.Address = ReadBus(Registers.PC++); 
+					DataBus.Address = fetch_operand(); 
 					return true;
 			case 2:	
-					DataBus.Address |= ReadBus(Registers.PC++) << 8; 
+					DataBus.Address |= fetch_operand() << 8; 
 					return true;
 			case 3:	
 					DataBus.Data = ReadBus(DataBus.Address);
-					op_lambda(); 
+					(this->*Op)(); 
 					State.Ready = true; 
 					return true;
 			default: printf("cycle assert: %s %d\n", __FILE__, __LINE__); return true;
@@ -366,16 +638,16 @@ bool NESCPU::execute_type_0(std::function<void(void)> op_lambda)
 			switch (State.CycleInternal)
 			{
 			case 1:	
-					DataBus.Address = ReadBus(Registers.PC++);	
+					DataBus.Address = fetch_operand();	
 					return true;
 			case 2:	
-					DataBus.Address |= ReadBus(Registers.PC++) << 8; 
+					DataBus.Address |= fetch_operand() << 8; 
 					return true;
 			case 3:
 					return (DataBus.Address & 0xFF00) != ((DataBus.Address + Registers.XR) & 0xFF00);
 			case 4:	
 					DataBus.Data = ReadBus(DataBus.Address + Registers.XR); 
-					op_lambda(); 
+					(this->*Op)(); 
 					State.Ready = true;  
 					return true;
 			default: printf("cycle assert: %s %d\n", __FILE__, __LINE__); return true;
@@ -386,14 +658,14 @@ bool NESCPU::execute_type_0(std::function<void(void)> op_lambda)
 			switch (State.CycleInternal)
 			{
 			case 1:	
-					DataBus.Address = ReadBus(Registers.PC++);	return true;
+					DataBus.Address = fetch_operand();	return true;
 			case 2:	
-					DataBus.Address |= ReadBus(Registers.PC++) << 8; return true;
+					DataBus.Address |= fetch_operand() << 8; return true;
 			case 3:	
 					return (DataBus.Address & 0xFF00) != ((DataBus.Address + Registers.YR) & 0xFF00);
 			case 4:	
 					DataBus.Data = ReadBus(DataBus.Address + Registers.YR); 
-					op_lambda(); 
+					(this->*Op)(); 
 					State.Ready = true; 
 					return true;
 			default: printf("cycle assert: %s %d\n", __FILE__, __LINE__); return true;
@@ -403,7 +675,7 @@ bool NESCPU::execute_type_0(std::function<void(void)> op_lambda)
 			switch (State.CycleInternal)
 			{
 			case 1:
-					DataBus.Address = ReadBus(Registers.PC++);	
+					DataBus.Address = fetch_operand();	
 					return true;
 			case 2:	
 					DataBus.Buffer = DataBus.Address + Registers.XR; 
@@ -416,7 +688,7 @@ bool NESCPU::execute_type_0(std::function<void(void)> op_lambda)
 					return true;
 			case 5:	
 					DataBus.Data = ReadBus(DataBus.Address); 
-					op_lambda(); 
+					(this->*Op)(); 
 					State.Ready = true; 
 					return true;
 			default: printf("cycle assert: %s %d\n", __FILE__, __LINE__); return true;
@@ -426,7 +698,7 @@ bool NESCPU::execute_type_0(std::function<void(void)> op_lambda)
 			switch (State.CycleInternal)
 			{
 			case 1:	
-					DataBus.Buffer = ReadBus(Registers.PC++);	
+					DataBus.Buffer = fetch_operand();	
 					return true;
 			case 2:	
 					DataBus.Address = ReadBus(DataBus.Buffer & 0x00FF);
@@ -438,7 +710,7 @@ bool NESCPU::execute_type_0(std::function<void(void)> op_lambda)
 					return (DataBus.Address & 0xFF00) != ((DataBus.Address + Registers.YR) & 0xFF00);
 			case 5:	
 					DataBus.Data = ReadBus(DataBus.Address + Registers.YR); 
-					op_lambda(); 
+					(this->*Op)(); 
 					State.Ready = true; 
 					return true;
 			default: printf("cycle assert: %s:%d\n", __FILE__, __LINE__); return true;
@@ -449,9 +721,10 @@ bool NESCPU::execute_type_0(std::function<void(void)> op_lambda)
 	return true;
 }
 
-bool NESCPU::execute_type_1(std::function<void(void)> op_lambda)
+template<NESCPU::AddrMode Mode, void(NESCPU::* Op)(void)>
+bool NESCPU::execute_type_1()
 {
-	switch (State.CurrentAddrMode)
+	switch (Mode)
 	{
 	//--------------------------------
 	case AddrMode::ACC:
@@ -460,7 +733,7 @@ bool NESCPU::execute_type_1(std::function<void(void)> op_lambda)
 		{
 		case 1:	
 				DataBus.Data = Registers.AC; 
-				op_lambda(); 
+				(this->*Op)(); 
 				Registers.AC = DataBus.Data;
 				State.Ready = true; 
 				return true;
@@ -474,13 +747,13 @@ bool NESCPU::execute_type_1(std::function<void(void)> op_lambda)
 		switch (State.CycleInternal)
 		{
 		case 1:	
-				DataBus.Address = ReadBus(Registers.PC++);	
+				DataBus.Address = fetch_operand();	
 				return true;
 		case 2:	
 				DataBus.Data = ReadBus(DataBus.Address); 
 				return true;
 		case 3: 
-				op_lambda(); 
+				(this->*Op)(); 
 				return true;
 		case 4: 
 				WriteBus(DataBus.Address, DataBus.Data); 
@@ -495,7 +768,7 @@ bool NESCPU::execute_type_1(std::function<void(void)> op_lambda)
 		switch (State.CycleInternal)
 		{
 		case 1:	
-				DataBus.Address = ReadBus(Registers.PC++);	
+				DataBus.Address = fetch_operand();	
 				return true;
 		case 2:	
 				DataBus.Address = (DataBus.Address + Registers.XR) & 0x00FF;
@@ -504,7 +777,7 @@ bool NESCPU::execute_type_1(std::function<void(void)> op_lambda)
 				DataBus.Data = ReadBus(DataBus.Address);
 				return true;
 		case 4: 
-				op_lambda(); 
+				(this->*Op)(); 
 				return true;
 		case 5: 
 				WriteBus(DataBus.Address, DataBus.Data); 
@@ -519,7 +792,7 @@ bool NESCPU::execute_type_1(std::function<void(void)> op_lambda)
 		switch (State.CycleInternal)
 		{
 		case 1:	
-				DataBus.Address = ReadBus(Registers.PC++);	
+				DataBus.Address = fetch_operand();	
 				return true;
 		case 2:	
 				DataBus.Address = (DataBus.Address + Registers.YR) & 0x00FF; 
@@ -528,7 +801,7 @@ bool NESCPU::execute_type_1(std::function<void(void)> op_lambda)
 				DataBus.Data = ReadBus(DataBus.Address);
 				return true;
 		case 4: 
-				op_lambda(); 
+				(this->*Op)(); 
 				return true;
 		case 5: 
 				WriteBus(DataBus.Address, DataBus.Data); 
@@ -543,16 +816,16 @@ bool NESCPU::execute_type_1(std::function<void(void)> op_lambda)
 		switch (State.CycleInternal)
 		{
 		case 1:	
-				DataBus.Address = ReadBus(Registers.PC++); 
+				DataBus.Address = fetch_operand(); 
 				return true;
 		case 2:	
-				DataBus.Address |= ReadBus(Registers.PC++) << 8; 
+				DataBus.Address |= fetch_operand() << 8; 
 				return true;
 		case 3:	
 				DataBus.Data = ReadBus(DataBus.Address); 
 				return true;
 		case 4: 
-				op_lambda(); 
+				(this->*Op)(); 
 				return true;
 		case 5: 
 				WriteBus(DataBus.Address, DataBus.Data); 
@@ -567,10 +840,10 @@ bool NESCPU::execute_type_1(std::function<void(void)> op_lambda)
 		switch (State.CycleInternal)
 		{
 		case 1:	
-				DataBus.Address = ReadBus(Registers.PC++); 
+				DataBus.Address = fetch_operand(); 
 				return true;
 		case 2:	
-				DataBus.Address |= ReadBus(Registers.PC++) << 8; 
+				DataBus.Address |= fetch_operand() << 8; 
 				return true;
 		case 3: 
 				DataBus.Address += Registers.XR;
@@ -579,7 +852,7 @@ bool NESCPU::execute_type_1(std::function<void(void)> op_lambda)
 				DataBus.Data = ReadBus(DataBus.Address); 
 				return true;
 		case 5: 
-				op_lambda(); 
+				(this->*Op)(); 
 				return true;
 		case 6: 
 				WriteBus(DataBus.Address, DataBus.Data); 
@@ -593,10 +866,10 @@ bool NESCPU::execute_type_1(std::function<void(void)> op_lambda)
 		switch (State.CycleInternal)
 		{
 		case 1:	
-				DataBus.Address = ReadBus(Registers.PC++); 
+				DataBus.Address = fetch_operand(); 
 				return true;
 		case 2:	
-				DataBus.Address |= ReadBus(Registers.PC++) << 8; 
+				DataBus.Address |= fetch_operand() << 8; 
 				return true;
 		case 3: 
 				DataBus.Address += Registers.YR; 
@@ -605,7 +878,7 @@ bool NESCPU::execute_type_1(std::function<void(void)> op_lambda)
 				DataBus.Data = ReadBus(DataBus.Address); 
 				return true;
 		case 5: 
-				op_lambda(); 
+				(this->*Op)(); 
 				return true;
 		case 6: 
 				WriteBus(DataBus.Address, DataBus.Data); 
@@ -618,9 +891,10 @@ bool NESCPU::execute_type_1(std::function<void(void)> op_lambda)
 	}
 }
 
-bool NESCPU::execute_type_2(std::function<void(void)> op_lambda)
+template<NESCPU::AddrMode Mode, void(NESCPU::* Op)(void)>
+bool NESCPU::execute_type_2()
 {
-	switch (State.CurrentAddrMode)
+	switch (Mode)
 	{
 		//--------------------------------
 	case AddrMode::ZPG:
@@ -628,10 +902,10 @@ bool NESCPU::execute_type_2(std::function<void(void)> op_lambda)
 		switch (State.CycleInternal)
 		{
 		case 1:
-			DataBus.Address = ReadBus(Registers.PC++);
+			DataBus.Address = fetch_operand();
 			return true;
 		case 2:
-			op_lambda();
+			(this->*Op)();
 			WriteBus(DataBus.Address, DataBus.Data);
 			State.Ready = true;
 			return true;
@@ -644,13 +918,13 @@ bool NESCPU::execute_type_2(std::function<void(void)> op_lambda)
 		switch (State.CycleInternal)
 		{
 		case 1:
-			DataBus.Address = ReadBus(Registers.PC++);
+			DataBus.Address = fetch_operand();
 			return true;
 		case 2:
 			DataBus.Address = (DataBus.Address + Registers.XR) & 0x00FF;
 			return true;
 		case 3:
-			op_lambda();
+			(this->*Op)();
 			WriteBus(DataBus.Address, DataBus.Data);
 			State.Ready = true;
 			return true;
@@ -663,13 +937,13 @@ bool NESCPU::execute_type_2(std::function<void(void)> op_lambda)
 		switch (State.CycleInternal)
 		{
 		case 1:
-			DataBus.Address = ReadBus(Registers.PC++);
+			DataBus.Address = fetch_operand();
 			return true;
 		case 2:
 			DataBus.Address = (DataBus.Address + Registers.YR) & 0x00FF;
 			return true;
 		case 3:
-			op_lambda();
+			(this->*Op)();
 			WriteBus(DataBus.Address, DataBus.Data);
 			State.Ready = true;
 			return true;
@@ -682,13 +956,13 @@ bool NESCPU::execute_type_2(std::function<void(void)> op_lambda)
 		switch (State.CycleInternal)
 		{
 		case 1:
-			DataBus.Address = ReadBus(Registers.PC++);
+			DataBus.Address = fetch_operand();
 			return true;
 		case 2:
-			DataBus.Address |= ((uint16_t)ReadBus(Registers.PC++)) << 8;
+			DataBus.Address |= ((uint16_t)fetch_operand()) << 8;
 			return true;
 		case 3:
-			op_lambda();
+			(this->*Op)();
 			WriteBus(DataBus.Address, DataBus.Data);
 			State.Ready = true;
 			return true;
@@ -701,16 +975,16 @@ bool NESCPU::execute_type_2(std::function<void(void)> op_lambda)
 		switch (State.CycleInternal)
 		{
 		case 1:
-			DataBus.Address = ReadBus(Registers.PC++);
+			DataBus.Address = fetch_operand();
 			return true;
 		case 2:
-			DataBus.Address |= ((uint16_t)ReadBus(Registers.PC++)) << 8;
+			DataBus.Address |= ((uint16_t)fetch_operand()) << 8;
 			return true;
 		case 3:
 			DataBus.Address += Registers.XR;
 			return true;
 		case 4:
-			op_lambda();
+			(this->*Op)();
 			WriteBus(DataBus.Address, DataBus.Data);
 			State.Ready = true;
 			return true;
@@ -722,16 +996,16 @@ bool NESCPU::execute_type_2(std::function<void(void)> op_lambda)
 		switch (State.CycleInternal)
 		{
 		case 1:
-			DataBus.Address = ReadBus(Registers.PC++);
+			DataBus.Address = fetch_operand();
 			return true;
 		case 2:
-			DataBus.Address |= ((uint16_t)ReadBus(Registers.PC++)) << 8;
+			DataBus.Address |= ((uint16_t)fetch_operand()) << 8;
 			return true;
 		case 3:
 			DataBus.Address += Registers.YR;
 			return true;
 		case 4:
-			op_lambda();
+			(this->*Op)();
 			WriteBus(DataBus.Address, DataBus.Data);
 			State.Ready = true;
 			return true;
@@ -742,7 +1016,7 @@ bool NESCPU::execute_type_2(std::function<void(void)> op_lambda)
 		switch (State.CycleInternal)
 		{
 		case 1:
-			DataBus.Address = ReadBus(Registers.PC++);
+			DataBus.Address = fetch_operand();
 			return true;
 		case 2:
 			DataBus.Buffer = DataBus.Address + Registers.XR;
@@ -754,7 +1028,7 @@ bool NESCPU::execute_type_2(std::function<void(void)> op_lambda)
 			DataBus.Address |= ReadBus((DataBus.Buffer + 1) & 0x00FF) << 8;
 			return true;
 		case 5:
-			op_lambda();
+			(this->*Op)();
 			WriteBus(DataBus.Address, DataBus.Data);
 			State.Ready = true;
 			return true;
@@ -765,7 +1039,7 @@ bool NESCPU::execute_type_2(std::function<void(void)> op_lambda)
 		switch (State.CycleInternal)
 		{
 		case 1:
-			DataBus.Address = ReadBus(Registers.PC++);
+			DataBus.Address = fetch_operand();
 			return true;
 		case 2:
 			DataBus.Buffer = DataBus.Address;
@@ -777,7 +1051,7 @@ bool NESCPU::execute_type_2(std::function<void(void)> op_lambda)
 			DataBus.Address |= ReadBus((DataBus.Buffer + 1) & 0x00FF) << 8;
 			return true;
 		case 5:
-			op_lambda();
+			(this->*Op)();
 			WriteBus(DataBus.Address + Registers.YR, DataBus.Data);
 			State.Ready = true;
 			return true;
@@ -808,6 +1082,7 @@ bool NESCPU::execute_irq()
 			WriteBus(0x0100 + Registers.SP--, (Registers.PC & 0x00FF));
 			return true;
 	case 2:
+			SyncFlags();
 			WriteBus(0x0100 + Registers.SP--, (Registers.SR));
 			return true;
 	case 3:
@@ -848,6 +1123,7 @@ bool NESCPU::execute_nmi()
 		WriteBus(0x0100 + Registers.SP--, (Registers.PC & 0x00FF));
 		return true;
 	case 2:
+		SyncFlags();
 		WriteBus(0x0100 + Registers.SP--, (Registers.SR));
 		return true;
 	case 3:
@@ -868,48 +1144,30 @@ bool NESCPU::execute_nmi()
 	default: printf("cycle assert: %s %d\n", __FILE__, __LINE__); return true;
 	}
 }
-bool NESCPU::execute_adc()
+void NESCPU::op_adc() // add with carry
 {
-	auto OpLambda = [this]()
-	{
-		uint16_t adc_intermediate = (uint16_t)Registers.AC + (uint16_t)DataBus.Data + (getFlag(SRFlag::CarryBit) ? 1 : 0);
-
-		setFlag(SRFlag::ZeroBit, (adc_intermediate & 0xFF) == 0);
-		setFlag(SRFlag::OverflowBit, !((Registers.AC ^ DataBus.Data) & 0x80) && ((Registers.AC ^ adc_intermediate) & 0x80));
-		setFlag(SRFlag::CarryBit, (adc_intermediate > 0xFF));
-		setFlag(SRFlag::NegativeBit, adc_intermediate & 0x80);
+	uint16_t adc_intermediate = (uint16_t)Registers.AC + (uint16_t)DataBus.Data + (getFlag(SRFlag::CarryBit) ? 1 : 0);
 
-		Registers.AC = (adc_intermediate & 0x00FF);
-	};
+	setFlag(SRFlag::OverflowBit, !((Registers.AC ^ DataBus.Data) & 0x80) && ((Registers.AC ^ adc_intermediate) & 0x80));
+	setFlag(SRFlag::CarryBit, (adc_intermediate > 0xFF));
+	set_nz((uint8_t)adc_intermediate);
 
-	return execute_type_0(OpLambda);
+	Registers.AC = (adc_intermediate & 0x00FF);
 }
-bool NESCPU::execute_and() // and (with accumulator)
+void NESCPU::op_and() // and (with accumulator)
 {
-	auto OpLambda = [this]()
-	{
-		Registers.AC &= DataBus.Data;
-		setFlag(SRFlag::ZeroBit, Registers.AC == 0);
-		setFlag(SRFlag::NegativeBit, Registers.AC & 0x80);
-	};
-
-	return execute_type_0(OpLambda);
+	Registers.AC &= DataBus.Data;
+	set_nz(Registers.AC);
 }
-bool NESCPU::execute_asl() // arithmetic shift left
+void NESCPU::op_asl() // arithmetic shift left
 {
-	auto OpLambda = [this]()
-	{
-		setFlag(SRFlag::CarryBit, (DataBus.Data & 0x80));
-		DataBus.Data = (DataBus.Data << 1);
-		setFlag(SRFlag::ZeroBit, DataBus.Data == 0);
-		setFlag(SRFlag::NegativeBit, DataBus.Data & 0x80);
-	};
-
-	return execute_type_1(OpLambda);
+	setFlag(SRFlag::CarryBit, (DataBus.Data & 0x80));
+	DataBus.Data = (DataBus.Data << 1);
+	set_nz(DataBus.Data);
 }
 bool NESCPU::execute_bcc() // branch on carry clear
 {
-	DataBus.Data = ReadBus(Registers.PC++);
+	DataBus.Data = fetch_operand();
 	if (getFlag(SRFlag::CarryBit) == false)
 	{
 		State.CycleSkip++;
@@ -923,7 +1181,7 @@ bool NESCPU::execute_bcc() // branch on carry clear
 }
 bool NESCPU::execute_bcs() // branch on carry set
 {
-	DataBus.Data = ReadBus(Registers.PC++);
+	DataBus.Data = fetch_operand();
 	if (getFlag(SRFlag::CarryBit) == true)
 	{
 		State.CycleSkip++;
@@ -937,7 +1195,7 @@ bool NESCPU::execute_bcs() // branch on carry set
 }
 bool NESCPU::execute_beq() // branch on equal (zero set)
 {
-	DataBus.Data = ReadBus(Registers.PC++);
+	DataBus.Data = fetch_operand();
 	if (getFlag(SRFlag::ZeroBit) == true)
 	{
 		State.CycleSkip++;
@@ -949,21 +1207,18 @@ bool NESCPU::execute_beq() // branch on equal (zero set)
 	State.Ready = true;
 	return true;
 }
-bool NESCPU::execute_bit() // bit test
+void NESCPU::op_bit() // bit test
 {
-	auto OpLambda = [this]()
-	{
-		uint8_t bit_intermediate = Registers.AC & DataBus.Data;
-
-		Registers.SR = (Registers.SR & 0x3F) | (DataBus.Data & 0xC0);
-		setFlag(SRFlag::ZeroBit, bit_intermediate == 0);
-	};
+	uint8_t bit_intermediate = Registers.AC & DataBus.Data;
 
-	return execute_type_0(OpLambda);
+	//N and Z are both overwritten, pending result is dropped
+	m_IsNZPending = false;
+	Registers.SR = (Registers.SR & 0x3F) | (DataBus.Data & 0xC0);
+	setFlag(SRFlag::ZeroBit, bit_intermediate == 0);
 }
 bool NESCPU::execute_bmi() // branch on minus (negative set)
 {
-	DataBus.Data = ReadBus(Registers.PC++);
+	DataBus.Data = fetch_operand();
 	if (getFlag(SRFlag::NegativeBit) == true)
 	{
 		State.CycleSkip++;
@@ -977,7 +1232,7 @@ bool NESCPU::execute_bmi() // branch on minus (negative set)
 }
 bool NESCPU::execute_bne() // branch on not equal (zero clear)
 {
-	DataBus.Data = ReadBus(Registers.PC++);
+	DataBus.Data = fetch_operand();
 	if (getFlag(SRFlag::ZeroBit) == false)
 	{
 		State.CycleSkip++;
@@ -991,7 +1246,7 @@ bool NESCPU::execute_bne() // branch on not equal (zero clear)
 }
 bool NESCPU::execute_bpl() // branch on plus (negative clear)
 {
-	DataBus.Data = ReadBus(Registers.PC++);
+	DataBus.Data = fetch_operand();
 	if (getFlag(SRFlag::NegativeBit) == false)
 	{
 		State.CycleSkip++;
@@ -1016,6 +1271,7 @@ bool NESCPU::execute_brk() // break / interrupt
 		WriteBus(0x0100 + Registers.SP--, (Registers.PC & 0x00FF));
 		return true;
 	case 4:
+		SyncFlags();
 		WriteBus(0x0100 + Registers.SP--, (Registers.SR));
 		return true;
 	case 5:
@@ -1036,7 +1292,7 @@ bool NESCPU::execute_brk() // break / interrupt
 }
 bool NESCPU::execute_bvc() // branch on overflow clear
 {
-	DataBus.Data = ReadBus(Registers.PC++);
+	DataBus.Data = fetch_operand();
 	if (getFlag(SRFlag::OverflowBit) == false)
 	{
 		State.CycleSkip++;
@@ -1050,7 +1306,7 @@ bool NESCPU::execute_bvc() // branch on overflow clear
 }
 bool NESCPU::execute_bvs() // branch on overflow set
 {
-	DataBus.Data = ReadBus(Registers.PC++);
+	DataBus.Data = fetch_operand();
 	if (getFlag(SRFlag::OverflowBit) == true)
 	{
 		State.CycleSkip++;
@@ -1086,124 +1342,87 @@ bool NESCPU::execute_clv() // clear overflow
 	State.Ready = true;
 	return true;
 }
-bool NESCPU::execute_cmp() // compare (with accumulator)
+void NESCPU::op_cmp() // compare (with accumulator)
 {
-	auto OpLambda = [this]()
-	{
-		uint16_t cmp_intermediate = (uint16_t)Registers.AC - (uint16_t)DataBus.Data;
+	uint16_t cmp_intermediate = (uint16_t)Registers.AC - (uint16_t)DataBus.Data;
 
-		setFlag(SRFlag::CarryBit, Registers.AC >= DataBus.Data);
-		setFlag(SRFlag::ZeroBit, (cmp_intermediate & 0xFF) == 0x0000);
-		setFlag(SRFlag::NegativeBit, cmp_intermediate & 0x80);
-	};
-	return execute_type_0(OpLambda);
+	setFlag(SRFlag::CarryBit, Registers.AC >= DataBus.Data);
+	set_nz((uint8_t)cmp_intermediate);
 }
-bool NESCPU::execute_cpx() // compare with x
+void NESCPU::op_cpx() // compare with x
 {
-	auto OpLambda = [this]()
-	{
-		uint16_t cmp_intermediate = (uint16_t)Registers.XR - (uint16_t)DataBus.Data;
+	uint16_t cmp_intermediate = (uint16_t)Registers.XR - (uint16_t)DataBus.Data;
 
-		setFlag(SRFlag::CarryBit, Registers.XR >= DataBus.Data);
-		setFlag(SRFlag::ZeroBit, (cmp_intermediate & 0xFF) == 0x0000);
-		setFlag(SRFlag::NegativeBit, cmp_intermediate & 0x80);
-	};
-
-	return execute_type_0(OpLambda);
+	setFlag(SRFlag::CarryBit, Registers.XR >= DataBus.Data);
+	set_nz((uint8_t)cmp_intermediate);
 }
-bool NESCPU::execute_cpy() // compare with y
+void NESCPU::op_cpy() // compare with y
 {
-	auto OpLambda = [this]()
-	{
-		uint16_t cmp_intermediate = (uint16_t)Registers.YR - (uint16_t)DataBus.Data;
+	uint16_t cmp_intermediate = (uint16_t)Registers.YR - (uint16_t)DataBus.Data;
 
-		setFlag(SRFlag::CarryBit, Registers.YR >= DataBus.Data);
-		setFlag(SRFlag::ZeroBit, (cmp_intermediate & 0xFF) == 0x0000);
-		setFlag(SRFlag::NegativeBit, cmp_intermediate & 0x80);
-	};
-
-	return execute_type_0(OpLambda);
+	setFlag(SRFlag::CarryBit, Registers.YR >= DataBus.Data);
+	set_nz((uint8_t)cmp_intermediate);
 }
-bool NESCPU::execute_dec() // decrement
+void NESCPU::op_dec() // decrement
 {
-	auto OpLambda = [this]()
-	{
-		DataBus.Data--;
+	DataBus.Data--;
 
-		setFlag(SRFlag::ZeroBit, DataBus.Data == 0);
-		setFlag(SRFlag::NegativeBit, DataBus.Data & 0x80);
-	};
-
-	return execute_type_1(OpLambda);
+	set_nz(DataBus.Data);
 }
 bool NESCPU::execute_dex() // decrement x
 {
 	Registers.XR--;
-	setFlag(SRFlag::ZeroBit, Registers.XR == 0);
-	setFlag(SRFlag::NegativeBit, Registers.XR & 0x80);
+	set_nz(Registers.XR);
 	State.Ready = true;
 	return true;
 }
 bool NESCPU::execute_dey() // decrement y
 {
 	Registers.YR--;
-	setFlag(SRFlag::ZeroBit, Registers.YR == 0);
-	setFlag(SRFlag::NegativeBit, Registers.YR & 0x80);
+	set_nz(Registers.YR);
 	State.Ready = true;
 	return true;
 }
-bool NESCPU::execute_eor() // exclusive or (with accumulator)
+void NESCPU::op_eor() // exclusive or (with accumulator)
 {
-	auto OpLambda = [this]()
-	{
-		Registers.AC ^= DataBus.Data;
+	Registers.AC ^= DataBus.Data;
 
-		setFlag(SRFlag::ZeroBit, Registers.AC == 0);
-		setFlag(SRFlag::NegativeBit, Registers.AC & 0x80);
-	};
-	return execute_type_0(OpLambda);
+	set_nz(Registers.AC);
 }
-bool NESCPU::execute_inc() // increment
+void NESCPU::op_inc() // increment
 {
-	auto OpLambda = [this]()
-	{
-		DataBus.Data++;
-	
-		setFlag(SRFlag::ZeroBit, DataBus.Data == 0);
-		setFlag(SRFlag::NegativeBit, DataBus.Data & 0x80);
-	};
+	DataBus.Data++;
 
-	return execute_type_1(OpLambda);
+	set_nz(DataBus.Data);
 }
 bool NESCPU::execute_inx() // increment x
 {
 	Registers.XR++;
-	setFlag(SRFlag::ZeroBit, Registers.XR == 0);
-	setFlag(SRFlag::NegativeBit, Registers.XR & 0x80);
+	set_nz(Registers.XR);
 	State.Ready = true;
 	return true;
 }
 bool NESCPU::execute_iny() // increment y
 {
 	Registers.YR++;
-	setFlag(SRFlag::ZeroBit, Registers.YR == 0);
-	setFlag(SRFlag::NegativeBit, Registers.YR & 0x80);
+	set_nz(Registers.YR);
 	State.Ready = true;
 	return true;
 }
+template<NESCPU::AddrMode Mode>
 bool NESCPU::execute_jmp() // jump
 {
-	switch (State.CurrentAddrMode)
+	switch (Mode)
 	{
 		case AddrMode::ABS:
 		{
 			switch (State.CycleInternal)
 			{
 				case 1:	
-					DataBus.Address = ReadBus(Registers.PC++); 
+					DataBus.Address = fetch_operand(); 
 					return true;
 				case 2:	
-					DataBus.Address |= ReadBus(Registers.PC++) << 8; 
+					DataBus.Address |= fetch_operand() << 8; 
 					Registers.PC = DataBus.Address;
 					State.Ready = true;
 					return true;
@@ -1215,10 +1434,10 @@ bool NESCPU::execute_jmp() // jump
 			switch (State.CycleInternal)
 			{
 			case 1:
-				DataBus.Buffer = ReadBus(Registers.PC++);
+				DataBus.Buffer = fetch_operand();
 				return true;
 			case 2:
-				DataBus.Buffer |= ReadBus(Registers.PC++) << 8;
+				DataBus.Buffer |= fetch_operand() << 8;
 				return true;
 			case 3:
 				DataBus.Address = ReadBus(DataBus.Buffer);
@@ -1250,10 +1469,10 @@ bool NESCPU::execute_jsr() // jump subroutine
 		WriteBus(0x0100 + Registers.SP--, (Registers.PC+1) & 0x00FF);
 		return true;
 	case 3:
-		DataBus.Address = ReadBus(Registers.PC++);
+		DataBus.Address = fetch_operand();
 		return true;
 	case 4:
-		DataBus.Address |= ReadBus(Registers.PC++) << 8;
+		DataBus.Address |= fetch_operand() << 8;
 		return true;
 	case 5:
 		Registers.PC = DataBus.Address;
@@ -1261,62 +1480,36 @@ bool NESCPU::execute_jsr() // jump subroutine
 		return true;
 	}
 }
-bool NESCPU::execute_lda() // load accumulator
+void NESCPU::op_lda() // load accumulator
 {
-	auto OpLambda = [this]()
-	{
-		Registers.AC = DataBus.Data;
-		setFlag(SRFlag::ZeroBit, Registers.AC == 0);
-		setFlag(SRFlag::NegativeBit, Registers.AC & 0x80);
-	};
-	return execute_type_0(OpLambda);
+	Registers.AC = DataBus.Data;
+	set_nz(Registers.AC);
 }
-bool NESCPU::execute_ldx() // load x
+void NESCPU::op_ldx() // load x
 {
-	auto OpLambda = [this]()
-	{
-		Registers.XR = DataBus.Data;
-		setFlag(SRFlag::ZeroBit, Registers.XR == 0);
-		setFlag(SRFlag::NegativeBit, Registers.XR & 0x80);
-	};
-	return execute_type_0(OpLambda);
+	Registers.XR = DataBus.Data;
+	set_nz(Registers.XR);
 }
-bool NESCPU::execute_ldy() // load y
+void NESCPU::op_ldy() // load y
 {
-	auto OpLambda = [this]()
-	{
-		Registers.YR = DataBus.Data;
-		setFlag(SRFlag::ZeroBit, Registers.YR == 0);
-		setFlag(SRFlag::NegativeBit, Registers.YR & 0x80);
-	};
-	return execute_type_0(OpLambda);
+	Registers.YR = DataBus.Data;
+	set_nz(Registers.YR);
 }
-bool NESCPU::execute_lsr() // logical shift right
+void NESCPU::op_lsr() // logical shift right
 {
-	auto OpLambda = [this]()
-	{
-		setFlag(SRFlag::CarryBit, (DataBus.Data & 0x01));
-		DataBus.Data = (DataBus.Data >> 1);
-		setFlag(SRFlag::ZeroBit, DataBus.Data == 0);
-		setFlag(SRFlag::NegativeBit, false);
-	};
-
-	return execute_type_1(OpLambda);
+	setFlag(SRFlag::CarryBit, (DataBus.Data & 0x01));
+	DataBus.Data = (DataBus.Data >> 1);
+	set_nz(DataBus.Data);
 }
 bool NESCPU::execute_nop() // no operation
 {
 	State.Ready = true;
 	return true;
 }
-bool NESCPU::execute_ora() // or with accumulator
+void NESCPU::op_ora() // or with accumulator
 {
-	auto OpLambda = [this]()
-	{
-		Registers.AC |= DataBus.Data;
-		setFlag(SRFlag::ZeroBit, Registers.AC == 0);
-		setFlag(SRFlag::NegativeBit, Registers.AC & 0x80);
-	};
-	return execute_type_0(OpLambda);
+	Registers.AC |= DataBus.Data;
+	set_nz(Registers.AC);
 }
 bool NESCPU::execute_pha() // push accumulator
 {
@@ -1327,6 +1520,7 @@ bool NESCPU::execute_pha() // push accumulator
 }
 bool NESCPU::execute_php() // push processor status (sr)
 {
+	SyncFlags();
 	WriteBus(0x0100 + Registers.SP--, Registers.SR | 0x20);
 	State.CycleSkip++;
 	State.Ready = true;
@@ -1336,8 +1530,7 @@ bool NESCPU::execute_pla() // pull accumulator
 {
 	Registers.AC = ReadBus(0x0100 + (++Registers.SP));
 
-	setFlag(SRFlag::ZeroBit, Registers.AC == 0);
-	setFlag(SRFlag::NegativeBit, Registers.AC & 0x80);
+	set_nz(Registers.AC);
 
 	State.CycleSkip += 2;
 	State.Ready = true;
@@ -1347,39 +1540,28 @@ bool NESCPU::execute_pla() // pull accumulator
 bool NESCPU::execute_plp() // pull processor status (sr)
 {
 	Registers.SR = ReadBus(0x0100 + (++Registers.SP));
+	m_IsNZPending = false;
 
 	State.CycleSkip += 2;
 	State.Ready = true;
 	return true;
 	
 }
-bool NESCPU::execute_rol() // rotate left
+void NESCPU::op_rol() // rotate left
 {
-	auto OpLambda = [this]()
-	{
-		uint16_t rol_intermediate = DataBus.Data << 1 | (getFlag(SRFlag::CarryBit) ? 0x01 : 0x00);
-		DataBus.Data = (rol_intermediate & 0x00FF);
-
-		setFlag(SRFlag::CarryBit, rol_intermediate & 0xFF00);
-		setFlag(SRFlag::ZeroBit, DataBus.Data == 0);
-		setFlag(SRFlag::NegativeBit, DataBus.Data & 0x80);
-	};
+	uint16_t rol_intermediate = DataBus.Data << 1 | (getFlag(SRFlag::CarryBit) ? 0x01 : 0x00);
+	DataBus.Data = (rol_intermediate & 0x00FF);
 
-	return execute_type_1(OpLambda);
+	setFlag(SRFlag::CarryBit, rol_intermediate & 0xFF00);
+	set_nz(DataBus.Data);
 }
-bool NESCPU::execute_ror() // rotate right
+void NESCPU::op_ror() // rotate right
 {
-	auto OpLambda = [this]()
-	{
-		uint16_t ror_intermediate = DataBus.Data >> 1 | (getFlag(SRFlag::CarryBit) ? 0x80 : 0x00);
-		setFlag(SRFlag::CarryBit, (DataBus.Data & 0x01));
-		DataBus.Data = (ror_intermediate & 0x00FF);
-
-		setFlag(SRFlag::ZeroBit, DataBus.Data == 0);
-		setFlag(SRFlag::NegativeBit, DataBus.Data & 0x80);
-	};
+	uint16_t ror_intermediate = DataBus.Data >> 1 | (getFlag(SRFlag::CarryBit) ? 0x80 : 0x00);
+	setFlag(SRFlag::CarryBit, (DataBus.Data & 0x01));
+	DataBus.Data = (ror_intermediate & 0x00FF);
 
-	return execute_type_1(OpLambda);
+	set_nz(DataBus.Data);
 }
 bool NESCPU::execute_rti() // return from interrupt
 {
@@ -1387,6 +1569,7 @@ bool NESCPU::execute_rti() // return from interrupt
 	{
 	case 1:
 			Registers.SR = ReadBus(0x0100 + (++Registers.SP));
+			m_IsNZPending = false;
 			return true;
 	case 2:
 			DataBus.Address = (uint16_t)ReadBus(0x0100 + (++Registers.SP));
@@ -1427,22 +1610,16 @@ bool NESCPU::execute_rts() // return from subroutine
 	}
 	return true;
 }
-bool NESCPU::execute_sbc() // subtract with carry
+void NESCPU::op_sbc() // subtract with carry
 {
-	auto OpLambda = [this]()
-	{
-		uint16_t sbc_xored = ((uint16_t)DataBus.Data) ^ 0x00FF;
-		uint16_t sbc_intermediate = ((uint16_t)Registers.AC + (uint16_t)sbc_xored) + (getFlag(SRFlag::CarryBit) ? 1 : 0);
-
-		setFlag(SRFlag::ZeroBit, (sbc_intermediate & 0xFF) == 0);
-		setFlag(SRFlag::NegativeBit, sbc_intermediate & 0x80);
-		setFlag(SRFlag::OverflowBit, (sbc_intermediate ^ (uint16_t)Registers.AC) & (sbc_intermediate ^ sbc_xored) & 0x80);
-		setFlag(SRFlag::CarryBit, sbc_intermediate & 0xFF00);
+	uint16_t sbc_xored = ((uint16_t)DataBus.Data) ^ 0x00FF;
+	uint16_t sbc_intermediate = ((uint16_t)Registers.AC + (uint16_t)sbc_xored) + (getFlag(SRFlag::CarryBit) ? 1 : 0);
 
-		Registers.AC = (sbc_intermediate & 0x00FF);
-	};
+	set_nz((uint8_t)sbc_intermediate);
+	setFlag(SRFlag::OverflowBit, (sbc_intermediate ^ (uint16_t)Registers.AC) & (sbc_intermediate ^ sbc_xored) & 0x80);
+	setFlag(SRFlag::CarryBit, sbc_intermediate & 0xFF00);
 
-	return execute_type_0(OpLambda);
+	Registers.AC = (sbc_intermediate & 0x00FF);
 }
 bool NESCPU::execute_sec() // set carry
 {
@@ -1462,63 +1639,43 @@ bool NESCPU::execute_sei() // set interrupt disable
 	State.Ready = true;
 	return true;
 }
-bool NESCPU::execute_sta() // store accumulator
+void NESCPU::op_sta() // store accumulator
 {
-	auto OpLambda = [this]()
-	{
-		DataBus.Data = Registers.AC;
-	};
-
-	return execute_type_2(OpLambda);
-	
+	DataBus.Data = Registers.AC;
 }
-bool NESCPU::execute_stx() // store x
+void NESCPU::op_stx() // store x
 {
-	auto OpLambda = [this]()
-	{
-		DataBus.Data = Registers.XR;
-	};
-
-	return execute_type_2(OpLambda);
+	DataBus.Data = Registers.XR;
 }
-bool NESCPU::execute_sty() // store y
+void NESCPU::op_sty() // store y
 {
-	auto OpLambda = [this]()
-	{
-		DataBus.Data = Registers.YR;
-	};
-
-	return execute_type_2(OpLambda);
+	DataBus.Data = Registers.YR;
 }
 bool NESCPU::execute_tax() // transfer accumulator to x
 {
 	Registers.XR = Registers.AC;
-	setFlag(SRFlag::ZeroBit, Registers.XR == 0);
-	setFlag(SRFlag::NegativeBit, Registers.XR & 0x80);
+	set_nz(Registers.XR);
 	State.Ready = true;
 	return true;
 }
 bool NESCPU::execute_tay() // transfer accumulator to y
 {
 	Registers.YR = Registers.AC;
-	setFlag(SRFlag::ZeroBit, Registers.YR == 0);
-	setFlag(SRFlag::NegativeBit, Registers.YR & 0x80);
+	set_nz(Registers.YR);
 	State.Ready = true;
 	return true;
 }
 bool NESCPU::execute_tsx() // transfer stack pointer to x
 {
 	Registers.XR = Registers.SP;
-	setFlag(SRFlag::ZeroBit, Registers.XR == 0);
-	setFlag(SRFlag::NegativeBit, Registers.XR & 0x80);
+	set_nz(Registers.XR);
 	State.Ready = true;
 	return true;
 }
 bool NESCPU::execute_txa() // transfer x to accumulator
 {
 	Registers.AC = Registers.XR;
-	setFlag(SRFlag::ZeroBit, Registers.AC == 0);
-	setFlag(SRFlag::NegativeBit, Registers.AC & 0x80);
+	set_nz(Registers.AC);
 	State.Ready = true;
 	return true;
 }
@@ -1531,8 +1688,7 @@ bool NESCPU::execute_txs() // transfer x to stack pointer
 bool NESCPU::execute_tya() // transfer y to accumulator 
 {
 	Registers.AC = Registers.YR;
-	setFlag(SRFlag::ZeroBit, Registers.AC == 0);
-	setFlag(SRFlag::NegativeBit, Registers.AC & 0x80);
+	set_nz(Registers.AC);
 	State.Ready = true;
 	return true;
 }
@@ -1545,268 +1701,376 @@ bool NESCPU::execute_xxx() // halt
 	return true;
 }
 
+template<NESCPU::AddrMode LoadMode, NESCPU::AddrMode StoreMode>
+uint32_t NESCPU::fused_lda_sta()
+{
+	const uint8_t* load_operand = m_Decoded->Operand;
+	const uint8_t* store_operand = m_Decoded->NextOperand;
+	const uint16_t load = (LoadMode == AddrMode::ABS) ? (load_operand[0] | (load_operand[1] << 8)) : load_operand[0];
+	const uint16_t store = (StoreMode == AddrMode::ABS) ? (store_operand[0] | (store_operand[1] << 8)) : store_operand[0];
+
+	//Internal RAM only, anything else has to be accessed at exact cycle
+	if ((LoadMode == AddrMode::ABS && load > 0x1FFF) || (StoreMode == AddrMode::ABS && store > 0x1FFF))
+		return 0;
+
+	DataBus.Data = (LoadMode == AddrMode::IMM) ? load_operand[0] : ReadBus(load);
+	op_lda();
+	WriteBus(store, Registers.AC);
+
+	const uint32_t load_size = (LoadMode == AddrMode::ABS) ? 3 : 2;
+	const uint32_t store_size = (StoreMode == AddrMode::ABS) ? 3 : 2;
+	const uint32_t load_cycles = (LoadMode == AddrMode::IMM) ? 2 : (LoadMode == AddrMode::ZPG) ? 3 : 4;
+	const uint32_t store_cycles = (StoreMode == AddrMode::ZPG) ? 3 : 4;
+	return complete_fused(load_cycles, store_cycles, m_DecodedPC + load_size + store_size);
+}
+
+template<bool IsY>
+uint32_t NESCPU::fused_dec_bne()
+{
+	uint8_t& counter = IsY ? Registers.YR : Registers.XR;
+	counter--;
+	set_nz(counter);
+
+	const uint16_t next_pc = m_DecodedPC + 3;
+	if (counter == 0)
+		return complete_fused(2, 2, next_pc);
+
+	const uint16_t target = next_pc + static_cast<int8_t>(m_Decoded->NextOperand[0]);
+	return complete_fused(2, ((next_pc & 0xFF00) != (target & 0xFF00)) ? 4 : 3, target);
+}
+
+uint32_t NESCPU::fused_inc_lda()
+{
+	DataBus.Data = ReadBus(m_Decoded->Operand[0]);
+	op_inc();
+	WriteBus(m_Decoded->Operand[0], DataBus.Data);
+
+	DataBus.Data = ReadBus(m_Decoded->NextOperand[0]);
+	op_lda();
+	return complete_fused(5, 3, m_DecodedPC + 4);
+}
+
+template<NESCPU::AddrMode Mode, bool IsEqual>
+uint32_t NESCPU::fused_cmp_branch()
+{
+	DataBus.Data = (Mode == AddrMode::IMM) ? m_Decoded->Operand[0] : ReadBus(m_Decoded->Operand[0]);
+	op_cmp();
+
+	const uint32_t cmp_cycles = (Mode == AddrMode::IMM) ? 2 : 3;
+	const uint16_t next_pc = m_DecodedPC + 4;
+	if (getFlag(SRFlag::ZeroBit) != IsEqual)
+		return complete_fused(cmp_cycles, 2, next_pc);
+
+	const uint16_t target = next_pc + static_cast<int8_t>(m_Decoded->NextOperand[0]);
+	return complete_fused(cmp_cycles, ((next_pc & 0xFF00) != (target & 0xFF00)) ? 4 : 3, target);
+}
+
+uint32_t NESCPU::complete_fused(uint32_t first_cycles, uint32_t second_cycles, uint16_t next_pc)
+{
+	//First instruction is already in LastOperations (see Step)
+	for (uint32_t i = 1; i < 8; i++)
+		State.LastOperations[i - 1] = State.LastOperations[i];
+	State.LastOperations[7] = m_DecodedPC + m_Decoded->Inst->Size;
+
+	const uint8_t next_opcode = m_Decoded->Fused->NextOpCode;
+	State.CurrentOpCode = next_opcode;
+	State.CurrentAddrMode = m_InstructionLookup[next_opcode].AddressMode;
+	State.CycleCounter = (uint8_t)second_cycles;
+	State.CyclesTotal += first_cycles + second_cycles;
+	State.Ready = true;
+
+	Registers.PC = next_pc;
+	m_Decoded = nullptr;
+	FusedInstructions += 2;
+	return first_cycles + second_cycles;
+}
+
 void NESCPU::prepare_table()
 {
 	using am = State::AddrMode;
 	//Setup lookup table
 	m_InstructionLookup = {
 		{" BRK\0", 1, am::IMP, &NESCPU::execute_brk }, // 0x00 : BRK impl
-		{" ORA\0", 2, am::XIN, &NESCPU::execute_ora }, // 0x01 : ORA X,ind
+		{" ORA\0", 2, am::XIN, &NESCPU::execute_type_0<am::XIN, &NESCPU::op_ora> }, // 0x01 : ORA X,ind
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x02 : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x03 : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x04 : ???
-		{" ORA\0", 2, am::ZPG, &NESCPU::execute_ora }, // 0x05 : ORA zpg
-		{" ASL\0", 2, am::ZPG, &NESCPU::execute_asl }, // 0x06 : ASL zpg
+		{" ORA\0", 2, am::ZPG, &NESCPU::execute_type_0<am::ZPG, &NESCPU::op_ora> }, // 0x05 : ORA zpg
+		{" ASL\0", 2, am::ZPG, &NESCPU::execute_type_1<am::ZPG, &NESCPU::op_asl> }, // 0x06 : ASL zpg
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x07 : ???
 		{" PHP\0", 1, am::IMP, &NESCPU::execute_php }, // 0x08 : PHP impl
-		{" ORA\0", 2, am::IMM, &NESCPU::execute_ora }, // 0x09 : ORA #
-		{" ASL\0", 1, am::ACC, &NESCPU::execute_asl }, // 0x0a : ASL A
+		{" ORA\0", 2, am::IMM, &NESCPU::execute_type_0<am::IMM, &NESCPU::op_ora> }, // 0x09 : ORA #
+		{" ASL\0", 1, am::ACC, &NESCPU::execute_type_1<am::ACC, &NESCPU::op_asl> }, // 0x0a : ASL A
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x0b : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x0c : ???
-		{" ORA\0", 3, am::ABS, &NESCPU::execute_ora }, // 0x0d : ORA abs
-		{" ASL\0", 3, am::ABS, &NESCPU::execute_asl }, // 0x0e : ASL abs
+		{" ORA\0", 3, am::ABS, &NESCPU::execute_type_0<am::ABS, &NESCPU::op_ora> }, // 0x0d : ORA abs
+		{" ASL\0", 3, am::ABS, &NESCPU::execute_type_1<am::ABS, &NESCPU::op_asl> }, // 0x0e : ASL abs
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x0f : ???
 		{" BPL\0", 2, am::REL, &NESCPU::execute_bpl }, // 0x10 : BPL rel
-		{" ORA\0", 2, am::INY, &NESCPU::execute_ora }, // 0x11 : ORA ind,Y
+		{" ORA\0", 2, am::INY, &NESCPU::execute_type_0<am::INY, &NESCPU::op_ora> }, // 0x11 : ORA ind,Y
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x12 : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x13 : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x14 : ???
-		{" ORA\0", 2, am::ZPX, &NESCPU::execute_ora }, // 0x15 : ORA zpg,X
-		{" ASL\0", 2, am::ZPX, &NESCPU::execute_asl }, // 0x16 : ASL zpg,X
+		{" ORA\0", 2, am::ZPX, &NESCPU::execute_type_0<am::ZPX, &NESCPU::op_ora> }, // 0x15 : ORA zpg,X
+		{" ASL\0", 2, am::ZPX, &NESCPU::execute_type_1<am::ZPX, &NESCPU::op_asl> }, // 0x16 : ASL zpg,X
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x17 : ???
 		{" CLC\0", 1, am::IMP, &NESCPU::execute_clc }, // 0x18 : CLC impl
-		{" ORA\0", 3, am::ABY, &NESCPU::execute_ora }, // 0x19 : ORA abs,Y
+		{" ORA\0", 3, am::ABY, &NESCPU::execute_type_0<am::ABY, &NESCPU::op_ora> }, // 0x19 : ORA abs,Y
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x1a : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x1b : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x1c : ???
-		{" ORA\0", 3, am::ABX, &NESCPU::execute_ora }, // 0x1d : ORA abs,X
-		{" ASL\0", 3, am::ABX, &NESCPU::execute_asl }, // 0x1e : ASL abs,X
+		{" ORA\0", 3, am::ABX, &NESCPU::execute_type_0<am::ABX, &NESCPU::op_ora> }, // 0x1d : ORA abs,X
+		{" ASL\0", 3, am::ABX, &NESCPU::execute_type_1<am::ABX, &NESCPU::op_asl> }, // 0x1e : ASL abs,X
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x1f : ???
 		{" JSR\0", 3, am::ABS, &NESCPU::execute_jsr }, // 0x20 : JSR abs
-		{" AND\0", 2, am::XIN, &NESCPU::execute_and }, // 0x21 : AND X,ind
+		{" AND\0", 2, am::XIN, &NESCPU::execute_type_0<am::XIN, &NESCPU::op_and> }, // 0x21 : AND X,ind
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x22 : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x23 : ???
-		{" BIT\0", 2, am::ZPG, &NESCPU::execute_bit }, // 0x24 : BIT zpg
-		{" AND\0", 2, am::ZPG, &NESCPU::execute_and }, // 0x25 : AND zpg
-		{" ROL\0", 2, am::ZPG, &NESCPU::execute_rol }, // 0x26 : ROL zpg
+		{" BIT\0", 2, am::ZPG, &NESCPU::execute_type_0<am::ZPG, &NESCPU::op_bit> }, // 0x24 : BIT zpg
+		{" AND\0", 2, am::ZPG, &NESCPU::execute_type_0<am::ZPG, &NESCPU::op_and> }, // 0x25 : AND zpg
+		{" ROL\0", 2, am::ZPG, &NESCPU::execute_type_1<am::ZPG, &NESCPU::op_rol> }, // 0x26 : ROL zpg
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x27 : ???
 		{" PLP\0", 1, am::IMP, &NESCPU::execute_plp }, // 0x28 : PLP impl
-		{" AND\0", 2, am::IMM, &NESCPU::execute_and }, // 0x29 : AND #
-		{" ROL\0", 1, am::ACC, &NESCPU::execute_rol }, // 0x2a : ROL A
+		{" AND\0", 2, am::IMM, &NESCPU::execute_type_0<am::IMM, &NESCPU::op_and> }, // 0x29 : AND #
+		{" ROL\0", 1, am::ACC, &NESCPU::execute_type_1<am::ACC, &NESCPU::op_rol> }, // 0x2a : ROL A
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x2b : ???
-		{" BIT\0", 3, am::ABS, &NESCPU::execute_bit }, // 0x2c : BIT abs
-		{" AND\0", 3, am::ABS, &NESCPU::execute_and }, // 0x2d : AND abs
-		{" ROL\0", 3, am::ABS, &NESCPU::execute_rol }, // 0x2e : ROL abs
+		{" BIT\0", 3, am::ABS, &NESCPU::execute_type_0<am::ABS, &NESCPU::op_bit> }, // 0x2c : BIT abs
+		{" AND\0", 3, am::ABS, &NESCPU::execute_type_0<am::ABS, &NESCPU::op_and> }, // 0x2d : AND abs
+		{" ROL\0", 3, am::ABS, &NESCPU::execute_type_1<am::ABS, &NESCPU::op_rol> }, // 0x2e : ROL abs
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x2f : ???
 		{" BMI\0", 2, am::REL, &NESCPU::execute_bmi }, // 0x30 : BMI rel
-		{" AND\0", 2, am::INY, &NESCPU::execute_and }, // 0x31 : AND ind,Y
+		{" AND\0", 2, am::INY, &NESCPU::execute_type_0<am::INY, &NESCPU::op_and> }, // 0x31 : AND ind,Y
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x32 : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x33 : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x34 : ???
-		{" AND\0", 2, am::ZPX, &NESCPU::execute_and }, // 0x35 : AND zpg,X
-		{" ROL\0", 2, am::ZPX, &NESCPU::execute_rol }, // 0x36 : ROL zpg,X
+		{" AND\0", 2, am::ZPX, &NESCPU::execute_type_0<am::ZPX, &NESCPU::op_and> }, // 0x35 : AND zpg,X
+		{" ROL\0", 2, am::ZPX, &NESCPU::execute_type_1<am::ZPX, &NESCPU::op_rol> }, // 0x36 : ROL zpg,X
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x37 : ???
 		{" SEC\0", 1, am::IMP, &NESCPU::execute_sec }, // 0x38 : SEC impl
-		{" AND\0", 3, am::ABY, &NESCPU::execute_and }, // 0x39 : AND abs,Y
+		{" AND\0", 3, am::ABY, &NESCPU::execute_type_0<am::ABY, &NESCPU::op_and> }, // 0x39 : AND abs,Y
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x3a : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x3b : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x3c : ???
-		{" AND\0", 3, am::ABX, &NESCPU::execute_and }, // 0x3d : AND abs,X
-		{" ROL\0", 3, am::ABX, &NESCPU::execute_rol }, // 0x3e : ROL abs,X
+		{" AND\0", 3, am::ABX, &NESCPU::execute_type_0<am::ABX, &NESCPU::op_and> }, // 0x3d : AND abs,X
+		{" ROL\0", 3, am::ABX, &NESCPU::execute_type_1<am::ABX, &NESCPU::op_rol> }, // 0x3e : ROL abs,X
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x3f : ???
 		{" RTI\0", 1, am::IMP, &NESCPU::execute_rti }, // 0x40 : RTI impl
-		{" EOR\0", 2, am::XIN, &NESCPU::execute_eor }, // 0x41 : EOR X,ind
+		{" EOR\0", 2, am::XIN, &NESCPU::execute_type_0<am::XIN, &NESCPU::op_eor> }, // 0x41 : EOR X,ind
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x42 : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x43 : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x44 : ???
-		{" EOR\0", 2, am::ZPG, &NESCPU::execute_eor }, // 0x45 : EOR zpg
-		{" LSR\0", 2, am::ZPG, &NESCPU::execute_lsr }, // 0x46 : LSR zpg
+		{" EOR\0", 2, am::ZPG, &NESCPU::execute_type_0<am::ZPG, &NESCPU::op_eor> }, // 0x45 : EOR zpg
+		{" LSR\0", 2, am::ZPG, &NESCPU::execute_type_1<am::ZPG, &NESCPU::op_lsr> }, // 0x46 : LSR zpg
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x47 : ???
 		{" PHA\0", 1, am::IMP, &NESCPU::execute_pha }, // 0x48 : PHA impl
-		{" EOR\0", 2, am::IMM, &NESCPU::execute_eor }, // 0x49 : EOR #
-		{" LSR\0", 1, am::ACC, &NESCPU::execute_lsr }, // 0x4a : LSR A
+		{" EOR\0", 2, am::IMM, &NESCPU::execute_type_0<am::IMM, &NESCPU::op_eor> }, // 0x49 : EOR #
+		{" LSR\0", 1, am::ACC, &NESCPU::execute_type_1<am::ACC, &NESCPU::op_lsr> }, // 0x4a : LSR A
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x4b : ???
-		{" JMP\0", 3, am::ABS, &NESCPU::execute_jmp }, // 0x4c : JMP abs
-		{" EOR\0", 3, am::ABS, &NESCPU::execute_eor }, // 0x4d : EOR abs
-		{" LSR\0", 3, am::ABS, &NESCPU::execute_lsr }, // 0x4e : LSR abs
+		{" JMP\0", 3, am::ABS, &NESCPU::execute_jmp<am::ABS> }, // 0x4c : JMP abs
+		{" EOR\0", 3, am::ABS, &NESCPU::execute_type_0<am::ABS, &NESCPU::op_eor> }, // 0x4d : EOR abs
+		{" LSR\0", 3, am::ABS, &NESCPU::execute_type_1<am::ABS, &NESCPU::op_lsr> }, // 0x4e : LSR abs
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x4f : ???
 		{" BVC\0", 2, am::REL, &NESCPU::execute_bvc }, // 0x50 : BVC rel
-		{" EOR\0", 2, am::INY, &NESCPU::execute_eor }, // 0x51 : EOR ind,Y
+		{" EOR\0", 2, am::INY, &NESCPU::execute_type_0<am::INY, &NESCPU::op_eor> }, // 0x51 : EOR ind,Y
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x52 : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x53 : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x54 : ???
-		{" EOR\0", 2, am::ZPX, &NESCPU::execute_eor }, // 0x55 : EOR zpg,X
-		{" LSR\0", 2, am::ZPX, &NESCPU::execute_lsr }, // 0x56 : LSR zpg,X
+		{" EOR\0", 2, am::ZPX, &NESCPU::execute_type_0<am::ZPX, &NESCPU::op_eor> }, // 0x55 : EOR zpg,X
+		{" LSR\0", 2, am::ZPX, &NESCPU::execute_type_1<am::ZPX, &NESCPU::op_lsr> }, // 0x56 : LSR zpg,X
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x57 : ???
 		{" CLI\0", 1, am::IMP, &NESCPU::execute_cli }, // 0x58 : CLI impl
-		{" EOR\0", 3, am::ABY, &NESCPU::execute_eor }, // 0x59 : EOR abs,Y
+		{" EOR\0", 3, am::ABY, &NESCPU::execute_type_0<am::ABY, &NESCPU::op_eor> }, // 0x59 : EOR abs,Y
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x5a : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x5b : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x5c : ???
-		{" EOR\0", 3, am::ABX, &NESCPU::execute_eor }, // 0x5d : EOR abs,X
-		{" LSR\0", 3, am::ABX, &NESCPU::execute_lsr }, // 0x5e : LSR abs,X
+		{" EOR\0", 3, am::ABX, &NESCPU::execute_type_0<am::ABX, &NESCPU::op_eor> }, // 0x5d : EOR abs,X
+		{" LSR\0", 3, am::ABX, &NESCPU::execute_type_1<am::ABX, &NESCPU::op_lsr> }, // 0x5e : LSR abs,X
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x5f : ???
 		{" RTS\0", 1, am::IMP, &NESCPU::execute_rts }, // 0x60 : RTS impl
-		{" ADC\0", 2, am::XIN, &NESCPU::execute_adc }, // 0x61 : ADC X,ind
+		{" ADC\0", 2, am::XIN, &NESCPU::execute_type_0<am::XIN, &NESCPU::op_adc> }, // 0x61 : ADC X,ind
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x62 : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x63 : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x64 : ???
-		{" ADC\0", 2, am::ZPG, &NESCPU::execute_adc }, // 0x65 : ADC zpg
-		{" ROR\0", 2, am::ZPG, &NESCPU::execute_ror }, // 0x66 : ROR zpg
+		{" ADC\0", 2, am::ZPG, &NESCPU::execute_type_0<am::ZPG, &NESCPU::op_adc> }, // 0x65 : ADC zpg
+		{" ROR\0", 2, am::ZPG, &NESCPU::execute_type_1<am::ZPG, &NESCPU::op_ror> }, // 0x66 : ROR zpg
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x67 : ???
 		{" PLA\0", 1, am::IMP, &NESCPU::execute_pla }, // 0x68 : PLA impl
-		{" ADC\0", 2, am::IMM, &NESCPU::execute_adc }, // 0x69 : ADC #
-		{" ROR\0", 1, am::ACC, &NESCPU::execute_ror }, // 0x6a : ROR A
+		{" ADC\0", 2, am::IMM, &NESCPU::execute_type_0<am::IMM, &NESCPU::op_adc> }, // 0x69 : ADC #
+		{" ROR\0", 1, am::ACC, &NESCPU::execute_type_1<am::ACC, &NESCPU::op_ror> }, // 0x6a : ROR A
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x6b : ???
-		{" JMP\0", 3, am::IND, &NESCPU::execute_jmp }, // 0x6c : JMP ind
-		{" ADC\0", 3, am::ABS, &NESCPU::execute_adc }, // 0x6d : ADC abs
-		{" ROR\0", 3, am::ABS, &NESCPU::execute_ror }, // 0x6e : ROR abs
+		{" JMP\0", 3, am::IND, &NESCPU::execute_jmp<am::IND> }, // 0x6c : JMP ind
+		{" ADC\0", 3, am::ABS, &NESCPU::execute_type_0<am::ABS, &NESCPU::op_adc> }, // 0x6d : ADC abs
+		{" ROR\0", 3, am::ABS, &NESCPU::execute_type_1<am::ABS, &NESCPU::op_ror> }, // 0x6e : ROR abs
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x6f : ???
 		{" BVS\0", 2, am::REL, &NESCPU::execute_bvs }, // 0x70 : BVS rel
-		{" ADC\0", 2, am::INY, &NESCPU::execute_adc }, // 0x71 : ADC ind,Y
+		{" ADC\0", 2, am::INY, &NESCPU::execute_type_0<am::INY, &NESCPU::op_adc> }, // 0x71 : ADC ind,Y
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x72 : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x73 : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x74 : ???
-		{" ADC\0", 2, am::ZPX, &NESCPU::execute_adc }, // 0x75 : ADC zpg,X
-		{" ROR\0", 2, am::ZPX, &NESCPU::execute_ror }, // 0x76 : ROR zpg,X
+		{" ADC\0", 2, am::ZPX, &NESCPU::execute_type_0<am::ZPX, &NESCPU::op_adc> }, // 0x75 : ADC zpg,X
+		{" ROR\0", 2, am::ZPX, &NESCPU::execute_type_1<am::ZPX, &NESCPU::op_ror> }, // 0x76 : ROR zpg,X
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x77 : ???
 		{" SEI\0", 1, am::IMP, &NESCPU::execute_sei }, // 0x78 : SEI impl
-		{" ADC\0", 3, am::ABY, &NESCPU::execute_adc }, // 0x79 : ADC abs,Y
+		{" ADC\0", 3, am::ABY, &NESCPU::execute_type_0<am::ABY, &NESCPU::op_adc> }, // 0x79 : ADC abs,Y
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x7a : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x7b : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x7c : ???
-		{" ADC\0", 3, am::ABX, &NESCPU::execute_adc }, // 0x7d : ADC abs,X
-		{" ROR\0", 3, am::ABX, &NESCPU::execute_ror }, // 0x7e : ROR abs,X
+		{" ADC\0", 3, am::ABX, &NESCPU::execute_type_0<am::ABX, &NESCPU::op_adc> }, // 0x7d : ADC abs,X
+		{" ROR\0", 3, am::ABX, &NESCPU::execute_type_1<am::ABX, &NESCPU::op_ror> }, // 0x7e : ROR abs,X
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x7f : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x80 : ???
-		{" STA\0", 2, am::XIN, &NESCPU::execute_sta }, // 0x81 : STA X,ind
+		{" STA\0", 2, am::XIN, &NESCPU::execute_type_2<am::XIN, &NESCPU::op_sta> }, // 0x81 : STA X,ind
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x82 : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x83 : ???
-		{" STY\0", 2, am::ZPG, &NESCPU::execute_sty }, // 0x84 : STY zpg
-		{" STA\0", 2, am::ZPG, &NESCPU::execute_sta }, // 0x85 : STA zpg
-		{" STX\0", 2, am::ZPG, &NESCPU::execute_stx }, // 0x86 : STX zpg
+		{" STY\0", 2, am::ZPG, &NESCPU::execute_type_2<am::ZPG, &NESCPU::op_sty> }, // 0x84 : STY zpg
+		{" STA\0", 2, am::ZPG, &NESCPU::execute_type_2<am::ZPG, &NESCPU::op_sta> }, // 0x85 : STA zpg
+		{" STX\0", 2, am::ZPG, &NESCPU::execute_type_2<am::ZPG, &NESCPU::op_stx> }, // 0x86 : STX zpg
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x87 : ???
 		{" DEY\0", 1, am::IMP, &NESCPU::execute_dey }, // 0x88 : DEY impl
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x89 : ???
 		{" TXA\0", 1, am::IMP, &NESCPU::execute_txa }, // 0x8a : TXA impl
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x8b : ???
-		{" STY\0", 3, am::ABS, &NESCPU::execute_sty }, // 0x8c : STY abs
-		{" STA\0", 3, am::ABS, &NESCPU::execute_sta }, // 0x8d : STA abs
-		{" STX\0", 3, am::ABS, &NESCPU::execute_stx }, // 0x8e : STX abs
+		{" STY\0", 3, am::ABS, &NESCPU::execute_type_2<am::ABS, &NESCPU::op_sty> }, // 0x8c : STY abs
+		{" STA\0", 3, am::ABS, &NESCPU::execute_type_2<am::ABS, &NESCPU::op_sta> }, // 0x8d : STA abs
+		{" STX\0", 3, am::ABS, &NESCPU::execute_type_2<am::ABS, &NESCPU::op_stx> }, // 0x8e : STX abs
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x8f : ???
 		{" BCC\0", 2, am::REL, &NESCPU::execute_bcc }, // 0x90 : BCC rel
-		{" STA\0", 2, am::INY, &NESCPU::execute_sta }, // 0x91 : STA ind,Y
+		{" STA\0", 2, am::INY, &NESCPU::execute_type_2<am::INY, &NESCPU::op_sta> }, // 0x91 : STA ind,Y
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x92 : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x93 : ???
-		{" STY\0", 2, am::ZPX, &NESCPU::execute_sty }, // 0x94 : STY zpg,X
-		{" STA\0", 2, am::ZPX, &NESCPU::execute_sta }, // 0x95 : STA zpg,X
-		{" STX\0", 2, am::ZPY, &NESCPU::execute_stx }, // 0x96 : STX zpg,Y
+		{" STY\0", 2, am::ZPX, &NESCPU::execute_type_2<am::ZPX, &NESCPU::op_sty> }, // 0x94 : STY zpg,X
+		{" STA\0", 2, am::ZPX, &NESCPU::execute_type_2<am::ZPX, &NESCPU::op_sta> }, // 0x95 : STA zpg,X
+		{" STX\0", 2, am::ZPY, &NESCPU::execute_type_2<am::ZPY, &NESCPU::op_stx> }, // 0x96 : STX zpg,Y
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x97 : ???
 		{" TYA\0", 1, am::IMP, &NESCPU::execute_tya }, // 0x98 : TYA impl
-		{" STA\0", 3, am::ABY, &NESCPU::execute_sta }, // 0x99 : STA abs,Y
+		{" STA\0", 3, am::ABY, &NESCPU::execute_type_2<am::ABY, &NESCPU::op_sta> }, // 0x99 : STA abs,Y
 		{" TXS\0", 1, am::IMP, &NESCPU::execute_txs }, // 0x9a : TXS impl
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x9b : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x9c : ???
-		{" STA\0", 3, am::ABX, &NESCPU::execute_sta }, // 0x9d : STA abs,X
+		{" STA\0", 3, am::ABX, &NESCPU::execute_type_2<am::ABX, &NESCPU::op_sta> }, // 0x9d : STA abs,X
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x9e : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0x9f : ???
-		{" LDY\0", 2, am::IMM, &NESCPU::execute_ldy }, // 0xa0 : LDY #
-		{" LDA\0", 2, am::XIN, &NESCPU::execute_lda }, // 0xa1 : LDA X,ind
-		{" LDX\0", 2, am::IMM, &NESCPU::execute_ldx }, // 0xa2 : LDX #
+		{" LDY\0", 2, am::IMM, &NESCPU::execute_type_0<am::IMM, &NESCPU::op_ldy> }, // 0xa0 : LDY #
+		{" LDA\0", 2, am::XIN, &NESCPU::execute_type_0<am::XIN, &NESCPU::op_lda> }, // 0xa1 : LDA X,ind
+		{" LDX\0", 2, am::IMM, &NESCPU::execute_type_0<am::IMM, &NESCPU::op_ldx> }, // 0xa2 : LDX #
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xa3 : ???
-		{" LDY\0", 2, am::ZPG, &NESCPU::execute_ldy }, // 0xa4 : LDY zpg
-		{" LDA\0", 2, am::ZPG, &NESCPU::execute_lda }, // 0xa5 : LDA zpg
-		{" LDX\0", 2, am::ZPG, &NESCPU::execute_ldx }, // 0xa6 : LDX zpg
+		{" LDY\0", 2, am::ZPG, &NESCPU::execute_type_0<am::ZPG, &NESCPU::op_ldy> }, // 0xa4 : LDY zpg
+		{" LDA\0", 2, am::ZPG, &NESCPU::execute_type_0<am::ZPG, &NESCPU::op_lda> }, // 0xa5 : LDA zpg
+		{" LDX\0", 2, am::ZPG, &NESCPU::execute_type_0<am::ZPG, &NESCPU::op_ldx> }, // 0xa6 : LDX zpg
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xa7 : ???
 		{" TAY\0", 1, am::IMP, &NESCPU::execute_tay }, // 0xa8 : TAY impl
-		{" LDA\0", 2, am::IMM, &NESCPU::execute_lda }, // 0xa9 : LDA #
+		{" LDA\0", 2, am::IMM, &NESCPU::execute_type_0<am::IMM, &NESCPU::op_lda> }, // 0xa9 : LDA #
 		{" TAX\0", 1, am::IMP, &NESCPU::execute_tax }, // 0xaa : TAX impl
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xab : ???
-		{" LDY\0", 3, am::ABS, &NESCPU::execute_ldy }, // 0xac : LDY abs
-		{" LDA\0", 3, am::ABS, &NESCPU::execute_lda }, // 0xad : LDA abs
-		{" LDX\0", 3, am::ABS, &NESCPU::execute_ldx }, // 0xae : LDX abs
+		{" LDY\0", 3, am::ABS, &NESCPU::execute_type_0<am::ABS, &NESCPU::op_ldy> }, // 0xac : LDY abs
+		{" LDA\0", 3, am::ABS, &NESCPU::execute_type_0<am::ABS, &NESCPU::op_lda> }, // 0xad : LDA abs
+		{" LDX\0", 3, am::ABS, &NESCPU::execute_type_0<am::ABS, &NESCPU::op_ldx> }, // 0xae : LDX abs
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xaf : ???
 		{" BCS\0", 2, am::REL, &NESCPU::execute_bcs }, // 0xb0 : BCS rel
-		{" LDA\0", 2, am::INY, &NESCPU::execute_lda }, // 0xb1 : LDA ind,Y
+		{" LDA\0", 2, am::INY, &NESCPU::execute_type_0<am::INY, &NESCPU::op_lda> }, // 0xb1 : LDA ind,Y
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xb2 : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xb3 : ???
-		{" LDY\0", 2, am::ZPX, &NESCPU::execute_ldy }, // 0xb4 : LDY zpg,X
-		{" LDA\0", 2, am::ZPX, &NESCPU::execute_lda }, // 0xb5 : LDA zpg,X
-		{" LDX\0", 2, am::ZPY, &NESCPU::execute_ldx }, // 0xb6 : LDX zpg,Y
+		{" LDY\0", 2, am::ZPX, &NESCPU::execute_type_0<am::ZPX, &NESCPU::op_ldy> }, // 0xb4 : LDY zpg,X
+		{" LDA\0", 2, am::ZPX, &NESCPU::execute_type_0<am::ZPX, &NESCPU::op_lda> }, // 0xb5 : LDA zpg,X
+		{" LDX\0", 2, am::ZPY, &NESCPU::execute_type_0<am::ZPY, &NESCPU::op_ldx> }, // 0xb6 : LDX zpg,Y
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xb7 : ???
 		{" CLV\0", 1, am::IMP, &NESCPU::execute_clv }, // 0xb8 : CLV impl
-		{" LDA\0", 3, am::ABY, &NESCPU::execute_lda }, // 0xb9 : LDA abs,Y
+		{" LDA\0", 3, am::ABY, &NESCPU::execute_type_0<am::ABY, &NESCPU::op_lda> }, // 0xb9 : LDA abs,Y
 		{" TSX\0", 1, am::IMP, &NESCPU::execute_tsx }, // 0xba : TSX impl
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xbb : ???
-		{" LDY\0", 3, am::ABX, &NESCPU::execute_ldy }, // 0xbc : LDY abs,X
-		{" LDA\0", 3, am::ABX, &NESCPU::execute_lda }, // 0xbd : LDA abs,X
-		{" LDX\0", 3, am::ABY, &NESCPU::execute_ldx }, // 0xbe : LDX abs,Y
+		{" LDY\0", 3, am::ABX, &NESCPU::execute_type_0<am::ABX, &NESCPU::op_ldy> }, // 0xbc : LDY abs,X
+		{" LDA\0", 3, am::ABX, &NESCPU::execute_type_0<am::ABX, &NESCPU::op_lda> }, // 0xbd : LDA abs,X
+		{" LDX\0", 3, am::ABY, &NESCPU::execute_type_0<am::ABY, &NESCPU::op_ldx> }, // 0xbe : LDX abs,Y
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xbf : ???
-		{" CPY\0", 2, am::IMM, &NESCPU::execute_cpy }, // 0xc0 : CPY #
-		{" CMP\0", 2, am::XIN, &NESCPU::execute_cmp }, // 0xc1 : CMP X,ind
+		{" CPY\0", 2, am::IMM, &NESCPU::execute_type_0<am::IMM, &NESCPU::op_cpy> }, // 0xc0 : CPY #
+		{" CMP\0", 2, am::XIN, &NESCPU::execute_type_0<am::XIN, &NESCPU::op_cmp> }, // 0xc1 : CMP X,ind
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xc2 : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xc3 : ???
-		{" CPY\0", 2, am::ZPG, &NESCPU::execute_cpy }, // 0xc4 : CPY zpg
-		{" CMP\0", 2, am::ZPG, &NESCPU::execute_cmp }, // 0xc5 : CMP zpg
-		{" DEC\0", 2, am::ZPG, &NESCPU::execute_dec }, // 0xc6 : DEC zpg
+		{" CPY\0", 2, am::ZPG, &NESCPU::execute_type_0<am::ZPG, &NESCPU::op_cpy> }, // 0xc4 : CPY zpg
+		{" CMP\0", 2, am::ZPG, &NESCPU::execute_type_0<am::ZPG, &NESCPU::op_cmp> }, // 0xc5 : CMP zpg
+		{" DEC\0", 2, am::ZPG, &NESCPU::execute_type_1<am::ZPG, &NESCPU::op_dec> }, // 0xc6 : DEC zpg
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xc7 : ???
 		{" INY\0", 1, am::IMP, &NESCPU::execute_iny }, // 0xc8 : INY impl
-		{" CMP\0", 2, am::IMM, &NESCPU::execute_cmp }, // 0xc9 : CMP #
+		{" CMP\0", 2, am::IMM, &NESCPU::execute_type_0<am::IMM, &NESCPU::op_cmp> }, // 0xc9 : CMP #
 		{" DEX\0", 1, am::IMP, &NESCPU::execute_dex }, // 0xca : DEX impl
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xcb : ???
-		{" CPY\0", 3, am::ABS, &NESCPU::execute_cpy }, // 0xcc : CPY abs
-		{" CMP\0", 3, am::ABS, &NESCPU::execute_cmp }, // 0xcd : CMP abs
-		{" DEC\0", 3, am::ABS, &NESCPU::execute_dec }, // 0xce : DEC abs
+		{" CPY\0", 3, am::ABS, &NESCPU::execute_type_0<am::ABS, &NESCPU::op_cpy> }, // 0xcc : CPY abs
+		{" CMP\0", 3, am::ABS, &NESCPU::execute_type_0<am::ABS, &NESCPU::op_cmp> }, // 0xcd : CMP abs
+		{" DEC\0", 3, am::ABS, &NESCPU::execute_type_1<am::ABS, &NESCPU::op_dec> }, // 0xce : DEC abs
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xcf : ???
 		{" BNE\0", 2, am::REL, &NESCPU::execute_bne }, // 0xd0 : BNE rel
-		{" CMP\0", 2, am::INY, &NESCPU::execute_cmp }, // 0xd1 : CMP ind,Y
+		{" CMP\0", 2, am::INY, &NESCPU::execute_type_0<am::INY, &NESCPU::op_cmp> }, // 0xd1 : CMP ind,Y
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xd2 : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xd3 : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xd4 : ???
-		{" CMP\0", 2, am::ZPX, &NESCPU::execute_cmp }, // 0xd5 : CMP zpg,X
-		{" DEC\0", 2, am::ZPX, &NESCPU::execute_dec }, // 0xd6 : DEC zpg,X
+		{" CMP\0", 2, am::ZPX, &NESCPU::execute_type_0<am::ZPX, &NESCPU::op_cmp> }, // 0xd5 : CMP zpg,X
+		{" DEC\0", 2, am::ZPX, &NESCPU::execute_type_1<am::ZPX, &NESCPU::op_dec> }, // 0xd6 : DEC zpg,X
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xd7 : ???
 		{" CLD\0", 1, am::IMP, &NESCPU::execute_cld }, // 0xd8 : CLD impl
-		{" CMP\0", 3, am::ABY, &NESCPU::execute_cmp }, // 0xd9 : CMP abs,Y
+		{" CMP\0", 3, am::ABY, &NESCPU::execute_type_0<am::ABY, &NESCPU::op_cmp> }, // 0xd9 : CMP abs,Y
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xda : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xdb : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xdc : ???
-		{" CMP\0", 3, am::ABX, &NESCPU::execute_cmp }, // 0xdd : CMP abs,X
-		{" DEC\0", 3, am::ABX, &NESCPU::execute_dec }, // 0xde : DEC abs,X
+		{" CMP\0", 3, am::ABX, &NESCPU::execute_type_0<am::ABX, &NESCPU::op_cmp> }, // 0xdd : CMP abs,X
+		{" DEC\0", 3, am::ABX, &NESCPU::execute_type_1<am::ABX, &NESCPU::op_dec> }, // 0xde : DEC abs,X
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xdf : ???
-		{" CPX\0", 2, am::IMM, &NESCPU::execute_cpx }, // 0xe0 : CPX #
-		{" SBC\0", 2, am::XIN, &NESCPU::execute_sbc }, // 0xe1 : SBC X,ind
+		{" CPX\0", 2, am::IMM, &NESCPU::execute_type_0<am::IMM, &NESCPU::op_cpx> }, // 0xe0 : CPX #
+		{" SBC\0", 2, am::XIN, &NESCPU::execute_type_0<am::XIN, &NESCPU::op_sbc> }, // 0xe1 : SBC X,ind
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xe2 : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xe3 : ???
-		{" CPX\0", 2, am::ZPG, &NESCPU::execute_cpx }, // 0xe4 : CPX zpg
-		{" SBC\0", 2, am::ZPG, &NESCPU::execute_sbc }, // 0xe5 : SBC zpg
-		{" INC\0", 2, am::ZPG, &NESCPU::execute_inc }, // 0xe6 : INC zpg
+		{" CPX\0", 2, am::ZPG, &NESCPU::execute_type_0<am::ZPG, &NESCPU::op_cpx> }, // 0xe4 : CPX zpg
+		{" SBC\0", 2, am::ZPG, &NESCPU::execute_type_0<am::ZPG, &NESCPU::op_sbc> }, // 0xe5 : SBC zpg
+		{" INC\0", 2, am::ZPG, &NESCPU::execute_type_1<am::ZPG, &NESCPU::op_inc> }, // 0xe6 : INC zpg
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xe7 : ???
 		{" INX\0", 1, am::IMP, &NESCPU::execute_inx }, // 0xe8 : INX impl
-		{" SBC\0", 2, am::IMM, &NESCPU::execute_sbc }, // 0xe9 : SBC #
+		{" SBC\0", 2, am::IMM, &NESCPU::execute_type_0<am::IMM, &NESCPU::op_sbc> }, // 0xe9 : SBC #
 		{" NOP\0", 1, am::IMP, &NESCPU::execute_nop }, // 0xea : NOP impl
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xeb : ???
-		{" CPX\0", 3, am::ABS, &NESCPU::execute_cpx }, // 0xec : CPX abs
-		{" SBC\0", 3, am::ABS, &NESCPU::execute_sbc }, // 0xed : SBC abs
-		{" INC\0", 3, am::ABS, &NESCPU::execute_inc }, // 0xee : INC abs
+		{" CPX\0", 3, am::ABS, &NESCPU::execute_type_0<am::ABS, &NESCPU::op_cpx> }, // 0xec : CPX abs
+		{" SBC\0", 3, am::ABS, &NESCPU::execute_type_0<am::ABS, &NESCPU::op_sbc> }, // 0xed : SBC abs
+		{" INC\0", 3, am::ABS, &NESCPU::execute_type_1<am::ABS, &NESCPU::op_inc> }, // 0xee : INC abs
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xef : ???
 		{" BEQ\0", 2, am::REL, &NESCPU::execute_beq }, // 0xf0 : BEQ rel
-		{" SBC\0", 2, am::INY, &NESCPU::execute_sbc }, // 0xf1 : SBC ind,Y
+		{" SBC\0", 2, am::INY, &NESCPU::execute_type_0<am::INY, &NESCPU::op_sbc> }, // 0xf1 : SBC ind,Y
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xf2 : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xf3 : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xf4 : ???
-		{" SBC\0", 2, am::ZPX, &NESCPU::execute_sbc }, // 0xf5 : SBC zpg,X
-		{" INC\0", 2, am::ZPX, &NESCPU::execute_inc }, // 0xf6 : INC zpg,X
+		{" SBC\0", 2, am::ZPX, &NESCPU::execute_type_0<am::ZPX, &NESCPU::op_sbc> }, // 0xf5 : SBC zpg,X
+		{" INC\0", 2, am::ZPX, &NESCPU::execute_type_1<am::ZPX, &NESCPU::op_inc> }, // 0xf6 : INC zpg,X
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xf7 : ???
 		{" SED\0", 1, am::IMP, &NESCPU::execute_sed }, // 0xf8 : SED impl
-		{" SBC\0", 3, am::ABY, &NESCPU::execute_sbc }, // 0xf9 : SBC abs,Y
+		{" SBC\0", 3, am::ABY, &NESCPU::execute_type_0<am::ABY, &NESCPU::op_sbc> }, // 0xf9 : SBC abs,Y
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xfa : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xfb : ???
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xfc : ???
-		{" SBC\0", 3, am::ABX, &NESCPU::execute_sbc }, // 0xfd : SBC abs,X
-		{" INC\0", 3, am::ABX, &NESCPU::execute_inc }, // 0xfe : INC abs,X
+		{" SBC\0", 3, am::ABX, &NESCPU::execute_type_0<am::ABX, &NESCPU::op_sbc> }, // 0xfd : SBC abs,X
+		{" INC\0", 3, am::ABX, &NESCPU::execute_type_1<am::ABX, &NESCPU::op_inc> }, // 0xfe : INC abs,X
 		{" ???\0", 1, am::XXX, &NESCPU::execute_xxx }, // 0xff : ???
 
 	};
+
+	//Superinstructions : common idioms in ROM executed by single handler (per-instruction Step only)
+	// first opcode, second opcode, worst case cycles of pair, handler
+	auto fuse = [this](uint8_t first, uint8_t second, uint8_t max_cycles, uint32_t(NESCPU::* fn)(void))
+	{
+		m_Fusions[first].push_back({ second, max_cycles, fn });
+	};
+	// LDA/STA copies
+	fuse(0xA9, 0x85, 5, &NESCPU::fused_lda_sta<am::IMM, am::ZPG>); // LDA # / STA zpg
+	fuse(0xA9, 0x8D, 6, &NESCPU::fused_lda_sta<am::IMM, am::ABS>); // LDA # / STA abs
+	fuse(0xA5, 0x85, 6, &NESCPU::fused_lda_sta<am::ZPG, am::ZPG>); // LDA zpg / STA zpg
+	fuse(0xA5, 0x8D, 7, &NESCPU::fused_lda_sta<am::ZPG, am::ABS>); // LDA zpg / STA abs
+	fuse(0xAD, 0x85, 7, &NESCPU::fused_lda_sta<am::ABS, am::ZPG>); // LDA abs / STA zpg
+	fuse(0xAD, 0x8D, 8, &NESCPU::fused_lda_sta<am::ABS, am::ABS>); // LDA abs / STA abs
+	// Counter loops
+	fuse(0xCA, 0xD0, 6, &NESCPU::fused_dec_bne<false>); // DEX / BNE
+	fuse(0x88, 0xD0, 6, &NESCPU::fused_dec_bne<true>);  // DEY / BNE
+	// Counters
+	fuse(0xE6, 0xA5, 8, &NESCPU::fused_inc_lda); // INC zpg / LDA zpg
+	// Compare chains
+	fuse(0xC9, 0xF0, 6, &NESCPU::fused_cmp_branch<am::IMM, true>);  // CMP # / BEQ
+	fuse(0xC9, 0xD0, 6, &NESCPU::fused_cmp_branch<am::IMM, false>); // CMP # / BNE
+	fuse(0xC5, 0xF0, 7, &NESCPU::fused_cmp_branch<am::ZPG, true>);  // CMP zpg / BEQ
+	fuse(0xC5, 0xD0, 7, &NESCPU::fused_cmp_branch<am::ZPG, false>); // CMP zpg / BNE
 }
 
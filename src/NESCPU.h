@@ -1,7 +1,8 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
-#include <functional>
+#include <string>
 #include <vector>
 
 #include "NESState.h"
@@ -15,11 +16,29 @@ public:
 	NESCPU(NESDevice* nesDevice);
 
 	void Reset();
+	//Advance cpu by single cycle
 	void Update();
+	//Advance cpu by whole instruction (or interrupt/DMA), returns number of cycles taken
+	// 'fusion_cycles' - cycles nothing else happens for (next event), common idiom may run
+	// together with following instruction if both fit (see prepare_table), 0 disables fusion
+	uint32_t Step(uint32_t fusion_cycles = 0);
 	bool IsReady();
+	//Checks if code at address is side-effect free polling loop (JMP *, LDA/CMP/BIT... + branch back)
+	// returns amount of instructions in loop, 0 if it isn't one
+	uint32_t DetectIdleLoop(uint16_t address);
+
+	//Instructions executed by fused idiom handlers
+	uint64_t FusedInstructions;
+
+	//Heap memory owned by cpu (bytes)
+	size_t GetMemoryFootprint();
 
 	bool SaveState(NESState& state);
 	bool LoadState(NESState& state);
+	//Copies cpu state into target (fast path of SaveState/LoadState, see NESDevice::CloneInto)
+	void CloneInto(NESCPU& target);
+	//Drops decoded instructions, has to be called when memory they were decoded from may be gone
+	void FlushDecodeCache();
 
 	std::vector<std::string> Disassemble(uint16_t address, uint32_t count,bool include_previous = false);
 	// **************** CPU State and statistics ****************
@@ -105,6 +124,9 @@ public:
 	//Just for convenience
 	void setFlag(SRFlag flag, bool val);
 	bool getFlag(SRFlag flag);
+	//N and Z flags are evaluated lazily (see set_nz), writes them into Registers.SR
+	// has to be called before Registers.SR is accessed directly from outside of cpu
+	void SyncFlags();
 
 	// **************** IO Operations ****************
 
@@ -117,6 +139,11 @@ public:
 	}DataBus;
 	using AddrMode = State::AddrMode;
 
+	//Instruction table lookup (mnemonic, size in bytes, addressing mode), ??? for illegal opcodes
+	const char* GetInstructionName(uint8_t opcode);
+	uint8_t		GetInstructionSize(uint8_t opcode);
+	AddrMode	GetInstructionMode(uint8_t opcode);
+
 	//Direct R/W Operations (Proxy functions for NESDevice CPURead/Write)
 	uint8_t ReadBus(uint16_t address);
 	void    WriteBus(uint16_t address, uint8_t byte);
@@ -129,6 +156,15 @@ protected:
 	//Ptr to main device for io operations
 	NESDevice* m_NESDevicePtr;
 
+	//Idiom starting with instruction, handler runs both instructions at once and returns
+	// cycles taken (0 if it can't, instruction is then executed normally)
+	struct Fusion
+	{
+		uint8_t  NextOpCode;
+		uint8_t  MaxCycles;
+		uint32_t(NESCPU::* fn)(void);
+	};
+
 	//Special table for instructions lookup
 	struct Instruction
 	{
@@ -138,29 +174,94 @@ protected:
 		bool(NESCPU::* fn)(void) = nullptr;
 	};
 	std::vector<Instruction> m_InstructionLookup;
+	//Idioms starting with instruction, indexed by its opcode (most opcodes have none)
+	std::array<std::vector<Fusion>, 256> m_Fusions;
+
+	//Decoded instructions from readonly memory (PRG ROM), direct mapped by address and tagged
+	// by pointer to source memory, so switched bank just misses (ROM itself never changes)
+	struct DecodedInstruction
+	{
+		const uint8_t*	   Source = nullptr;
+		const Instruction* Inst = nullptr;
+		uint8_t			   OpCode = 0;
+		uint8_t			   Operand[2] = { 0, 0 };
+		const Fusion*	   Fused = nullptr;	//Idiom formed with following instruction
+		uint8_t			   NextOperand[2] = { 0, 0 };
+	};
+	static const uint32_t DecodeCacheSize = 4096;
+	std::vector<DecodedInstruction> m_DecodeCache;
+	const DecodedInstruction* m_Decoded = nullptr; //Instruction being executed (nullptr if it wasn't cached)
+	uint16_t m_DecodedPC = 0;
+
+	//Returns cache entry for instruction at address, nullptr if it can't be cached
+	const DecodedInstruction* decode_cached(uint16_t address);
+	//Reads next instruction byte at PC (from decode cache if possible)
+	uint8_t fetch_operand();
+
+	//Runs handler until instruction completes, used by Step
+	void execute_cycles(bool(NESCPU::* fn)(void));
 
 	//Dissassemble single operation
 	std::string disassemble_op(uint16_t address, uint16_t* next_address);
 
+	//Addressing mode and operation are template arguments, so every table entry
+	//gets its own handler with the operation inlined (no runtime dispatch inside)
 	// ADC, AND, CMP, EOR, LDA, ORA, SBC, LDX, LDY
 	// BIT, CPX, CPY
-	bool execute_type_0(std::function<void(void)> op_lambda);
+	template<AddrMode Mode, void(NESCPU::* Op)(void)> bool execute_type_0();
 	// ASL, DEC, INC, LSR, ROL, ROR
-	bool execute_type_1(std::function<void(void)> op_lambda);
+	template<AddrMode Mode, void(NESCPU::* Op)(void)> bool execute_type_1();
 	// STX, STA, STY
-	bool execute_type_2(std::function<void(void)> op_lambda);
+	template<AddrMode Mode, void(NESCPU::* Op)(void)> bool execute_type_2();
+
+	//Lazy flags : most N/Z results are overwritten before anything reads them, so only
+	// the last result is kept and SR is built when flags are read (branches, pushes, SyncFlags)
+	uint8_t m_NZResult;
+	bool	m_IsNZPending;
+	inline void set_nz(uint8_t result)
+	{
+		m_NZResult = result;
+		m_IsNZPending = true;
+	}
+
+	/// *** FUSED IDIOMS (see prepare_table) *** ///
+	template<AddrMode LoadMode, AddrMode StoreMode> uint32_t fused_lda_sta();	// LDA/STA copy
+	template<bool IsY> uint32_t fused_dec_bne();	// DEX/BNE, DEY/BNE loop
+	uint32_t fused_inc_lda();						// INC zp / LDA zp
+	template<AddrMode Mode, bool IsEqual> uint32_t fused_cmp_branch();	// CMP/BEQ, CMP/BNE chain
+	//Bookkeeping after fused pair (as if both instructions were stepped), returns total cycles
+	uint32_t complete_fused(uint32_t first_cycles, uint32_t second_cycles, uint16_t next_pc);
+
+	/// *** OPERATIONS (used by execute_type_X) *** ///
+	void op_adc(); // add with carry
+	void op_and(); // and (with accumulator)
+	void op_asl(); // arithmetic shift left
+	void op_bit(); // bit test
+	void op_cmp(); // compare (with accumulator)
+	void op_cpx(); // compare with x
+	void op_cpy(); // compare with y
+	void op_dec(); // decrement
+	void op_eor(); // exclusive or (with accumulator)
+	void op_inc(); // increment
+	void op_lda(); // load accumulator
+	void op_ldx(); // load x
+	void op_ldy(); // load y
+	void op_lsr(); // logical shift right
+	void op_ora(); // or with accumulator
+	void op_rol(); // rotate left
+	void op_ror(); // rotate right
+	void op_sbc(); // subtract with carry
+	void op_sta(); // store accumulator
+	void op_stx(); // store x
+	void op_sty(); // store y
 
 
 	/// *** OP CODES *** ///
 	bool execute_irq();
 	bool execute_nmi();
-	bool execute_adc(); // add with carry
-	bool execute_and(); // and (with accumulator)
-	bool execute_asl(); // arithmetic shift left
 	bool execute_bcc(); // branch on carry clear
 	bool execute_bcs(); // branch on carry set
 	bool execute_beq(); // branch on equal (zero set)
-	bool execute_bit(); // bit test
 	bool execute_bmi(); // branch on minus (negative set)
 	bool execute_bne(); // branch on not equal (zero clear)
 	bool execute_bpl(); // branch on plus (negative clear)
@@ -171,39 +272,22 @@ protected:
 	bool execute_cld(); // clear decimal
 	bool execute_cli(); // clear interrupt disable
 	bool execute_clv(); // clear overflow
-	bool execute_cmp(); // compare (with accumulator)
-	bool execute_cpx(); // compare with x
-	bool execute_cpy(); // compare with y
-	bool execute_dec(); // decrement
 	bool execute_dex(); // decrement x
 	bool execute_dey(); // decrement y
-	bool execute_eor(); // exclusive or (with accumulator)
-	bool execute_inc(); // increment
 	bool execute_inx(); // increment x
 	bool execute_iny(); // increment y
-	bool execute_jmp(); // jump
+	template<AddrMode Mode> bool execute_jmp(); // jump
 	bool execute_jsr(); // jump subroutine
-	bool execute_lda(); // load accumulator
-	bool execute_ldx(); // load x
-	bool execute_ldy(); // load y
-	bool execute_lsr(); // logical shift right
 	bool execute_nop(); // no operation
-	bool execute_ora(); // or with accumulator
 	bool execute_pha(); // push accumulator
 	bool execute_php(); // push processor status (sr)
 	bool execute_pla(); // pull accumulator
 	bool execute_plp(); // pull processor status (sr)
-	bool execute_rol(); // rotate left
-	bool execute_ror(); // rotate right
 	bool execute_rti(); // return from interrupt
 	bool execute_rts(); // return from subroutine
-	bool execute_sbc(); // subtract with carry
 	bool execute_sec(); // set carry
 	bool execute_sed(); // set decimal
 	bool execute_sei(); // set interrupt disable
-	bool execute_sta(); // store accumulator
-	bool execute_stx(); // store x
-	bool execute_sty(); // store y
 	bool execute_tax(); // transfer accumulator to x
 	bool execute_tay(); // transfer accumulator to y
 	bool execute_tsx(); // transfer stack pointer to x
@@ -1,12 +1,28 @@
 #include "NESCartrige.h"
 
+#include <cstring>
+
 #include "NESMapper_000.h"
 #include "NESMapper_001.h"
 #include "NESMapper_002.h"
 #include "NESMapper_007.h"
 
+template<typename Fn>
+inline auto NESCartrige::dispatch_mapper(Fn&& fn)
+{
+	switch (m_MapperID)
+	{
+	case 0:  return fn(static_cast<NESMapper_000&>(*m_MapperPtr));
+	case 1:  return fn(static_cast<NESMapper_001&>(*m_MapperPtr));
+	case 2:  return fn(static_cast<NESMapper_002&>(*m_MapperPtr));
+	case 7:  return fn(static_cast<NESMapper_007&>(*m_MapperPtr));
+	default: return fn(*m_MapperPtr);
+	}
+}
+
 NESCartrige::NESCartrige()
 {
+	Verbose = true;
 	m_IsCartrigeReady = false;
 	m_ROMName = "undefined";
 
@@ -20,11 +36,14 @@ NESCartrige::NESCartrige()
 	m_IsCHRPresent = false;
 
 	m_RAMMemory.clear();
-	m_PRGMemory.clear();
-	m_CHRMemory.clear();
-
-
-	m_CHRMemory.resize(m_CHRChunksCount * 0x2000);
+	m_ROMImage = nullptr;
+	m_PRGMemory = nullptr;
+	m_PRGSize = 0;
+	m_CHRMemory = nullptr;
+	m_CHRSize = 0;
+	m_CHRRAM.clear();
+	m_CHRTiles = nullptr;
+	m_CHRRAMTiles.clear();
 }
 
 NESCartrige::~NESCartrige()
@@ -48,10 +67,14 @@ void NESCartrige::ClearCartrige()
 		m_IsCHRPresent = false;
 
 		m_RAMMemory.clear();
-		m_PRGMemory.clear();
-		m_CHRMemory.clear();
-
-		m_CHRMemory.resize(m_CHRChunksCount * 0x2000);
+		m_ROMImage = nullptr;
+		m_PRGMemory = nullptr;
+		m_PRGSize = 0;
+		m_CHRMemory = nullptr;
+		m_CHRSize = 0;
+		m_CHRRAM.clear();
+		m_CHRTiles = nullptr;
+		m_CHRRAMTiles.clear();
 
 		m_MapperPtr.release();
 	}
@@ -79,10 +102,10 @@ bool NESCartrige::LoadCartrige(std::string file_name)
 		char unused[5];
 	} ines_header;
 	
-	std::ifstream ifs(file_name, std::ifstream::binary);
-	if (ifs.is_open())
+	std::shared_ptr<const NESROMImage> image = NESROMImage::Load(file_name);
+	if (image != nullptr)
 	{
-		ifs.read((char*)&ines_header, sizeof(INESFileHeader));
+		memcpy(&ines_header, image->GetHeader(), sizeof(INESFileHeader));
 		
 		//   FLAG 6
 		//  76543210
@@ -107,17 +130,16 @@ bool NESCartrige::LoadCartrige(std::string file_name)
 
 		m_MirroringMode = (ines_header.flags6 & 0x01);
 		
-		//Seek over trainer data if present
-		if (ines_header.flags6 & 0x04) ifs.seekg(512, std::ios_base::cur);
+		//Trainer data (if present) is skipped by image
 
 
-		if ((ines_header.flags7 & 0x0C) == 0x08)
+		if ((ines_header.flags7 & 0x0C) == 0x08 && Verbose)
 			printf("Detected NES 2.0 compatible ROM image...\n");
 
 		if ((ines_header.flags6 & 0x02))
 		{
-			printf("ROM Require 2kb for RAM\n");
-			m_RAMMemory.resize(m_PRGChunksCount * 0x2000);
+			if (Verbose) printf("ROM Require 8kb for RAM\n");
+			m_RAMMemory.assign(0x2000, 0);
 			m_IsRAMPresent = true;
 		}
 		else
@@ -125,13 +147,18 @@ bool NESCartrige::LoadCartrige(std::string file_name)
 			m_IsRAMPresent = false;
 		}
 
+		m_ROMImage = image;
+
 		m_PRGChunksCount = ines_header.prg_chunks;
-		m_PRGMemory.resize(m_PRGChunksCount * 0x4000);
-		ifs.read((char*)m_PRGMemory.data(), m_PRGMemory.size());
+		m_PRGMemory = image->GetPRG();
+		m_PRGSize = image->GetPRGSize();
 
 		m_CHRChunksCount = ines_header.chr_chunks;
-		m_CHRMemory.resize(m_CHRChunksCount * 0x2000);
-		ifs.read((char*)m_CHRMemory.data(), m_CHRMemory.size());
+		m_CHRMemory = image->GetCHR();
+		m_CHRSize = image->GetCHRSize();
+		m_CHRRAM.clear();
+		m_CHRTiles = image->GetCHRTiles();
+		m_CHRRAMTiles.clear();
 
 		//Initialize mapper
 		switch (m_MapperID)
@@ -143,23 +170,28 @@ bool NESCartrige::LoadCartrige(std::string file_name)
 		default:
 			printf("Unknown mapper %.3d\n", m_MapperID);
 			printf("Unable to load \"%s\"\n", file_name.c_str());
-			ifs.close();
 			return LoadDummyCartrige();
 		}
 		m_MapperPtr->Reset();
 
-		printf("ROM \"%s\" %s\n", file_name.c_str(), m_IsCartrigeReady ? "Loaded" : "Failed to load");
-		printf("\tPRG Banks : %d [%d bytes]\n", ines_header.prg_chunks, (int)m_PRGMemory.size());
-		printf("\tCHR Banks : %d [%d bytes]\n", ines_header.chr_chunks, (int)m_CHRMemory.size());
-		printf("\tTrainer : %d\n", ines_header.flags6 & 0x04);
-		printf("\tMapper : %d\n", m_MapperID);
-		printf("\tMirroring : %d\n", m_MirroringMode);
+		if (Verbose)
+		{
+			printf("ROM \"%s\" %s\n", file_name.c_str(), m_IsCartrigeReady ? "Loaded" : "Failed to load");
+			printf("\tPRG Banks : %d [%d bytes]\n", ines_header.prg_chunks, (int)m_PRGSize);
+			printf("\tCHR Banks : %d [%d bytes]\n", ines_header.chr_chunks, (int)m_CHRSize);
+			printf("\tTrainer : %d\n", ines_header.flags6 & 0x04);
+			printf("\tMapper : %d\n", m_MapperID);
+			printf("\tMirroring : %d\n", m_MirroringMode);
+		}
 
 		if (ines_header.chr_chunks == 0)
 		{
-			printf("CHR Tables not present...\nAllocating RAM for CHR\n");
+			if (Verbose) printf("CHR Tables not present...\nAllocating RAM for CHR\n");
 			m_CHRChunksCount = 1;
-			m_CHRMemory.resize(m_CHRChunksCount * 0x2000);
+			m_CHRRAM.assign(m_CHRChunksCount * 0x2000, 0);
+			m_CHRMemory = m_CHRRAM.data();
+			m_CHRSize = (uint32_t)m_CHRRAM.size();
+			this->decode_chr_ram();
 			m_IsCHRPresent = false;
 		}
 		else
@@ -167,8 +199,6 @@ bool NESCartrige::LoadCartrige(std::string file_name)
 			m_IsCHRPresent = true;
 		}
 
-		ifs.close();
-
 		m_ROMName = std::filesystem::path(file_name).stem().string();
 	}
 	else
@@ -194,12 +224,15 @@ bool NESCartrige::LoadDummyCartrige()
 	m_RAMMemory.resize(0x2000);
 
 	m_PRGChunksCount = 1;
-	m_PRGMemory.clear();
-	m_PRGMemory.resize(m_PRGChunksCount * 0x4000);
+	m_ROMImage = NESROMImage::CreateBlank(m_PRGChunksCount * 0x4000, 0);
+	m_PRGMemory = m_ROMImage->GetPRG();
+	m_PRGSize = m_ROMImage->GetPRGSize();
 
 	m_CHRChunksCount = 1;
-	m_CHRMemory.clear();
-	m_CHRMemory.resize(m_CHRChunksCount * 0x2000);
+	m_CHRRAM.assign(m_CHRChunksCount * 0x2000, 0);
+	m_CHRMemory = m_CHRRAM.data();
+	m_CHRSize = (uint32_t)m_CHRRAM.size();
+	this->decode_chr_ram();
 
 	m_IsRAMPresent = true;
 	m_IsCHRPresent = false;
@@ -218,7 +251,13 @@ void NESCartrige::Reset()
 void NESCartrige::Update()
 {
 	if(!m_IsCartrigeReady) return;
-	m_MapperPtr->Update();
+	dispatch_mapper([](auto& mapper) { mapper.Update(); });
+}
+
+NESMapper::ClockMode NESCartrige::GetClockMode()
+{
+	if (!m_IsCartrigeReady) return NESMapper::ClockMode::None;
+	return dispatch_mapper([](auto& mapper) { return mapper.GetClockMode(); });
 }
 
 bool NESCartrige::IsCartrigeReady()
@@ -247,11 +286,43 @@ bool NESCartrige::SaveState(NESState& state)
 	if (m_IsRAMPresent)
 		state.Write(m_RAMMemory.data(), 0x2000);
 	if (!m_IsCHRPresent)
-		state.Write(m_CHRMemory.data(), sizeof(uint8_t) * 0x2000);
+		state.Write(m_CHRRAM.data(), sizeof(uint8_t) * 0x2000);
 
 	return result;
 }
 
+void NESCartrige::CloneInto(NESCartrige& target)
+{
+	target.m_IsCartrigeReady = m_IsCartrigeReady;
+	target.m_MapperID = m_MapperID;
+	target.m_MirroringMode = m_MirroringMode;
+	target.m_PRGChunksCount = m_PRGChunksCount;
+	target.m_CHRChunksCount = m_CHRChunksCount;
+	target.m_IsRAMPresent = m_IsRAMPresent;
+	target.m_IsCHRPresent = m_IsCHRPresent;
+
+	if (target.m_ROMImage != m_ROMImage)
+	{
+		target.m_ROMName = m_ROMName;
+		target.m_ROMImage = m_ROMImage;
+		target.m_PRGMemory = m_PRGMemory;
+		target.m_PRGSize = m_PRGSize;
+	}
+
+	//Vectors keep their storage when sizes match
+	target.m_RAMMemory = m_RAMMemory;
+	target.m_CHRRAM = m_CHRRAM;
+	target.m_CHRMemory = m_IsCHRPresent ? m_CHRMemory : target.m_CHRRAM.data();
+	target.m_CHRRAMTiles = m_CHRRAMTiles;
+	target.m_CHRTiles = m_IsCHRPresent ? m_CHRTiles : target.m_CHRRAMTiles.data();
+	target.m_CHRSize = m_CHRSize;
+
+	if (m_MapperPtr != nullptr)
+		m_MapperPtr->CloneInto(target.m_MapperPtr);
+	else
+		target.m_MapperPtr.reset();
+}
+
 bool NESCartrige::LoadState(NESState& state)
 {
 	bool result = true;
@@ -297,7 +368,10 @@ bool NESCartrige::LoadState(NESState& state)
 	if (m_IsRAMPresent)
 		state.Read(m_RAMMemory.data(), 0x2000);
 	if (!m_IsCHRPresent)
-		state.Read(m_CHRMemory.data(), sizeof(uint8_t) * 0x2000);
+	{
+		state.Read(m_CHRRAM.data(), sizeof(uint8_t) * 0x2000);
+		this->decode_chr_ram();
+	}
 
 	return result;
 }
@@ -324,7 +398,22 @@ uint32_t NESCartrige::GetPRGChunksCount()
 
 uint32_t NESCartrige::GetPRGSize()
 {
-	return (uint32_t)m_PRGMemory.size();
+	return m_PRGSize;
+}
+
+const uint8_t* NESCartrige::GetPRGMemory()
+{
+	return m_PRGMemory;
+}
+
+const NESROMImage* NESCartrige::GetROMImage()
+{
+	return m_ROMImage.get();
+}
+
+size_t NESCartrige::GetMemoryFootprint()
+{
+	return m_RAMMemory.capacity() + m_CHRRAM.capacity() + m_CHRRAMTiles.capacity();
 }
 
 uint32_t NESCartrige::GetCHRChunksCount()
@@ -334,18 +423,23 @@ uint32_t NESCartrige::GetCHRChunksCount()
 
 uint32_t NESCartrige::GetCHRSize()
 {
-	return (uint32_t)m_PRGMemory.size();
+	return m_CHRSize;
 }
 
 uint8_t NESCartrige::CPURead(uint16_t address)
 {
 	if (!m_IsCartrigeReady || m_PRGChunksCount == 0) return 0x00;
 
+	// $6000-$7FFF : PRG RAM
+	if (m_IsRAMPresent && address >= 0x6000 && address <= 0x7FFF)
+		return m_RAMMemory[address & 0x1FFF];
+
 	uint32_t local_address = 0;
 
 	//Check for interception 
 	//(in case if mapper wants to return smth - it will be stored in LO byte of address)
-	if (m_MapperPtr->CPUReadIntercept(address, &local_address)) return (uint8_t)local_address;
+	if (dispatch_mapper([&](auto& mapper) { return mapper.CPUReadIntercept(address, &local_address); }))
+		return (uint8_t)local_address;
 
 	return m_PRGMemory[local_address];
 }
@@ -354,12 +448,33 @@ void NESCartrige::CPUWrite(uint16_t address, uint8_t data)
 {
 	if (!m_IsCartrigeReady || m_PRGChunksCount == 0) return;
 
+	// $6000-$7FFF : PRG RAM
+	if (m_IsRAMPresent && address >= 0x6000 && address <= 0x7FFF)
+	{
+		m_RAMMemory[address & 0x1FFF] = data;
+		return;
+	}
+
 	uint32_t local_address;
 
 	//Check for interception
-	if (m_MapperPtr->CPUWriteIntercept(address, &local_address, data)) return;
+	if (dispatch_mapper([&](auto& mapper) { return mapper.CPUWriteIntercept(address, &local_address, data); }))
+		return;
 
-	m_PRGMemory[local_address] = data;
+	//PRG ROM is read only (and shared), writes which reach it are dropped
+}
+
+bool NESCartrige::IsPPUAffectedByWrite(uint16_t address)
+{
+	if (!m_IsCartrigeReady) return false;
+	return dispatch_mapper([&](auto& mapper) { return mapper.IsPPUAffectedByWrite(address); });
+}
+
+bool NESCartrige::IsMemoryMapAffectedByWrite(uint16_t address, uint8_t data)
+{
+	if (!m_IsCartrigeReady || m_PRGChunksCount == 0) return false;
+	if (m_IsRAMPresent && address >= 0x6000 && address <= 0x7FFF) return false;
+	return dispatch_mapper([&](auto& mapper) { return mapper.IsMemoryMapAffectedByWrite(address, data); });
 }
 
 uint8_t NESCartrige::PPURead(uint16_t address)
@@ -370,7 +485,8 @@ uint8_t NESCartrige::PPURead(uint16_t address)
 
 	//Check for interception 
 	//(in case if mapper wants to return smth - it will be stored in LO byte of address)
-	if (m_MapperPtr->PPUReadIntercept(address, &local_address)) return (uint8_t)local_address;
+	if (dispatch_mapper([&](auto& mapper) { return mapper.PPUReadIntercept(address, &local_address); }))
+		return (uint8_t)local_address;
 
 	if (address <= 0x1FFF)
 	{
@@ -392,11 +508,13 @@ void NESCartrige::PPUWrite(uint16_t address, uint8_t data)
 	uint32_t local_address; 
 
 	//Check for interception
-	if (m_MapperPtr->PPUWriteIntercept(address, &local_address, data)) return;
+	if (dispatch_mapper([&](auto& mapper) { return mapper.PPUWriteIntercept(address, &local_address, data); }))
+		return;
 
-	if (address <= 0x1FFF) //CHR
+	if (address <= 0x1FFF && !m_IsCHRPresent) //CHR RAM (CHR ROM is read only)
 	{
-		m_CHRMemory[address] = data;
+		m_CHRRAM[address] = data;
+		NESROMImage::DecodeTileRow(m_CHRRAM.data(), address, m_CHRRAMTiles.data());
 	}
 
 	if (address <= 0x3FFF) //Ext. VRAM
@@ -409,5 +527,69 @@ bool NESCartrige::PPUInterceptVRAM(uint16_t address, uint16_t* out_address)
 {
 	*out_address = 0;
 	if (!m_IsCartrigeReady)	return false;
-	return m_MapperPtr->PPUInterceptVRAM(address, out_address);
+	return dispatch_mapper([&](auto& mapper) { return mapper.PPUInterceptVRAM(address, out_address); });
+}
+uint8_t* NESCartrige::GetCPUPage(uint16_t address)
+{
+	if (!m_IsCartrigeReady || m_PRGChunksCount == 0) return nullptr;
+
+	//PRG RAM is readable and writable
+	if (m_IsRAMPresent && address >= 0x6000 && address <= 0x7FFF)
+		return &m_RAMMemory[address & 0x1C00];
+
+	//Page is usable only if mapper maps whole page linearly into PRG
+	uint32_t first_address = 0;
+	uint32_t last_address = 0;
+	bool is_intercepted = dispatch_mapper([&](auto& mapper)
+		{
+			return mapper.CPUReadIntercept(address, &first_address) || mapper.CPUReadIntercept(address + 0x03FF, &last_address);
+		});
+	if (is_intercepted) return nullptr;
+	if (last_address != first_address + 0x03FF || last_address >= m_PRGSize) return nullptr;
+
+	//PRG ROM page is read only, device never writes through it
+	return const_cast<uint8_t*>(&m_PRGMemory[first_address]);
+}
+
+uint8_t* NESCartrige::GetCPUWritePage(uint16_t address)
+{
+	if (!m_IsCartrigeReady || m_PRGChunksCount == 0) return nullptr;
+	if (!m_IsRAMPresent || address < 0x6000 || address > 0x7FFF) return nullptr;
+	return &m_RAMMemory[address & 0x1C00];
+}
+
+uint8_t* NESCartrige::GetPPUPage(uint16_t address)
+{
+	if (!m_IsCartrigeReady || m_CHRChunksCount == 0 || address > 0x1FFF) return nullptr;
+
+	//Same as above, but for CHR
+	uint32_t first_address = 0;
+	uint32_t last_address = 0;
+	bool is_intercepted = dispatch_mapper([&](auto& mapper)
+		{
+			return mapper.PPUReadIntercept(address, &first_address) || mapper.PPUReadIntercept(address + 0x03FF, &last_address);
+		});
+	if (is_intercepted) return nullptr;
+	if (last_address != first_address + 0x03FF || last_address >= m_CHRSize) return nullptr;
+
+	//Read page only, CHR RAM writes go through PPUWrite
+	return const_cast<uint8_t*>(&m_CHRMemory[first_address]);
+}
+
+const uint8_t* NESCartrige::GetPPUTilePage(uint16_t address)
+{
+	uint8_t* page = this->GetPPUPage(address);
+	if (page == nullptr || m_CHRTiles == nullptr) return nullptr;
+	return &m_CHRTiles[(page - m_CHRMemory) * (NESROMImage::DecodedTileSize / 16)];
+}
+
+void NESCartrige::decode_chr_ram()
+{
+	m_CHRRAMTiles.assign((m_CHRRAM.size() / 16) * NESROMImage::DecodedTileSize, 0);
+	for (uint32_t address = 0; address < m_CHRRAM.size(); address += 16)
+	{
+		for (uint32_t row = 0; row < 8; row++)
+			NESROMImage::DecodeTileRow(m_CHRRAM.data(), address + row, m_CHRRAMTiles.data());
+	}
+	m_CHRTiles = m_CHRRAMTiles.data();
 }
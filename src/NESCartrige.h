@@ -7,6 +7,7 @@
 
 #include "NESState.h"
 #include "NESMapper.h"
+#include "NESROMImage.h"
 
 class NESCartrige
 {
@@ -17,13 +18,20 @@ public:
 	void ClearCartrige();
 	bool LoadCartrige(std::string file_name);
 	bool LoadDummyCartrige();
+	//Print ROM details when it's loaded (errors are printed always)
+	bool Verbose;
 
 	void Reset();
 	void Update();
+	//How often Update has to be called (see NESMapper::ClockMode)
+	NESMapper::ClockMode GetClockMode();
 	bool IsCartrigeReady();
 
 	bool SaveState(NESState& state);
 	bool LoadState(NESState& state);
+	//Copies cartrige into target, ROM image is shared (target picks it up if it had different one)
+	// only writable memory (PRG/CHR RAM) and mapper state are copied
+	void CloneInto(NESCartrige& target);
 
 	const std::string& GetROMName();
 	uint8_t			   GetMapperID();
@@ -31,6 +39,12 @@ public:
 
 	uint32_t  GetPRGChunksCount();
 	uint32_t  GetPRGSize();
+	//Whole PRG ROM image (nullptr if there is none)
+	const uint8_t* GetPRGMemory();
+	//Shared PRG/CHR ROM image (nullptr if nothing is loaded)
+	const NESROMImage* GetROMImage();
+	//Heap memory owned by this cartrige (bytes), shared ROM image isn't included
+	size_t GetMemoryFootprint();
 	uint32_t  GetCHRChunksCount();
 	uint32_t  GetCHRSize();
 	
@@ -38,6 +52,10 @@ public:
 	//CPU Bus RW operations
 	uint8_t CPURead(uint16_t address);
 	void    CPUWrite(uint16_t address, uint8_t data);
+	//True if cpu write may change CHR banks or mirroring
+	bool    IsPPUAffectedByWrite(uint16_t address);
+	//True if cpu write is going to switch banks or mirroring (device memory map has to be rebuilt after it)
+	bool    IsMemoryMapAffectedByWrite(uint16_t address, uint8_t data);
 
 	//PPU Buss RW operations
 	uint8_t PPURead(uint16_t address);
@@ -48,6 +66,16 @@ public:
 	// if false - read from instead VRAM by out_address
 	bool    PPUInterceptVRAM(uint16_t address,uint16_t* out_address);
 
+	//Direct pointers to 1KB pages of PRG/CHR memory currently mapped at (page aligned) address
+	// nullptr if page can't be accessed directly and has to go through CPURead/PPURead
+	uint8_t* GetCPUPage(uint16_t address);
+	//Same for cpu writes, only PRG RAM ($6000-$7FFF) can be written directly
+	uint8_t* GetCPUWritePage(uint16_t address);
+	uint8_t* GetPPUPage(uint16_t address);
+	//Decoded tiles (see NESROMImage::DecodedTileSize) of 1KB CHR page currently mapped at address,
+	// nullptr under the same conditions as GetPPUPage
+	const uint8_t* GetPPUTilePage(uint16_t address);
+
 private:
 	bool m_IsCartrigeReady;
 	std::string m_ROMName;
@@ -61,9 +89,27 @@ private:
 	bool m_IsRAMPresent;
 	bool m_IsCHRPresent;
 
+	//8KB PRG RAM at $6000-$7FFF (if present)
 	std::vector<uint8_t> m_RAMMemory;
-	std::vector<uint8_t> m_PRGMemory;
-	std::vector<uint8_t> m_CHRMemory;
+
+	//PRG and CHR ROM live in image shared by every cartrige which loaded the same file,
+	// CHR memory points either into image or to per-cartrige CHR RAM
+	std::shared_ptr<const NESROMImage> m_ROMImage;
+	const uint8_t* m_PRGMemory;
+	uint32_t	   m_PRGSize;
+	const uint8_t* m_CHRMemory;
+	uint32_t	   m_CHRSize;
+	std::vector<uint8_t> m_CHRRAM;
+	//Decoded CHR tiles, either in image or CHR RAM tiles kept up to date by PPUWrite
+	const uint8_t* m_CHRTiles;
+	std::vector<uint8_t> m_CHRRAMTiles;
 
 	std::unique_ptr<NESMapper> m_MapperPtr;
+
+	//Calls fn with mapper casted to its final type (selected by mapper id), so mapper
+	// functions can be inlined into bus path. Mappers not listed there are called through NESMapper interface
+	template<typename Fn> auto dispatch_mapper(Fn&& fn);
+
+	//Decodes whole CHR RAM into m_CHRRAMTiles
+	void decode_chr_ram();
 };
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "NESCompositor.h"
+
+#ifdef NES_COMPOSITOR_SIMD
+#include <immintrin.h>
+#define NES_COMPOSITOR_SSE41_FN __attribute__((target("sse4.1")))
+#define NES_COMPOSITOR_AVX2_FN __attribute__((target("avx2")))
+#endif
+
+NESCompositor::Kernel NESCompositor::GetBestKernel()
+{
+	if (IsSupported(Kernel::AVX2)) return Kernel::AVX2;
+	if (IsSupported(Kernel::SSE41)) return Kernel::SSE41;
+	return Kernel::Scalar;
+}
+
+bool NESCompositor::IsSupported(Kernel kernel)
+{
+	switch (kernel)
+	{
+	case Kernel::Scalar: return true;
+#ifdef NES_COMPOSITOR_SIMD
+	case Kernel::SSE41:	 return __builtin_cpu_supports("sse4.1") != 0;
+	case Kernel::AVX2:	 return __builtin_cpu_supports("avx2") != 0;
+#endif
+	default:			 return false;
+	}
+}
+
+const char* NESCompositor::GetKernelName(Kernel kernel)
+{
+	switch (kernel)
+	{
+	case Kernel::Scalar: return "scalar";
+	case Kernel::SSE41:	 return "sse4.1";
+	case Kernel::AVX2:	 return "avx2";
+	default:			 return "unknown";
+	}
+}
+
+uint32_t NESCompositor::ComposeLine(Kernel kernel, const uint8_t* background, const uint8_t* sprites,
+	const uint8_t* behind, const uint8_t* zero, uint8_t* output, uint32_t count)
+{
+#ifdef NES_COMPOSITOR_SIMD
+	if (kernel == Kernel::AVX2) return compose_avx2(background, sprites, behind, zero, output, count);
+	if (kernel == Kernel::SSE41) return compose_sse41(background, sprites, behind, zero, output, count);
+#endif
+	return compose_scalar(background, sprites, behind, zero, output, count);
+}
+
+uint32_t NESCompositor::compose_scalar(const uint8_t* background, const uint8_t* sprites, const uint8_t* behind, const uint8_t* zero, uint8_t* output, uint32_t count)
+{
+	uint32_t hit = count;
+	for (uint32_t x = 0; x < count; x++)
+	{
+		uint8_t pixel = background[x];
+		if (sprites[x] & 0x03)
+		{
+			if ((pixel & 0x03) && zero[x] && hit == count)
+				hit = x;
+			if (!(pixel & 0x03) || !behind[x])
+				pixel = sprites[x];
+		}
+		output[x] = (pixel & 0x03) ? pixel : 0x00;
+	}
+	return hit;
+}
+
+#ifdef NES_COMPOSITOR_SIMD
+//Same steps as scalar code, every condition is byte mask
+NES_COMPOSITOR_SSE41_FN uint32_t NESCompositor::compose_sse41(const uint8_t* background, const uint8_t* sprites, const uint8_t* behind, const uint8_t* zero, uint8_t* output, uint32_t count)
+{
+	const __m128i color_mask = _mm_set1_epi8(0x03);
+	const __m128i zeroes = _mm_setzero_si128();
+
+	uint32_t hit = count;
+	for (uint32_t x = 0; x < count; x += 16)
+	{
+		const __m128i bg = _mm_loadu_si128((const __m128i*)&background[x]);
+		const __m128i sp = _mm_loadu_si128((const __m128i*)&sprites[x]);
+		const __m128i is_behind = _mm_loadu_si128((const __m128i*)&behind[x]);
+		const __m128i is_zero = _mm_loadu_si128((const __m128i*)&zero[x]);
+
+		const __m128i bg_clear = _mm_cmpeq_epi8(_mm_and_si128(bg, color_mask), zeroes);
+		const __m128i sp_clear = _mm_cmpeq_epi8(_mm_and_si128(sp, color_mask), zeroes);
+
+		//Opaque sprite 0 over opaque background
+		const __m128i hits = _mm_andnot_si128(_mm_or_si128(bg_clear, sp_clear), is_zero);
+		const uint32_t hit_bits = (uint32_t)_mm_movemask_epi8(hits);
+		if (hit_bits != 0 && hit == count)
+			hit = x + __builtin_ctz(hit_bits);
+
+		//Opaque sprite over transparent background or in front of it
+		const __m128i use_sprite = _mm_andnot_si128(sp_clear, _mm_or_si128(bg_clear, _mm_cmpeq_epi8(is_behind, zeroes)));
+		const __m128i pixel = _mm_blendv_epi8(bg, sp, use_sprite);
+		const __m128i pixel_clear = _mm_cmpeq_epi8(_mm_and_si128(pixel, color_mask), zeroes);
+		_mm_storeu_si128((__m128i*)&output[x], _mm_andnot_si128(pixel_clear, pixel));
+	}
+	return hit;
+}
+
+NES_COMPOSITOR_AVX2_FN uint32_t NESCompositor::compose_avx2(const uint8_t* background, const uint8_t* sprites, const uint8_t* behind, const uint8_t* zero, uint8_t* output, uint32_t count)
+{
+	const __m256i color_mask = _mm256_set1_epi8(0x03);
+	const __m256i zeroes = _mm256_setzero_si256();
+
+	uint32_t hit = count;
+	for (uint32_t x = 0; x < count; x += 32)
+	{
+		const __m256i bg = _mm256_loadu_si256((const __m256i*)&background[x]);
+		const __m256i sp = _mm256_loadu_si256((const __m256i*)&sprites[x]);
+		const __m256i is_behind = _mm256_loadu_si256((const __m256i*)&behind[x]);
+		const __m256i is_zero = _mm256_loadu_si256((const __m256i*)&zero[x]);
+
+		const __m256i bg_clear = _mm256_cmpeq_epi8(_mm256_and_si256(bg, color_mask), zeroes);
+		const __m256i sp_clear = _mm256_cmpeq_epi8(_mm256_and_si256(sp, color_mask), zeroes);
+
+		const __m256i hits = _mm256_andnot_si256(_mm256_or_si256(bg_clear, sp_clear), is_zero);
+		const uint32_t hit_bits = (uint32_t)_mm256_movemask_epi8(hits);
+		if (hit_bits != 0 && hit == count)
+			hit = x + __builtin_ctz(hit_bits);
+
+		const __m256i use_sprite = _mm256_andnot_si256(sp_clear, _mm256_or_si256(bg_clear, _mm256_cmpeq_epi8(is_behind, zeroes)));
+		const __m256i pixel = _mm256_blendv_epi8(bg, sp, use_sprite);
+		const __m256i pixel_clear = _mm256_cmpeq_epi8(_mm256_and_si256(pixel, color_mask), zeroes);
+		_mm256_storeu_si256((__m256i*)&output[x], _mm256_andnot_si256(pixel_clear, pixel));
+	}
+	return hit;
+}
+#endif
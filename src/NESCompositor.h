@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+//SSE4.1/AVX2 kernels need x86-64 host (and cpu support checked at runtime),
+// everywhere else lines are composed by scalar code
+#if (defined(__x86_64__) || defined(_M_X64)) && (defined(__GNUC__) || defined(__clang__))
+#define NES_COMPOSITOR_SIMD
+#endif
+
+//Composition of background and sprite layers of scanline into palette RAM indices,
+// the same rules as dot renderer applies pixel by pixel (NESPPU::render_pixel):
+// opaque sprite wins over transparent background or if it has front priority,
+// opaque sprite 0 over opaque background is sprite 0 hit, transparent result is backdrop (index 0)
+class NESCompositor
+{
+public:
+	enum class Kernel : uint32_t
+	{
+		Scalar,
+		SSE41,
+		AVX2,
+
+		Count
+	};
+
+	//Fastest kernel host supports
+	static Kernel GetBestKernel();
+	static bool IsSupported(Kernel kernel);
+	static const char* GetKernelName(Kernel kernel);
+
+	//Composes 'count' pixels (multiple of 32), every line is byte per pixel
+	// background - palette index of background (palette << 2 | color), color 0 is transparent
+	// sprites    - palette index of sprite (0x10 | palette << 2 | color), color 0 (or 0) - no sprite
+	// behind     - 0xFF where sprite is behind background (priority bit), 0 otherwise
+	// zero       - 0xFF where sprite counts for sprite 0 hit, 0 otherwise
+	// output     - palette RAM index of pixel
+	// returns position of first sprite 0 hit, 'count' if there is none
+	static uint32_t ComposeLine(Kernel kernel, const uint8_t* background, const uint8_t* sprites,
+		const uint8_t* behind, const uint8_t* zero, uint8_t* output, uint32_t count);
+
+protected:
+	static uint32_t compose_scalar(const uint8_t* background, const uint8_t* sprites, const uint8_t* behind, const uint8_t* zero, uint8_t* output, uint32_t count);
+#ifdef NES_COMPOSITOR_SIMD
+	static uint32_t compose_sse41(const uint8_t* background, const uint8_t* sprites, const uint8_t* behind, const uint8_t* zero, uint8_t* output, uint32_t count);
+	static uint32_t compose_avx2(const uint8_t* background, const uint8_t* sprites, const uint8_t* behind, const uint8_t* zero, uint8_t* output, uint32_t count);
+#endif
+};
@@ -2,7 +2,8 @@
 
 NESDevice::NESDevice() :
 	m_CPU(this),
-	m_PPU(this)
+	m_PPU(this),
+	m_JIT(this, m_CPUReadPages, m_CPUWritePages)
 {
 
 	//NTSC : 12/4 [3/1]
@@ -10,6 +11,14 @@ NESDevice::NESDevice() :
 	CPUCycleDivider = 3;
 	PPUCycleDivider = 1;
 
+	ExecutionMode = ExecutionMode::PerInstruction;
+	IdleLoopSkipping = true;
+	InstructionFusion = true;
+	ScanlineRendering = true;
+	JITEnabled = false;
+	StaticCodeEnabled = true;
+	m_StaticCode = nullptr;
+
 	this->Reset();
 	DeviceMode = DeviceMode::Pause;
 }
@@ -29,6 +38,17 @@ void NESDevice::Reset()
 	CPUMasterCycle = 0;
 	PPUMasterCycle = 0;
 
+	m_Scheduler.Reset();
+	m_IsCPUAhead = false;
+	m_IsFrameCompleted = false;
+	m_CPUTimestamp = 0;
+	m_StepTimestamp = 0;
+	m_StepCycle = 0;
+
+	IdleLoopCyclesSkipped = 0;
+	StaticCodeInstructions = 0;
+	m_IsIdleLoopTracked = false;
+
 	//Clear memory
 	//cpu bus
 	memset(m_RAM, 0, 0x0800);
@@ -36,9 +56,36 @@ void NESDevice::Reset()
 	//ppu bus
 	memset(m_VRAM, 0, 0x0800);
 
+	//Cartrige goes first, cpu reads reset vector through memory map
+	m_Cartrige.Reset();
+	this->UpdateMemoryMap();
+	m_MapperClockMode = m_Cartrige.GetClockMode();
+	m_PPUA12 = false;
+	//PRG memory may have been reloaded, compiled code is stale
+	m_JIT.Reset();
+	//Recompiled code is valid only for exactly the same PRG ROM and fixed mapping
+	m_StaticCode = nullptr;
+	m_StaticEntries.clear();
+	if (m_Cartrige.IsCartrigeReady() && m_Cartrige.GetMapperID() == 0)
+		m_StaticCode = NESStaticCode::Find(m_Cartrige.GetPRGMemory(), m_Cartrige.GetPRGSize());
+	if (m_StaticCode != nullptr)
+	{
+		m_StaticEntries.resize(0x8000);
+		for (uint32_t block = 0; block < m_StaticCode->BlockCount; block++)
+		{
+			const NESStaticBlock& static_block = m_StaticCode->Blocks[block];
+			for (uint16_t index = 0; index < static_block.Count; index++)
+			{
+				if (static_block.PC[index] < 0x8000) continue;
+				StaticEntry& entry = m_StaticEntries[static_block.PC[index] - 0x8000];
+				entry.Block = &static_block;
+				entry.Index = index;
+			}
+		}
+	}
+
 	m_CPU.Reset();
 	m_PPU.Reset();
-	m_Cartrige.Reset();
 	m_Controller.Reset();
 
 	//Debug palette
@@ -68,8 +115,42 @@ NESController& NESDevice::GetController()
 	return m_Controller;
 }
 
+NESScheduler& NESDevice::GetScheduler()
+{
+	return m_Scheduler;
+}
+
+NESJIT& NESDevice::GetJIT()
+{
+	return m_JIT;
+}
+
+void NESDevice::SetLeanMode(bool lean)
+{
+	m_PPU.SetDebugBuffersEnabled(!lean);
+}
+
+size_t NESDevice::GetMemoryFootprint()
+{
+	return sizeof(NESDevice) +
+		m_CPU.GetMemoryFootprint() +
+		m_PPU.GetMemoryFootprint() +
+		m_Cartrige.GetMemoryFootprint() +
+		m_JIT.GetMemoryFootprint() +
+		m_StaticEntries.capacity() * sizeof(StaticEntry);
+}
+
+const NESStaticCode* NESDevice::GetStaticCode()
+{
+	return m_StaticCode;
+}
+
 uint8_t NESDevice::CPURead(uint16_t address)
 {
+	//Plain memory goes directly through page table
+	uint8_t* page = m_CPUReadPages[address >> 10];
+	if (page) return page[address & 0x03FF];
+
 	// $0000$07FF : 2KB Internal RAM
 	// $0800-$1FFF : Mirror of $0000$07FF
 	if (address <= 0x1FFF)
@@ -81,6 +162,8 @@ uint8_t NESDevice::CPURead(uint16_t address)
 	// $2008-$3FFF : Mirrors of $2000$2007 (repeats every 8 bytes) 
 	if (address <= 0x3FFF)
 	{
+		//PPU must be up to date before register access
+		if (m_IsCPUAhead) CatchUp(CPUTimestamp());
 		return m_PPU.CPURead(address);
 	}
 
@@ -103,6 +186,13 @@ uint8_t NESDevice::CPURead(uint16_t address)
 
 void NESDevice::CPUWrite(uint16_t address, uint8_t data)
 {
+	uint8_t* page = m_CPUWritePages[address >> 10];
+	if (page)
+	{
+		page[address & 0x03FF] = data;
+		return;
+	}
+
 	// $0000$07FF : 2KB Internal RAM
 	// $0800-$1FFF : Mirror of $0000$07FF
 	if (address <= 0x1FFF)
@@ -115,6 +205,16 @@ void NESDevice::CPUWrite(uint16_t address, uint8_t data)
 	// $2008-$3FFF : Mirrors of $2000$2007 (repeats every 8 bytes) 
 	if (address <= 0x3FFF)
 	{
+		//PPU must be up to date before register access
+		if (m_IsCPUAhead)
+		{
+			CatchUp(CPUTimestamp());
+			m_PPU.CPUWrite(address, data);
+			//PPUMASK affects odd frame skip - events have to be rescheduled
+			if ((address & 0x0007) == 0x0001)
+				SchedulePPUEvents();
+			return;
+		}
 		m_PPU.CPUWrite(address, data);
 		return;
 	}
@@ -141,11 +241,104 @@ void NESDevice::CPUWrite(uint16_t address, uint8_t data)
 	}
 
 	// $4020-$FFFF : Cartrige space
-	return m_Cartrige.CPUWrite(address, data);
+	//Mapper may switch banks or mirroring used by PPU
+	if (m_IsCPUAhead && m_Cartrige.IsPPUAffectedByWrite(address)) CatchUp(CPUTimestamp());
+	//Has to be asked before the write, mapper state changes with it
+	const bool is_map_affected = m_Cartrige.IsMemoryMapAffectedByWrite(address, data);
+	m_Cartrige.CPUWrite(address, data);
+	if (is_map_affected) this->UpdateMemoryMap();
+}
+
+bool NESDevice::OAMDMA(uint16_t address, uint32_t cycles)
+{
+	//Only when cpu runs ahead, per-cycle mode always goes through bus
+	if (!m_IsCPUAhead) return false;
+
+	const uint8_t* page = m_CPUReadPages[address >> 10];
+	if (page == nullptr) return false;
+
+	CatchUp(CPUTimestamp());
+	if (!m_PPU.IsOAMIdle(cycles * CPUCycleDivider / PPUCycleDivider)) return false;
+
+	m_PPU.WriteOAM(&page[address & 0x03FF]);
+	return true;
+}
+
+const uint8_t* NESDevice::GetCPUROM(uint16_t address)
+{
+	const uint8_t* page = m_CPUReadPages[address >> 10];
+	if (page == nullptr || m_CPUWritePages[address >> 10] != nullptr) return nullptr;
+	return &page[address & 0x03FF];
+}
+
+const uint8_t* NESDevice::GetPPUTile(uint16_t address)
+{
+	if (address > 0x1FFF) return nullptr;
+	const uint8_t* page = m_PPUTilePages[address >> 10];
+	if (page == nullptr) return nullptr;
+	return &page[((address & 0x03FF) >> 4) * NESROMImage::DecodedTileSize];
+}
+
+uint8_t* NESDevice::GetRAM()
+{
+	return m_RAM;
+}
+
+void NESDevice::BeginFrame()
+{
+	m_CPUTimestamp = DeviceCycle + CPUMasterCycle;
+	SchedulePPUEvents();
+}
+
+bool NESDevice::StepInstruction()
+{
+	this->InstructionCycle();
+	if (!m_IsFrameCompleted) return false;
+	m_IsFrameCompleted = false;
+	return true;
+}
+
+uint32_t NESDevice::ExternalCPUBudget()
+{
+	//Only on plain instruction boundary, interrupts and DMA are handled by interpreter
+	if (m_CPU.State.Halted || !m_CPU.IsReady() || m_CPU.State.DMATransfer || m_CPU.State.DMARequest || m_CPU.State.NMIRequest ||
+		(m_CPU.State.IRQRequest && !m_CPU.getFlag(NESCPU::SRFlag::InterruptBit)) ||
+		m_MapperClockMode == NESMapper::ClockMode::CPUCycle)
+		return 0;
+
+	//Idle loops go through InstructionCycle, so they are detected and skipped
+	if (IdleLoopSkipping && (m_IsIdleLoopTracked || m_CPU.DetectIdleLoop(m_CPU.Registers.PC) != 0))
+		return 0;
+
+	const uint64_t event_timestamp = m_Scheduler.NextTimestamp();
+	const uint64_t event_cycles = (event_timestamp > m_CPUTimestamp) ? (event_timestamp - m_CPUTimestamp) / CPUCycleDivider : 0;
+	return (event_cycles > UINT32_MAX) ? UINT32_MAX : (uint32_t)event_cycles;
+}
+
+bool NESDevice::ExternalCPUCycles(uint32_t cycles)
+{
+	m_CPU.State.CyclesTotal += cycles;
+	this->CompleteInstruction(cycles);
+	if (!m_IsFrameCompleted) return false;
+	m_IsFrameCompleted = false;
+	return true;
 }
 
 uint8_t NESDevice::PPURead(uint16_t address)
 {
+	if (m_MapperClockMode == NESMapper::ClockMode::PPUA12)
+	{
+		bool a12 = (address & 0x1000) != 0;
+		if (a12 && !m_PPUA12) m_Cartrige.Update();
+		m_PPUA12 = a12;
+	}
+
+	if (address <= 0x3FFF)
+	{
+		uint8_t* page = m_PPUReadPages[address >> 10];
+		if (page) return page[address & 0x03FF];
+	}
+
 	// $0000$0FFF : Pattern table 0 
 	// $1000$1FFF : Pattern table 1 
 	if (address <= 0x1FFF)
@@ -187,6 +380,16 @@ uint8_t NESDevice::PPURead(uint16_t address)
 
 void NESDevice::PPUWrite(uint16_t address, uint8_t data)
 {
+	if (address <= 0x3FFF)
+	{
+		uint8_t* page = m_PPUWritePages[address >> 10];
+		if (page)
+		{
+			page[address & 0x03FF] = data;
+			return;
+		}
+	}
+
 	// $0000$0FFF : Pattern table 0 
 	// $1000$1FFF : Pattern table 1 
 	if (address <= 0x1FFF)
@@ -277,6 +480,10 @@ uint8_t NESDevice::PPUPeek(uint16_t address)
 
 void NESDevice::Update()
 {
+	//PPU state may be changed by anything between updates (per-cycle modes, savestates, debugger)
+	if (DeviceMode == DeviceMode::Running && ExecutionMode == ExecutionMode::PerInstruction)
+		this->BeginFrame();
+
 	bool IsRunning = true;
 	while (IsRunning)
 	{
@@ -287,12 +494,24 @@ void NESDevice::Update()
 				break;
 
 			case DeviceMode::Running: // --------------------------------- Normal mode
-				this->MasterCycle();
-				if (m_PPU.IsFrameReady())
+				if (ExecutionMode == ExecutionMode::PerInstruction)
 				{
-					//Drain resedue cycles
-					while (PPUMasterCycle) { this->MasterCycle(); }
-					IsRunning = false;
+					this->InstructionCycle();
+					if (m_IsFrameCompleted)
+					{
+						m_IsFrameCompleted = false;
+						IsRunning = false;
+					}
+				}
+				else
+				{
+					this->MasterCycle();
+					if (m_PPU.IsFrameReady())
+					{
+						//Drain resedue cycles
+						while (PPUMasterCycle) { this->MasterCycle(); }
+						IsRunning = false;
+					}
 				}
 				break;
 	
@@ -373,6 +592,69 @@ bool NESDevice::LoadState(NESState& state)
 	if (!m_PPU.LoadState(state)) return false;
 	if (!m_Cartrige.LoadState(state)) return false;
 
+	this->UpdateMemoryMap();
+	m_IsIdleLoopTracked = false;
+
+	return true;
+}
+
+bool NESDevice::CloneInto(NESDevice& target, bool include_framebuffer)
+{
+	if (&target == this) return false;
+
+	const bool is_rom_changed = target.m_Cartrige.GetROMImage() != m_Cartrige.GetROMImage();
+
+	target.DeviceMode = DeviceMode;
+	target.ExecutionMode = ExecutionMode;
+	target.IdleLoopSkipping = IdleLoopSkipping;
+	target.IdleLoopCyclesSkipped = IdleLoopCyclesSkipped;
+	target.InstructionFusion = InstructionFusion;
+	target.ScanlineRendering = ScanlineRendering;
+	target.JITEnabled = JITEnabled;
+	target.StaticCodeEnabled = StaticCodeEnabled;
+	target.StaticCodeInstructions = StaticCodeInstructions;
+
+	target.DeviceCycle = DeviceCycle;
+	target.CPUCycleDivider = CPUCycleDivider;
+	target.CPUMasterCycle = CPUMasterCycle;
+	target.PPUCycleDivider = PPUCycleDivider;
+	target.PPUMasterCycle = PPUMasterCycle;
+
+	target.m_IsCPUAhead = m_IsCPUAhead;
+	target.m_IsFrameCompleted = m_IsFrameCompleted;
+	target.m_CPUTimestamp = m_CPUTimestamp;
+	target.m_StepTimestamp = m_StepTimestamp;
+	target.m_StepCycle = m_StepCycle;
+	target.m_MapperClockMode = m_MapperClockMode;
+	target.m_PPUA12 = m_PPUA12;
+
+	target.m_IsIdleLoopTracked = m_IsIdleLoopTracked;
+	target.m_IdleLoopLength = m_IdleLoopLength;
+	target.m_IdleLoopSteps = m_IdleLoopSteps;
+	target.m_IdleLoopCycle = m_IdleLoopCycle;
+	target.m_IdleLoopEvent = m_IdleLoopEvent;
+	target.m_IdleLoopRegisters = m_IdleLoopRegisters;
+
+	memcpy(target.m_RAM, m_RAM, sizeof(m_RAM));
+	memcpy(target.m_AuxRegisters, m_AuxRegisters, sizeof(m_AuxRegisters));
+	memcpy(target.m_VRAM, m_VRAM, sizeof(m_VRAM));
+
+	m_CPU.CloneInto(target.m_CPU);
+	m_PPU.CloneInto(target.m_PPU, include_framebuffer);
+	m_Cartrige.CloneInto(target.m_Cartrige);
+	target.m_Controller = m_Controller;
+	target.m_Scheduler = m_Scheduler;
+
+	//Cached code is tagged by pointers into ROM image, previous image may be gone
+	if (is_rom_changed)
+	{
+		target.m_CPU.FlushDecodeCache();
+		target.m_JIT.Reset();
+		target.m_StaticCode = m_StaticCode;
+		target.m_StaticEntries = m_StaticEntries;
+	}
+
+	target.UpdateMemoryMap();
 	return true;
 }
 
@@ -385,17 +667,26 @@ void NESDevice::MasterCycle()
 		m_CPU.Update();
 	}
 
+	this->PeripheralCycle();
+}
+
+void NESDevice::PeripheralCycle()
+{
 	// ******** PPU ********
 	if (PPUMasterCycle == 0)
 	{
 		m_PPU.Update();
+		if (m_MapperClockMode == NESMapper::ClockMode::Scanline && m_PPU.IsLineReady())
+			m_Cartrige.Update();
 	}
 	// ******** APU ********
 		/* TODO */
 
 	// ******** PERIPHERALS ********
 	m_Controller.Update();
-	m_Cartrige.Update(); //CARTRIGE (Mapper and stuff)
+	//CARTRIGE (Mapper and stuff), only if mapper counts cpu cycles
+	if (m_MapperClockMode == NESMapper::ClockMode::CPUCycle && CPUMasterCycle == 0)
+		m_Cartrige.Update();
 
 
 	// ******** INTERNAL COMMUNICATIONS ********
@@ -428,3 +719,322 @@ void NESDevice::MasterCycle()
 	DeviceCycle++;
 }
 
+void NESDevice::InstructionCycle()
+{
+	//CPU runs ahead of the rest of device, PPU is brought up to date
+	// only on access (see CPURead/CPUWrite) or when scheduled event is due
+	if (IdleLoopSkipping)
+		this->SkipIdleLoop();
+
+	m_StepTimestamp = m_CPUTimestamp;
+	m_StepCycle = m_CPU.State.CyclesTotal;
+
+	m_IsCPUAhead = true;
+	uint32_t cycles = 0;
+	//Compiled block (or fused instruction pair) runs only if it can't pass next event, so nothing
+	// has to be synced inside of it (tracked idle loop is left to interpreter, tracking counts single instructions)
+	uint32_t budget = 0;
+	if (!(IdleLoopSkipping && m_IsIdleLoopTracked) && m_MapperClockMode != NESMapper::ClockMode::CPUCycle)
+	{
+		const uint64_t event_timestamp = m_Scheduler.NextTimestamp();
+		const uint64_t event_cycles = (event_timestamp > m_CPUTimestamp) ? (event_timestamp - m_CPUTimestamp) / CPUCycleDivider : 0;
+		budget = (event_cycles > UINT32_MAX) ? UINT32_MAX : (uint32_t)event_cycles;
+	}
+	if (budget != 0 && StaticCodeEnabled && m_StaticCode != nullptr)
+		cycles = this->RunStaticCode(budget);
+	if (budget != 0 && cycles == 0 && JITEnabled)
+		cycles = m_JIT.Run(budget);
+	if (cycles == 0)
+		cycles = m_CPU.Step(InstructionFusion ? budget : 0);
+	m_IsCPUAhead = false;
+
+	this->CompleteInstruction(cycles);
+}
+
+void NESDevice::CompleteInstruction(uint32_t cycles)
+{
+	m_CPUTimestamp += (uint64_t)cycles * CPUCycleDivider;
+
+	if (m_MapperClockMode == NESMapper::ClockMode::CPUCycle)
+	{
+		for (uint32_t cycle = 0; cycle < cycles; cycle++)
+			m_Cartrige.Update();
+	}
+
+	//Interrupts are checked at the start of next instruction
+	// so everything scheduled before it has to be processed now,
+	// device is also fully synced before leaving Update (frame may complete on access)
+	if (m_Scheduler.NextTimestamp() < m_CPUTimestamp || m_IsFrameCompleted || m_CPU.State.Halted)
+	{
+		CatchUp(m_CPUTimestamp);
+		CPUMasterCycle = 0;
+	}
+
+	//Force pause if cpu is halted
+	if (m_CPU.State.Halted)
+	{
+		DeviceMode = DeviceMode::Pause; //Fallback to pause
+	}
+}
+
+uint32_t NESDevice::RunStaticCode(uint32_t max_cycles)
+{
+	//Only on plain instruction boundary, interrupts and DMA are handled by interpreter
+	if (m_CPU.State.Halted || !m_CPU.IsReady() || m_CPU.State.DMATransfer || m_CPU.State.DMARequest || m_CPU.State.NMIRequest ||
+		(m_CPU.State.IRQRequest && !m_CPU.getFlag(NESCPU::SRFlag::InterruptBit)))
+		return 0;
+
+	const uint16_t address = m_CPU.Registers.PC;
+	if (address < 0x8000) return 0;
+	const StaticEntry& entry = m_StaticEntries[address - 0x8000];
+	if (entry.Block == nullptr || entry.Block->MaxCycles[entry.Index] > max_cycles) return 0;
+
+	const NESStaticBlock& block = *entry.Block;
+	NESStaticContext context;
+	context.ReadPages = m_CPUReadPages;
+	context.WritePages = m_CPUWritePages;
+	context.RAM = m_RAM;
+	context.Executed = 0;
+	context.Cycles = 0;
+	context.LastCycles = 0;
+	context.PC = address;
+	context.AC = m_CPU.Registers.AC;
+	context.XR = m_CPU.Registers.XR;
+	context.YR = m_CPU.Registers.YR;
+	m_CPU.SyncFlags();
+	context.SR = m_CPU.Registers.SR;
+	context.SP = m_CPU.Registers.SP;
+
+	block.Fn(context, entry.Index);
+	const uint32_t executed = context.Executed;
+	if (executed == 0) return 0;
+
+	const uint32_t last = entry.Index + executed - 1;
+	m_CPU.Registers.AC = context.AC;
+	m_CPU.Registers.XR = context.XR;
+	m_CPU.Registers.YR = context.YR;
+	m_CPU.Registers.SR = context.SR;
+	m_CPU.Registers.SP = context.SP;
+	m_CPU.Registers.PC = (last + 1 < block.Count) ? block.PC[last + 1] : context.PC;
+
+	//Leave cpu state as if interpreter executed the same instructions
+	for (uint32_t index = entry.Index + (executed > 8 ? executed - 8 : 0); index <= last; index++)
+	{
+		memmove(m_CPU.State.LastOperations, &m_CPU.State.LastOperations[1], sizeof(uint16_t) * 7);
+		m_CPU.State.LastOperations[7] = block.PC[index];
+	}
+	m_CPU.State.CurrentOpCode = block.OpCode[last];
+	m_CPU.State.CurrentAddrMode = m_CPU.GetInstructionMode(block.OpCode[last]);
+	m_CPU.State.CycleCounter = (uint8_t)context.LastCycles;
+	m_CPU.State.CyclesTotal += context.Cycles;
+
+	StaticCodeInstructions += executed;
+	return context.Cycles;
+}
+
+void NESDevice::SkipIdleLoop()
+{
+	struct NESCPU::Registers& registers = m_CPU.Registers;
+
+	//Anything pending would break out of loop
+	bool is_interrupted =
+		!m_CPU.IsReady() ||
+		m_CPU.State.DMARequest ||
+		m_CPU.State.NMIRequest ||
+		(m_CPU.State.IRQRequest && !m_CPU.getFlag(NESCPU::SRFlag::InterruptBit)) ||
+		m_MapperClockMode == NESMapper::ClockMode::CPUCycle;
+
+	if (is_interrupted)
+	{
+		m_IsIdleLoopTracked = false;
+		return;
+	}
+
+	if (m_IsIdleLoopTracked)
+	{
+		//Registers are compared as whole
+		m_CPU.SyncFlags();
+		m_IdleLoopSteps++;
+		if (registers.PC != m_IdleLoopRegisters.PC)
+		{
+			//Still inside of loop body
+			if (m_IdleLoopSteps < m_IdleLoopLength) return;
+			m_IsIdleLoopTracked = false;
+		}
+		else if (m_IdleLoopSteps != m_IdleLoopLength ||
+			m_IdleLoopEvent != m_Scheduler.NextTimestamp() ||
+			registers.AC != m_IdleLoopRegisters.AC ||
+			registers.XR != m_IdleLoopRegisters.XR ||
+			registers.YR != m_IdleLoopRegisters.YR ||
+			registers.SR != m_IdleLoopRegisters.SR ||
+			registers.SP != m_IdleLoopRegisters.SP)
+		{
+			m_IsIdleLoopTracked = false;
+		}
+		else
+		{
+			//Whole iteration changed nothing - every next one will do the same until event happens
+			// last iteration before event is executed normally (reads near vblank have to be precise)
+			const uint32_t cycles = m_CPU.State.CyclesTotal - m_IdleLoopCycle;
+			const uint64_t iteration = (uint64_t)cycles * CPUCycleDivider;
+			const uint64_t event_timestamp = m_Scheduler.NextTimestamp();
+
+			if (cycles != 0 && event_timestamp != NESScheduler::Never && event_timestamp > m_CPUTimestamp + iteration * 2)
+			{
+				const uint64_t iterations = (event_timestamp - m_CPUTimestamp) / iteration - 1;
+				m_CPU.State.CyclesTotal += (uint32_t)(iterations * cycles);
+				m_CPUTimestamp += iterations * iteration;
+				IdleLoopCyclesSkipped += iterations * cycles;
+			}
+
+			m_IdleLoopSteps = 0;
+			m_IdleLoopCycle = m_CPU.State.CyclesTotal;
+			m_IdleLoopEvent = m_Scheduler.NextTimestamp();
+			return;
+		}
+	}
+
+	//New candidate
+	m_IdleLoopLength = m_CPU.DetectIdleLoop(registers.PC);
+	if (m_IdleLoopLength)
+	{
+		m_IsIdleLoopTracked = true;
+		m_IdleLoopSteps = 0;
+		m_IdleLoopCycle = m_CPU.State.CyclesTotal;
+		m_IdleLoopEvent = m_Scheduler.NextTimestamp();
+		m_CPU.SyncFlags();
+		m_IdleLoopRegisters = registers;
+	}
+}
+
+void NESDevice::CatchUp(uint64_t device_cycle)
+{
+	while (DeviceCycle < device_cycle)
+	{
+		//Run PPU without interruptions up to requested cycle or next event
+		const uint64_t event_timestamp = m_Scheduler.NextTimestamp();
+		const uint64_t batch_end = (event_timestamp < device_cycle) ? event_timestamp + 1 : device_cycle;
+
+		//Scanline clocked mappers need to see every completed line
+		if (PPUCycleDivider == 1 && m_MapperClockMode != NESMapper::ClockMode::Scanline)
+		{
+			//A12 clocked mappers count ppu bus accesses, which have to come in exact order
+			m_PPU.Run((uint32_t)(batch_end - DeviceCycle), ScanlineRendering && m_MapperClockMode != NESMapper::ClockMode::PPUA12);
+			DeviceCycle = batch_end;
+		}
+		else while (DeviceCycle < batch_end)
+		{
+			if (PPUMasterCycle == 0)
+			{
+				m_PPU.Update();
+				if (m_MapperClockMode == NESMapper::ClockMode::Scanline && m_PPU.IsLineReady())
+					m_Cartrige.Update();
+				PPUMasterCycle = PPUCycleDivider;
+			}
+			PPUMasterCycle--;
+			DeviceCycle++;
+		}
+
+		//Process everything that happened during batch
+		NESScheduler::Event event;
+		while (m_Scheduler.PopEvent(DeviceCycle - 1, &event))
+			ProcessEvent(event);
+	}
+}
+
+uint64_t NESDevice::CPUTimestamp()
+{
+	return m_StepTimestamp + (uint64_t)(m_CPU.State.CyclesTotal - m_StepCycle) * CPUCycleDivider;
+}
+
+uint64_t NESDevice::PPUTimestamp(int16_t scanline, int16_t cycle)
+{
+	return DeviceCycle + PPUMasterCycle + (uint64_t)m_PPU.CyclesUntil(scanline, cycle) * PPUCycleDivider;
+}
+
+void NESDevice::SchedulePPUEvents()
+{
+	m_Scheduler.Schedule(NESScheduler::Event::VBlank, PPUTimestamp(241, 1));
+	m_Scheduler.Schedule(NESScheduler::Event::FrameEnd, PPUTimestamp(260, 340));
+}
+
+void NESDevice::ProcessEvent(NESScheduler::Event event)
+{
+	switch (event)
+	{
+	case NESScheduler::Event::VBlank:
+		//Check if ppu prepared interrupt for cpu
+		if (m_PPU.IsEmitingNMI)
+		{
+			//Add request to cpu
+			m_CPU.State.NMIRequest = true;
+			//NMI is scheduled - disabling it
+			m_PPU.IsEmitingNMI = false;
+		}
+		m_Scheduler.Schedule(NESScheduler::Event::VBlank, PPUTimestamp(241, 1));
+		break;
+	case NESScheduler::Event::FrameEnd:
+		m_IsFrameCompleted = true;
+		m_Scheduler.Schedule(NESScheduler::Event::FrameEnd, PPUTimestamp(260, 340));
+		break;
+	case NESScheduler::Event::MapperIRQ:
+		m_CPU.State.IRQRequest = true;
+		break;
+	default:
+		break;
+	}
+}
+
+void NESDevice::UpdateMemoryMap()
+{
+	// ******** CPU ********
+	for (uint32_t page = 0; page < 64; page++)
+	{
+		m_CPUReadPages[page] = nullptr;
+		m_CPUWritePages[page] = nullptr;
+	}
+
+	// $0000-$1FFF : 2KB Internal RAM and its mirrors
+	for (uint32_t page = 0; page < 8; page++)
+	{
+		m_CPUReadPages[page] = &m_RAM[(page & 0x01) * 0x0400];
+		m_CPUWritePages[page] = m_CPUReadPages[page];
+	}
+
+	// $4400-$FFFF : Cartrige space, readonly except PRG RAM (every other write may hit mapper register)
+	// ($4000-$43FF page shares I/O registers, so it's always handled by CPURead)
+	for (uint32_t page = 17; page < 64; page++)
+	{
+		m_CPUReadPages[page] = m_Cartrige.GetCPUPage((uint16_t)(page * 0x0400));
+		m_CPUWritePages[page] = m_Cartrige.GetCPUWritePage((uint16_t)(page * 0x0400));
+	}
+
+	// ******** PPU ********
+	for (uint32_t page = 0; page < 16; page++)
+	{
+		m_PPUReadPages[page] = nullptr;
+		m_PPUWritePages[page] = nullptr;
+	}
+
+	// $0000-$1FFF : Pattern tables, readonly (CHR RAM writes go through cartrige)
+	for (uint32_t page = 0; page < 8; page++)
+	{
+		m_PPUReadPages[page] = m_Cartrige.GetPPUPage((uint16_t)(page * 0x0400));
+		m_PPUTilePages[page] = m_Cartrige.GetPPUTilePage((uint16_t)(page * 0x0400));
+	}
+
+	// $2000-$3BFF : Nametables and mirrors
+	// ($3C00-$3FFF page contains palette, so it's always handled by PPURead)
+	for (uint32_t page = 8; page < 15; page++)
+	{
+		uint16_t first_address;
+		uint16_t last_address;
+		uint16_t address = (uint16_t)(page * 0x0400) & 0x0FFF;
+		if (m_Cartrige.PPUInterceptVRAM(address, &first_address)) continue;
+		if (m_Cartrige.PPUInterceptVRAM(address + 0x03FF, &last_address)) continue;
+		if (last_address != first_address + 0x03FF || last_address >= 0x0800) continue;
+
+		m_PPUReadPages[page] = &m_VRAM[first_address];
+		m_PPUWritePages[page] = &m_VRAM[first_address];
+	}
+}
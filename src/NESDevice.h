@@ -1,12 +1,16 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 
 #include "NESState.h"
+#include "NESScheduler.h"
 #include "NESCPU.h"
 #include "NESPPU.h"
 #include "NESCartrige.h"
 #include "NESController.h"
+#include "NESJIT.h"
+#include "NESStaticCode.h"
 
 class NESDevice
 {
@@ -22,6 +26,15 @@ public:
 	NESPPU& GetPPU();
 	NESCartrige& GetCartrige();
 	NESController& GetController();
+	NESScheduler& GetScheduler();
+	NESJIT& GetJIT();
+	//Recompiled code matching loaded cartrige (selected on Reset), nullptr if there is none
+	const NESStaticCode* GetStaticCode();
+
+	//Lean instance (headless) : debug-only memory (PPU viewer buffers) is released and never allocated
+	void SetLeanMode(bool lean);
+	//Memory owned by this instance (bytes), ROM image shared between instances isn't included
+	size_t GetMemoryFootprint();
 
 	//CPU Bus RW operations
 	uint8_t CPURead(uint16_t address);
@@ -31,6 +44,30 @@ public:
 	uint8_t PPURead(uint16_t address);
 	void    PPUWrite(uint16_t address, uint8_t data);
 
+	//OAM DMA fast path : copies whole page at once if it's plain memory (RAM, PRG) and ppu
+	// doesn't use OAM during transfer, returns false if transfer has to be done cycle by cycle
+	bool OAMDMA(uint16_t address, uint32_t cycles);
+	//Direct pointer to readonly memory (PRG ROM) at address, valid until end of 1KB page
+	// nullptr if memory there is writable or isn't plain memory at all
+	const uint8_t* GetCPUROM(uint16_t address);
+	//Decoded pattern tile (see NESROMImage::DecodedTileSize) containing pattern table address,
+	// nullptr if CHR there isn't plain memory (tile has to be read byte by byte through PPURead)
+	const uint8_t* GetPPUTile(uint16_t address);
+	//Internal 2KB RAM (used by external cpu cores, see NESBatch)
+	uint8_t* GetRAM();
+
+	//Frame loop driven from outside of device (see NESBatch), Running + PerInstruction mode only
+	// BeginFrame        - has to be called before first instruction of frame (Update does the same)
+	// StepInstruction   - runs single instruction the regular way, true if frame got completed
+	// ExternalCPUBudget - cycles cpu may run from current instruction boundary without any sync,
+	//                     0 if next instruction has to go through StepInstruction (interrupt, DMA, idle loop...)
+	// ExternalCPUCycles - accounts instructions executed outside of device (registers and RAM already
+	//                     updated, at most ExternalCPUBudget cycles), true if frame got completed
+	void	 BeginFrame();
+	bool	 StepInstruction();
+	uint32_t ExternalCPUBudget();
+	bool	 ExternalCPUCycles(uint32_t cycles);
+
 	//Debug operations used to 'peek' into the memory without modifying it
 	uint8_t CPUPeek(uint16_t address);
 	uint8_t PPUPeek(uint16_t address);
@@ -39,6 +76,12 @@ public:
 
 	bool SaveState(NESState& state);
 	bool LoadState(NESState& state);
+	//Makes target exact copy of this device (same as SaveState + LoadState, but without serialization,
+	// including timing and scheduler state LoadState doesn't restore), ROM image is shared.
+	// Target keeps its compiled code and decode caches if it already runs the same ROM,
+	// so repeated forks into the same targets are cheap (tree search, TAS tools)
+	// 'include_framebuffer' - skip copying current frame if target won't look at it
+	bool CloneInto(NESDevice& target, bool include_framebuffer = true);
 
 	//Debugging modes
 	enum class DeviceMode : uint32_t
@@ -53,19 +96,100 @@ public:
 
 	DeviceMode DeviceMode;
 
-	uint32_t DeviceCycle;
+	//CPU execution modes (used by DeviceMode::Running, debugging modes are always per-cycle)
+	enum class ExecutionMode : uint32_t
+	{
+		PerCycle,		//CPU and PPU advance in lockstep, one master cycle at time
+		PerInstruction	//CPU runs whole instruction, rest of device catches up when needed
+	};
+
+	ExecutionMode ExecutionMode;
+
+	//Skip iterations of idle loops (waiting for vblank/nmi) straight to next scheduled event (PerInstruction only)
+	bool	 IdleLoopSkipping;
+	uint64_t IdleLoopCyclesSkipped;
+
+	//Run common instruction pairs (LDA/STA, DEX/BNE...) as one step (PerInstruction only)
+	bool	 InstructionFusion;
+
+	//Render whole visible lines at once when nothing touches ppu in the middle of them,
+	// lines with raster effects stay with dot renderer (PerInstruction only)
+	bool	 ScanlineRendering;
+
+	//Run PRG ROM code through block recompiler (PerInstruction only, x86-64 hosts)
+	bool	 JITEnabled;
+
+	//Run ahead-of-time recompiled code linked into executable (PerInstruction only, see NESStaticCode.h)
+	bool	 StaticCodeEnabled;
+	uint64_t StaticCodeInstructions;
+
+	uint64_t DeviceCycle;
 	uint32_t CPUCycleDivider, CPUMasterCycle;
 	uint32_t PPUCycleDivider, PPUMasterCycle;
 
 protected:
 
 	void MasterCycle();
+	//Everything happening during master cycle except cpu
+	void PeripheralCycle();
+
+	//Per-instruction execution
+	void InstructionCycle();
+	//Advances device after cpu executed 'cycles' from m_CPUTimestamp
+	void CompleteInstruction(uint32_t cycles);
+	//Fast-forwards cpu if it sits in idle loop
+	void SkipIdleLoop();
+	//Runs peripherals up to (not including) specified master cycle
+	void CatchUp(uint64_t device_cycle);
+	//Master cycle of cpu cycle currently being executed by Step
+	uint64_t CPUTimestamp();
+	//Runs recompiled code at cpu PC if it can't take longer than 'max_cycles',
+	// returns amount of cycles taken, 0 if nothing was executed (same contract as NESJIT::Run)
+	uint32_t RunStaticCode(uint32_t max_cycles);
+
+	//Event handling
+	//Master cycle at which ppu will process specified dot
+	uint64_t PPUTimestamp(int16_t scanline, int16_t cycle);
+	void SchedulePPUEvents();
+	void ProcessEvent(NESScheduler::Event event);
+
+	//Rebuilds page tables, has to be called whenever cartrige may switch banks or mirroring
+	void UpdateMemoryMap();
+
+	bool	 m_IsCPUAhead;
+	bool	 m_IsFrameCompleted;
+	uint64_t m_CPUTimestamp;	//Master cycle of next cpu cycle
+	uint64_t m_StepTimestamp;	//Master cycle of first cpu cycle of current step
+	uint32_t m_StepCycle;
+
+	//Mapper is clocked only if it asks for it
+	NESMapper::ClockMode m_MapperClockMode;
+	bool	 m_PPUA12;			//Last state of PPU A12 line (for ClockMode::PPUA12)
+
+	//Idle loop candidate, loop is skipped after one full iteration leaves cpu in the same state
+	bool	 m_IsIdleLoopTracked;
+	uint32_t m_IdleLoopLength;	//Instructions in loop
+	uint32_t m_IdleLoopSteps;	//Instructions executed since loop start
+	uint32_t m_IdleLoopCycle;	//Cpu cycle of loop start
+	uint64_t m_IdleLoopEvent;	//Next event at loop start, iteration proves nothing if event happened during it
+	struct NESCPU::Registers m_IdleLoopRegisters;
+
+	//Ahead-of-time recompiled code, entry point (block and instruction) by address - 0x8000
+	struct StaticEntry
+	{
+		const NESStaticBlock* Block = nullptr;
+		uint16_t Index = 0;
+	};
+	const NESStaticCode* m_StaticCode;
+	std::vector<StaticEntry> m_StaticEntries;
 
 	//SubSystems
 	NESCPU m_CPU;
 	NESPPU m_PPU;
 	NESCartrige m_Cartrige;
 	NESController m_Controller;
+	NESScheduler m_Scheduler;
+	NESJIT m_JIT;
 
 	//cpu bus
 	uint8_t m_RAM[0x0800];			//2KB internal RAM
@@ -73,4 +197,13 @@ protected:
 	//ppu bus
 	uint8_t m_VRAM[0x0800];			//Namatables VRAM
 
+	//Memory map, 1KB pages pointing directly into RAM/PRG/CHR/VRAM
+	// nullptr means page is handled by CPURead/CPUWrite/PPURead/PPUWrite chain (I/O, mapper registers)
+	uint8_t* m_CPUReadPages[64];
+	uint8_t* m_CPUWritePages[64];
+	uint8_t* m_PPUReadPages[16];
+	uint8_t* m_PPUWritePages[16];
+	//Decoded tiles of pattern table pages (follow bank switches with the rest of memory map)
+	const uint8_t* m_PPUTilePages[8];
+
 };
\ No newline at end of file
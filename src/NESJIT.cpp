@@ -0,0 +1,814 @@
+#include "NESJIT.h"
+#include "NESDevice.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+#ifdef NES_JIT_X64
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+#endif
+
+using AddrMode = NESCPU::AddrMode;
+
+//Operations understood by recompiler, everything else is left to interpreter
+enum class JITOp : uint8_t
+{
+	XXX,
+	ORA, AND, EOR, ADC, STA, LDA, CMP, SBC,
+	ASL, ROL, LSR, ROR, STX, LDX, DEC, INC,
+	BIT, STY, LDY, CPY, CPX,
+	JMP, JSR, RTS, BRANCH,
+	CLC, SEC, CLI, SEI, CLV, CLD, SED,
+	TAX, TXA, TAY, TYA, TSX, TXS,
+	INX, INY, DEX, DEY, NOP,
+	PHA, PLA, PHP, PLP
+};
+
+//x86 registers, 6502 registers live in callee-saved ones while block runs
+enum : uint8_t { RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSP = 4, RBP = 5, RSI = 6, RDI = 7, R12 = 12, R13 = 13, R14 = 14, R15 = 15 };
+static const uint8_t RegA = R12;
+static const uint8_t RegX = R13;
+static const uint8_t RegY = R14;
+static const uint8_t RegSR = R15;
+
+#define CTX(field) ((uint8_t)offsetof(NESJIT::Context, field))
+
+//Decodes opcode using 6502 aaabbbcc layout, returns false for anything not compiled
+// (BRK, RTI, JMP ind and illegal opcodes)
+static bool DecodeOpCode(uint8_t opcode, JITOp* op, AddrMode* mode)
+{
+	*mode = AddrMode::IMP;
+	switch (opcode)
+	{
+	case 0x20: *op = JITOp::JSR; *mode = AddrMode::ABS; return true;
+	case 0x4C: *op = JITOp::JMP; *mode = AddrMode::ABS; return true;
+	case 0x60: *op = JITOp::RTS; return true;
+	case 0x08: *op = JITOp::PHP; return true;
+	case 0x28: *op = JITOp::PLP; return true;
+	case 0x48: *op = JITOp::PHA; return true;
+	case 0x68: *op = JITOp::PLA; return true;
+	case 0x18: *op = JITOp::CLC; return true;
+	case 0x38: *op = JITOp::SEC; return true;
+	case 0x58: *op = JITOp::CLI; return true;
+	case 0x78: *op = JITOp::SEI; return true;
+	case 0xB8: *op = JITOp::CLV; return true;
+	case 0xD8: *op = JITOp::CLD; return true;
+	case 0xF8: *op = JITOp::SED; return true;
+	case 0x88: *op = JITOp::DEY; return true;
+	case 0xC8: *op = JITOp::INY; return true;
+	case 0xE8: *op = JITOp::INX; return true;
+	case 0xCA: *op = JITOp::DEX; return true;
+	case 0x98: *op = JITOp::TYA; return true;
+	case 0xA8: *op = JITOp::TAY; return true;
+	case 0x8A: *op = JITOp::TXA; return true;
+	case 0xAA: *op = JITOp::TAX; return true;
+	case 0x9A: *op = JITOp::TXS; return true;
+	case 0xBA: *op = JITOp::TSX; return true;
+	case 0xEA: *op = JITOp::NOP; return true;
+	}
+
+	if ((opcode & 0x1F) == 0x10)
+	{
+		*op = JITOp::BRANCH;
+		*mode = AddrMode::REL;
+		return true;
+	}
+
+	const uint8_t aaa = opcode >> 5;
+	const uint8_t bbb = (opcode >> 2) & 0x07;
+	switch (opcode & 0x03)
+	{
+	case 0x01:
+	{
+		static const JITOp ops[8] = { JITOp::ORA, JITOp::AND, JITOp::EOR, JITOp::ADC, JITOp::STA, JITOp::LDA, JITOp::CMP, JITOp::SBC };
+		static const AddrMode modes[8] = { AddrMode::XIN, AddrMode::ZPG, AddrMode::IMM, AddrMode::ABS, AddrMode::INY, AddrMode::ZPX, AddrMode::ABY, AddrMode::ABX };
+		*op = ops[aaa];
+		*mode = modes[bbb];
+		return !(*op == JITOp::STA && *mode == AddrMode::IMM);
+	}
+	case 0x02:
+	{
+		static const JITOp ops[8] = { JITOp::ASL, JITOp::ROL, JITOp::LSR, JITOp::ROR, JITOp::STX, JITOp::LDX, JITOp::DEC, JITOp::INC };
+		*op = ops[aaa];
+		const bool is_xy = (*op == JITOp::STX || *op == JITOp::LDX);
+		switch (bbb)
+		{
+		case 0: *mode = AddrMode::IMM; return *op == JITOp::LDX;
+		case 1: *mode = AddrMode::ZPG; return true;
+		case 2: *mode = AddrMode::ACC; return aaa < 4;
+		case 3: *mode = AddrMode::ABS; return true;
+		case 5: *mode = is_xy ? AddrMode::ZPY : AddrMode::ZPX; return true;
+		case 7: *mode = is_xy ? AddrMode::ABY : AddrMode::ABX; return *op != JITOp::STX;
+		}
+		return false;
+	}
+	case 0x00:
+	{
+		static const JITOp ops[8] = { JITOp::XXX, JITOp::BIT, JITOp::XXX, JITOp::XXX, JITOp::STY, JITOp::LDY, JITOp::CPY, JITOp::CPX };
+		*op = ops[aaa];
+		if (*op == JITOp::XXX) return false;
+		switch (bbb)
+		{
+		case 0: *mode = AddrMode::IMM; return aaa >= 5;
+		case 1: *mode = AddrMode::ZPG; return true;
+		case 3: *mode = AddrMode::ABS; return true;
+		case 5: *mode = AddrMode::ZPX; return *op == JITOp::STY || *op == JITOp::LDY;
+		case 7: *mode = AddrMode::ABX; return *op == JITOp::LDY;
+		}
+		return false;
+	}
+	}
+	return false;
+}
+
+NESJIT::NESJIT(NESDevice* nesDevice, uint8_t* const* cpuReadPages, uint8_t* const* cpuWritePages) :
+	m_NESDevicePtr(nesDevice),
+	m_CPUReadPages(cpuReadPages),
+	m_CPUWritePages(cpuWritePages)
+{
+	BlocksCompiled = 0;
+	InstructionsExecuted = 0;
+
+	//N and Z bits for every result value
+	for (uint32_t value = 0; value < 256; value++)
+		m_NZFlags[value] = (value & 0x80) | (value == 0 ? 0x02 : 0x00);
+
+	memset(&m_Context, 0, sizeof(Context));
+	m_Context.ReadPages = m_CPUReadPages;
+	m_Context.WritePages = m_CPUWritePages;
+	m_Context.NZFlags = m_NZFlags;
+
+	m_CodeBuffer = nullptr;
+	m_IsAllocationFailed = false;
+	m_CodeSize = 0;
+	m_CodeStart = 0;
+	m_ExitOffset = 0;
+}
+
+NESJIT::~NESJIT()
+{
+#ifdef NES_JIT_X64
+	if (m_CodeBuffer)
+	{
+#ifdef _WIN32
+		VirtualFree(m_CodeBuffer, 0, MEM_RELEASE);
+#else
+		munmap(m_CodeBuffer, CodeBufferSize);
+#endif
+	}
+#endif
+}
+
+bool NESJIT::IsSupported()
+{
+	//Doesn't allocate, GUI asks every frame whether JIT is even enabled or not
+#ifdef NES_JIT_X64
+	return !m_IsAllocationFailed;
+#else
+	return false;
+#endif
+}
+
+size_t NESJIT::GetMemoryFootprint()
+{
+	return (m_CodeBuffer ? CodeBufferSize : 0) + m_Blocks.capacity() * sizeof(Block) + m_Code.capacity();
+}
+
+bool NESJIT::allocate()
+{
+	if (m_CodeBuffer != nullptr) return true;
+	if (m_IsAllocationFailed) return false;
+
+	void* memory = nullptr;
+#ifdef NES_JIT_X64
+#ifdef _WIN32
+	memory = VirtualAlloc(nullptr, CodeBufferSize, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+#else
+	memory = mmap(nullptr, CodeBufferSize, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED) memory = nullptr;
+#endif
+	if (memory == nullptr)
+		printf("Warning: unable to allocate executable memory, recompiler disabled\n");
+#endif
+	if (memory == nullptr)
+	{
+		m_IsAllocationFailed = true;
+		return false;
+	}
+
+	m_CodeBuffer = (uint8_t*)memory;
+	emit_trampoline();
+	m_Blocks.resize(BlockCacheSize);
+	return true;
+}
+
+void NESJIT::Reset()
+{
+	for (Block& block : m_Blocks)
+		block = Block();
+	m_CodeSize = m_CodeStart;
+}
+
+uint32_t NESJIT::Run(uint32_t max_cycles)
+{
+	if (!allocate()) return 0;
+
+	NESCPU& cpu = m_NESDevicePtr->GetCPU();
+
+	//Only on plain instruction boundary, interrupts and DMA are handled by interpreter
+	if (cpu.State.Halted || !cpu.IsReady() || cpu.State.DMATransfer || cpu.State.DMARequest || cpu.State.NMIRequest ||
+		(cpu.State.IRQRequest && !cpu.getFlag(NESCPU::SRFlag::InterruptBit)))
+		return 0;
+
+	const uint16_t address = cpu.Registers.PC;
+	const uint8_t* source = m_NESDevicePtr->GetCPUROM(address);
+	if (source == nullptr) return 0;
+
+	//Same ROM may be mapped at several addresses (mirrors), code depends on address
+	Block& block = m_Blocks[address & (BlockCacheSize - 1)];
+	if (block.Source != source || block.PC[0] != address)
+	{
+		block = Block();
+		block.Source = source;
+		block.PC[0] = address;
+	}
+
+	if (block.Code == nullptr)
+	{
+		//Only blocks executed more than once are worth compiling
+		if (block.IsFailed || ++block.Hits < CompileThreshold) return 0;
+		if (!compile_block(block, address, source))
+		{
+			block.IsFailed = true;
+			return 0;
+		}
+	}
+
+	if (block.MaxCycles > max_cycles) return 0;
+
+	m_Context.ExtraCycles = 0;
+	m_Context.ExtraIndex = MaxBlockInstructions;
+	m_Context.AC = cpu.Registers.AC;
+	m_Context.XR = cpu.Registers.XR;
+	m_Context.YR = cpu.Registers.YR;
+	cpu.SyncFlags();
+	m_Context.SR = cpu.Registers.SR;
+	m_Context.SP = cpu.Registers.SP;
+
+	typedef uint32_t(*EntryFn)(Context*, const uint8_t*);
+	const uint32_t executed = ((EntryFn)m_CodeBuffer)(&m_Context, block.Code);
+	if (executed == 0) return 0;
+
+	cpu.Registers.AC = m_Context.AC;
+	cpu.Registers.XR = m_Context.XR;
+	cpu.Registers.YR = m_Context.YR;
+	cpu.Registers.SR = m_Context.SR;
+	cpu.Registers.SP = m_Context.SP;
+	cpu.Registers.PC = (executed < block.Count) ? block.PC[executed] : m_Context.PC;
+
+	//Leave cpu state as if interpreter executed the same instructions
+	const uint32_t last = executed - 1;
+	const uint32_t cycles = block.Cycles[executed] + m_Context.ExtraCycles;
+
+	if (executed >= 8)
+	{
+		memcpy(cpu.State.LastOperations, &block.PC[executed - 8], sizeof(uint16_t) * 8);
+	}
+	else
+	{
+		memmove(cpu.State.LastOperations, &cpu.State.LastOperations[executed], sizeof(uint16_t) * (8 - executed));
+		memcpy(&cpu.State.LastOperations[8 - executed], block.PC, sizeof(uint16_t) * executed);
+	}
+	cpu.State.CurrentOpCode = block.OpCode[last];
+	cpu.State.CurrentAddrMode = block.Mode[last];
+	cpu.State.CycleCounter = (uint8_t)(block.Cycles[executed] - block.Cycles[last] + (m_Context.ExtraIndex == last ? block.Penalty[last] : 0));
+	cpu.State.CyclesTotal += cycles;
+
+	InstructionsExecuted += executed;
+	return cycles;
+}
+
+bool NESJIT::compile_block(Block& block, uint16_t address, const uint8_t* source)
+{
+	m_Code.clear();
+	m_ExitFixups.clear();
+	m_ExitJumps.clear();
+	m_Terminated = false;
+
+	block.Count = 0;
+	block.MaxCycles = 0;
+	block.Cycles[0] = 0;
+
+	const uint16_t page_end = (address & 0xFC00) + 0x0400;
+	uint16_t pc = address;
+	while (block.Count < MaxBlockInstructions)
+	{
+		//Whole instruction has to be inside of the same ROM page
+		if ((uint32_t)pc + 3 > page_end) break;
+
+		bool is_terminal = false;
+		const uint32_t size = compile_instruction(block, block.Count, pc, &source[pc - address], &is_terminal);
+		if (size == 0) break;
+
+		pc += (uint16_t)size;
+		block.Count++;
+		if (is_terminal) break;
+	}
+
+	if (block.Count == 0) return false;
+
+	//Block fell through to next instruction
+	if (!m_Terminated)
+	{
+		emit({ 0x66, 0xC7, 0x43, CTX(PC), (uint8_t)(pc & 0xFF), (uint8_t)(pc >> 8) });	// mov word [rbx+PC], pc
+	}
+	emit({ 0xB8 }); emit32(block.Count);	// mov eax, count
+	emit({ 0xE9 }); m_ExitJumps.push_back((uint32_t)m_Code.size()); emit32(0);	// jmp exit
+
+	//Side exits : instruction 'index' wasn't executed
+	for (auto& fixup : m_ExitFixups)
+	{
+		const uint32_t target = (uint32_t)m_Code.size();
+		const uint32_t rel = target - (fixup.first + 4);
+		memcpy(&m_Code[fixup.first], &rel, 4);
+		emit({ 0xB8 }); emit32(fixup.second);	// mov eax, index
+		emit({ 0xE9 }); m_ExitJumps.push_back((uint32_t)m_Code.size()); emit32(0);	// jmp exit
+	}
+
+	//Out of executable memory - start over
+	if (m_CodeSize + m_Code.size() > CodeBufferSize)
+	{
+		Block compiled = block;
+		this->Reset();
+		block = compiled;
+	}
+
+	uint8_t* code = &m_CodeBuffer[m_CodeSize];
+	for (uint32_t offset : m_ExitJumps)
+	{
+		const uint32_t rel = m_ExitOffset - (m_CodeSize + offset + 4);
+		memcpy(&m_Code[offset], &rel, 4);
+	}
+	memcpy(code, m_Code.data(), m_Code.size());
+	m_CodeSize += (uint32_t)m_Code.size();
+
+	block.Code = code;
+	BlocksCompiled++;
+	return true;
+}
+
+uint32_t NESJIT::compile_instruction(Block& block, uint32_t index, uint16_t address, const uint8_t* source, bool* is_terminal)
+{
+	JITOp op;
+	AddrMode mode;
+	const uint8_t opcode = source[0];
+	if (!DecodeOpCode(opcode, &op, &mode)) return 0;
+
+	const uint16_t operand = source[1] | (source[2] << 8);
+	const uint16_t next = address + ((mode == AddrMode::IMP || mode == AddrMode::ACC) ? 1 : (mode == AddrMode::ABS || mode == AddrMode::ABX || mode == AddrMode::ABY) ? 3 : 2);
+
+	const bool is_store = (op == JITOp::STA || op == JITOp::STX || op == JITOp::STY);
+	const bool is_rmw = (op == JITOp::ASL || op == JITOp::ROL || op == JITOp::LSR || op == JITOp::ROR || op == JITOp::DEC || op == JITOp::INC);
+
+	//Registers and I/O with known address end block, interpreter does them with device synced
+	if (mode == AddrMode::ABS && op != JITOp::JMP && op != JITOp::JSR && operand >= 0x2000)
+	{
+		if (is_store || is_rmw || operand < 0x4400) return 0;
+	}
+
+	uint32_t cycles = 2;
+	uint8_t penalty = 0;
+
+	m_Terminated = false;
+
+	// ******** Addressing ********
+	//Leaves memory operand as [rsi+rcx] (runtime address) or [rsi+disp32] (constant address)
+	bool is_constant = false;
+	uint16_t constant_address = 0;
+	const bool is_write = is_store || is_rmw;
+
+	switch (mode)
+	{
+	case AddrMode::ZPG:
+		is_constant = true;
+		constant_address = operand & 0x00FF;
+		cycles = is_rmw ? 5 : 3;
+		emit_const_page(is_write, constant_address, index);
+		break;
+	case AddrMode::ABS:
+		if (op == JITOp::JMP || op == JITOp::JSR) break;
+		is_constant = true;
+		constant_address = operand;
+		cycles = is_rmw ? 6 : 4;
+		emit_const_page(is_write, constant_address, index);
+		break;
+	case AddrMode::ZPX:
+	case AddrMode::ZPY:
+		cycles = is_rmw ? 6 : 4;
+		emit_rr(0x89, RCX, (mode == AddrMode::ZPX) ? RegX : RegY);				// mov ecx, X/Y
+		emit({ 0x81, 0xC1 }); emit32(operand & 0x00FF);						// add ecx, zp
+		emit({ 0x0F, 0xB6, 0xC9 });											// movzx ecx, cl
+		emit_const_page(is_write, 0x0000, index);
+		break;
+	case AddrMode::ABX:
+	case AddrMode::ABY:
+		cycles = is_rmw ? 7 : (is_store ? 5 : 4);
+		emit({ 0xB9 }); emit32(operand);									// mov ecx, base
+		emit({ 0x89, 0xCF });												// mov edi, ecx
+		emit_rr(0x01, RCX, (mode == AddrMode::ABX) ? RegX : RegY);				// add ecx, X/Y
+		emit({ 0x31, 0xCF });												// xor edi, ecx (bit 8 - page crossed)
+		emit({ 0x0F, 0xB7, 0xC9 });											// movzx ecx, cx
+		emit_page_lookup(is_write, index);
+		if (!is_write) penalty = 1;
+		break;
+	case AddrMode::XIN:
+		cycles = 6;
+		emit_rr(0x89, RAX, RegX);											// mov eax, X
+		emit({ 0x05 }); emit32(operand & 0x00FF);							// add eax, zp
+		emit({ 0x0F, 0xB6, 0xC0 });											// movzx eax, al
+		emit_const_page(false, 0x0000, index);
+		emit({ 0x0F, 0xB6, 0x0C, 0x06 });									// movzx ecx, byte [rsi+rax]
+		emit({ 0xFE, 0xC0 });												// inc al
+		emit({ 0x0F, 0xB6, 0x14, 0x06 });									// movzx edx, byte [rsi+rax]
+		emit({ 0xC1, 0xE2, 0x08 });											// shl edx, 8
+		emit({ 0x09, 0xD1 });												// or ecx, edx
+		emit_page_lookup(is_write, index);
+		break;
+	case AddrMode::INY:
+		cycles = is_store ? 6 : 5;
+		emit_const_page(false, 0x0000, index);
+		emit({ 0x0F, 0xB6, 0x8E }); emit32(operand & 0x00FF);				// movzx ecx, byte [rsi+zp]
+		emit({ 0x0F, 0xB6, 0x96 }); emit32((operand + 1) & 0x00FF);			// movzx edx, byte [rsi+zp+1]
+		emit({ 0xC1, 0xE2, 0x08 });											// shl edx, 8
+		emit({ 0x09, 0xD1 });												// or ecx, edx
+		emit({ 0x89, 0xCF });												// mov edi, ecx
+		emit_rr(0x01, RCX, RegY);											// add ecx, Y
+		emit({ 0x31, 0xCF });												// xor edi, ecx
+		emit({ 0x0F, 0xB7, 0xC9 });											// movzx ecx, cx
+		emit_page_lookup(is_write, index);
+		if (!is_write) penalty = 1;
+		break;
+	default:
+		break;
+	}
+
+	//Memory operand helpers (modrm for [rsi+disp32] / [rsi+rcx])
+	auto load = [&]()
+	{
+		if (mode == AddrMode::IMM)
+		{
+			emit({ 0xB8 }); emit32(operand & 0x00FF);						// mov eax, imm
+		}
+		else
+		{
+			if (penalty)
+			{
+				emit({ 0xF7, 0xC7 }); emit32(0x0100);						// test edi, 0x100
+				emit({ 0x74, 0x0B });										// jz +11
+				emit_penalty(index, penalty);
+			}
+			if (is_constant) { emit({ 0x0F, 0xB6, 0x86 }); emit32(constant_address & 0x03FF); }	// movzx eax, byte [rsi+disp32]
+			else emit({ 0x0F, 0xB6, 0x04, 0x0E });							// movzx eax, byte [rsi+rcx]
+		}
+	};
+	auto store = [&](uint8_t reg)
+	{
+		const uint8_t rex = (reg & 8) ? 0x44 : 0x00;
+		if (rex) m_Code.push_back(rex);
+		if (is_constant) { emit({ 0x88, (uint8_t)(0x86 | ((reg & 7) << 3)) }); emit32(constant_address & 0x03FF); }	// mov [rsi+disp32], reg8
+		else emit({ 0x88, (uint8_t)(0x04 | ((reg & 7) << 3)), 0x0E });		// mov [rsi+rcx], reg8
+	};
+	auto rmw = [&](auto&& operation)
+	{
+		if (mode == AddrMode::ACC)
+		{
+			emit_rr(0x89, RAX, RegA);										// mov eax, A
+			operation();
+			emit_rr(0x89, RegA, RAX);										// mov A, eax
+		}
+		else
+		{
+			load();
+			operation();
+			store(RAX);
+		}
+	};
+	auto carry_from_host = [&]()
+	{
+		//rcx still holds address of RMW operand
+		emit({ 0x0F, 0x92, 0xC2 });											// setc dl
+		emit({ 0x41, 0x83, 0xE7, 0x7C });									// and r15d, ~(N|Z|C)
+		emit_rr(0x08, RegSR, RDX, true);									// or r15b, dl
+	};
+	auto carry_to_host = [&]()
+	{
+		emit({ 0x41, 0x0F, 0xBA, 0xE7, 0x00 });								// bt r15d, 0
+	};
+	auto add_with_carry = [&]()
+	{
+		carry_to_host();
+		emit_rr(0x10, RegA, RAX, true);										// adc r12b, al
+		emit({ 0x0F, 0x92, 0xC1 });											// setc cl
+		emit({ 0x0F, 0x90, 0xC2 });											// seto dl
+		emit({ 0x41, 0x83, 0xE7, 0x3C });									// and r15d, ~(N|V|Z|C)
+		emit_rr(0x08, RegSR, RCX, true);									// or r15b, cl
+		emit({ 0xC0, 0xE2, 0x06 });											// shl dl, 6
+		emit_rr(0x08, RegSR, RDX, true);									// or r15b, dl
+		emit_nz(RegA);
+	};
+	auto compare = [&](uint8_t reg)
+	{
+		load();
+		emit_rr(0x89, RDX, reg);											// mov edx, reg
+		emit_rr(0x28, RDX, RAX, true);										// sub dl, al
+		emit({ 0x0F, 0x93, 0xC1 });											// setae cl
+		emit({ 0x41, 0x83, 0xE7, 0x7C });									// and r15d, ~(N|Z|C)
+		emit_rr(0x08, RegSR, RCX, true);									// or r15b, cl
+		emit({ 0x0F, 0xB6, 0xD2 });											// movzx edx, dl
+		emit_nz(RDX);
+	};
+	auto transfer = [&](uint8_t dst, uint8_t src)
+	{
+		emit_rr(0x89, dst, src);											// mov dst, src
+		emit_nz(dst);
+	};
+	auto set_flags = [&](uint8_t and_mask, uint8_t or_mask)
+	{
+		if (and_mask != 0xFF) emit({ 0x41, 0x83, 0xE7, and_mask });			// and r15d, mask
+		if (or_mask) emit({ 0x41, 0x83, 0xCF, or_mask });					// or r15d, mask
+	};
+	auto step_register = [&](uint8_t reg, bool is_decrement)
+	{
+		emit({ 0x41, 0xFE, (uint8_t)(0xC0 | (is_decrement ? 0x08 : 0x00) | (reg & 7)) });	// inc/dec reg8
+		emit_nz(reg);
+	};
+
+	// ******** Operation ********
+	switch (op)
+	{
+	case JITOp::LDA: load(); transfer(RegA, RAX); break;
+	case JITOp::LDX: load(); transfer(RegX, RAX); break;
+	case JITOp::LDY: load(); transfer(RegY, RAX); break;
+	case JITOp::STA: store(RegA); break;
+	case JITOp::STX: store(RegX); break;
+	case JITOp::STY: store(RegY); break;
+	case JITOp::ORA: load(); emit_rr(0x09, RegA, RAX); emit_nz(RegA); break;
+	case JITOp::AND: load(); emit_rr(0x21, RegA, RAX); emit_nz(RegA); break;
+	case JITOp::EOR: load(); emit_rr(0x31, RegA, RAX); emit_nz(RegA); break;
+	case JITOp::ADC: load(); add_with_carry(); break;
+	case JITOp::SBC: load(); emit({ 0xF6, 0xD0 }); add_with_carry(); break;	// not al
+	case JITOp::CMP: compare(RegA); break;
+	case JITOp::CPX: compare(RegX); break;
+	case JITOp::CPY: compare(RegY); break;
+	case JITOp::BIT:
+		load();
+		emit({ 0x41, 0x83, 0xE7, 0x3D });									// and r15d, ~(N|V|Z)
+		emit({ 0x89, 0xC2 });												// mov edx, eax
+		emit({ 0x83, 0xE2, 0xC0 });											// and edx, 0xC0
+		emit_rr(0x09, RegSR, RDX);											// or r15d, edx
+		emit_rr(0x84, RegA, RAX, true);										// test r12b, al
+		emit({ 0x0F, 0x94, 0xC2 });											// sete dl
+		emit({ 0xD0, 0xE2 });												// shl dl, 1
+		emit_rr(0x08, RegSR, RDX, true);									// or r15b, dl
+		break;
+	case JITOp::ASL: rmw([&]() { emit({ 0xD0, 0xE0 }); carry_from_host(); emit_nz(RAX); }); break;	// shl al, 1
+	case JITOp::LSR: rmw([&]() { emit({ 0xD0, 0xE8 }); carry_from_host(); emit_nz(RAX); }); break;	// shr al, 1
+	case JITOp::ROL: rmw([&]() { carry_to_host(); emit({ 0xD0, 0xD0 }); carry_from_host(); emit_nz(RAX); }); break;	// rcl al, 1
+	case JITOp::ROR: rmw([&]() { carry_to_host(); emit({ 0xD0, 0xD8 }); carry_from_host(); emit_nz(RAX); }); break;	// rcr al, 1
+	case JITOp::INC: rmw([&]() { emit({ 0xFE, 0xC0 }); emit_nz(RAX); }); break;	// inc al
+	case JITOp::DEC: rmw([&]() { emit({ 0xFE, 0xC8 }); emit_nz(RAX); }); break;	// dec al
+
+	case JITOp::CLC: set_flags(0xFE, 0x00); break;
+	case JITOp::SEC: set_flags(0xFF, 0x01); break;
+	case JITOp::SEI: set_flags(0xFF, 0x04); break;
+	case JITOp::CLD: set_flags(0xF7, 0x00); break;
+	case JITOp::SED: set_flags(0xFF, 0x08); break;
+	case JITOp::CLV: set_flags(0xBF, 0x00); break;
+	case JITOp::CLI:
+		//Pending IRQ may be taken right after, block has to end
+		set_flags(0xFB, 0x00);
+		*is_terminal = true;
+		break;
+	case JITOp::NOP: break;
+
+	case JITOp::TAX: transfer(RegX, RegA); break;
+	case JITOp::TAY: transfer(RegY, RegA); break;
+	case JITOp::TXA: transfer(RegA, RegX); break;
+	case JITOp::TYA: transfer(RegA, RegY); break;
+	case JITOp::TSX:
+		emit({ 0x44, 0x0F, 0xB6, 0x6B, CTX(SP) });							// movzx r13d, byte [rbx+SP]
+		emit_nz(RegX);
+		break;
+	case JITOp::TXS:
+		emit({ 0x44, 0x88, 0x6B, CTX(SP) });								// mov [rbx+SP], r13b
+		break;
+	case JITOp::INX: step_register(RegX, false); break;
+	case JITOp::INY: step_register(RegY, false); break;
+	case JITOp::DEX: step_register(RegX, true); break;
+	case JITOp::DEY: step_register(RegY, true); break;
+
+	case JITOp::PHA:
+		cycles = 3;
+		emit_rr(0x89, RAX, RegA);											// mov eax, A
+		emit_push();
+		break;
+	case JITOp::PHP:
+		cycles = 3;
+		emit_rr(0x89, RAX, RegSR);											// mov eax, SR
+		emit({ 0x83, 0xC8, 0x20 });											// or eax, 0x20
+		emit_push();
+		break;
+	case JITOp::PLA:
+		cycles = 4;
+		emit_pull();
+		transfer(RegA, RAX);
+		break;
+	case JITOp::PLP:
+		//Interrupt flag may change, block has to end
+		cycles = 4;
+		emit_pull();
+		emit_rr(0x89, RegSR, RAX);											// mov SR, eax
+		*is_terminal = true;
+		break;
+
+	case JITOp::JMP:
+		cycles = 3;
+		emit({ 0x66, 0xC7, 0x43, CTX(PC), (uint8_t)(operand & 0xFF), (uint8_t)(operand >> 8) });	// mov word [rbx+PC], target
+		*is_terminal = true;
+		m_Terminated = true;
+		break;
+	case JITOp::JSR:
+	{
+		const uint16_t return_address = address + 2;
+		cycles = 6;
+		emit({ 0xB8 }); emit32(return_address >> 8);						// mov eax, hi
+		emit_push();
+		emit({ 0xB8 }); emit32(return_address & 0xFF);						// mov eax, lo
+		emit_push();
+		emit({ 0x66, 0xC7, 0x43, CTX(PC), (uint8_t)(operand & 0xFF), (uint8_t)(operand >> 8) });	// mov word [rbx+PC], target
+		*is_terminal = true;
+		m_Terminated = true;
+		break;
+	}
+	case JITOp::RTS:
+		cycles = 6;
+		emit_pull();
+		emit({ 0x89, 0xC7 });												// mov edi, eax
+		emit_pull();
+		emit({ 0xC1, 0xE0, 0x08 });											// shl eax, 8
+		emit({ 0x09, 0xF8 });												// or eax, edi
+		emit({ 0xFF, 0xC0 });												// inc eax
+		emit({ 0x66, 0x89, 0x43, CTX(PC) });								// mov [rbx+PC], ax
+		*is_terminal = true;
+		m_Terminated = true;
+		break;
+	case JITOp::BRANCH:
+	{
+		static const uint8_t flags[4] = { 0x80, 0x40, 0x01, 0x02 };	// N, V, C, Z
+		const uint16_t target = next + (int8_t)(operand & 0xFF);
+		const bool is_taken_if_set = (opcode & 0x20) != 0;
+		penalty = ((next & 0xFF00) != (target & 0xFF00)) ? 2 : 1;
+		emit({ 0x66, 0xC7, 0x43, CTX(PC), (uint8_t)(next & 0xFF), (uint8_t)(next >> 8) });		// mov word [rbx+PC], next
+		emit({ 0x41, 0xF6, 0xC7, flags[opcode >> 6] });						// test r15b, flag
+		emit({ (uint8_t)(is_taken_if_set ? 0x74 : 0x75), 0x11 });			// jz/jnz not_taken
+		emit({ 0x66, 0xC7, 0x43, CTX(PC), (uint8_t)(target & 0xFF), (uint8_t)(target >> 8) });	// mov word [rbx+PC], target
+		emit_penalty(index, penalty);
+		*is_terminal = true;
+		m_Terminated = true;
+		break;
+	}
+	default:
+		return 0;
+	}
+
+	block.PC[index] = address;
+	block.OpCode[index] = opcode;
+	block.Mode[index] = mode;
+	block.Penalty[index] = penalty;
+	block.Cycles[index + 1] = block.Cycles[index] + cycles;
+	block.MaxCycles += cycles + penalty;
+
+	//Instructions ending block with fall through (CLI, PLP) still need PC
+	if (*is_terminal && !m_Terminated)
+	{
+		emit({ 0x66, 0xC7, 0x43, CTX(PC), (uint8_t)(next & 0xFF), (uint8_t)(next >> 8) });		// mov word [rbx+PC], next
+		m_Terminated = true;
+	}
+	return next - address;
+}
+
+void NESJIT::emit_trampoline()
+{
+	m_Code.clear();
+
+	// uint32_t entry(Context* context, const uint8_t* code)
+	emit({ 0x53, 0x55, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57, 0x56, 0x57 });	// push rbx, rbp, r12-r15, rsi, rdi
+#ifdef _WIN32
+	emit({ 0x48, 0x89, 0xCB });												// mov rbx, rcx
+	emit({ 0x48, 0x89, 0xD0 });												// mov rax, rdx
+#else
+	emit({ 0x48, 0x89, 0xFB });												// mov rbx, rdi
+	emit({ 0x48, 0x89, 0xF0 });												// mov rax, rsi
+#endif
+	emit({ 0x48, 0x8B, 0x6B, CTX(NZFlags) });								// mov rbp, [rbx+NZFlags]
+	emit({ 0x44, 0x0F, 0xB6, 0x63, CTX(AC) });								// movzx r12d, byte [rbx+AC]
+	emit({ 0x44, 0x0F, 0xB6, 0x6B, CTX(XR) });								// movzx r13d, byte [rbx+XR]
+	emit({ 0x44, 0x0F, 0xB6, 0x73, CTX(YR) });								// movzx r14d, byte [rbx+YR]
+	emit({ 0x44, 0x0F, 0xB6, 0x7B, CTX(SR) });								// movzx r15d, byte [rbx+SR]
+	emit({ 0xFF, 0xE0 });													// jmp rax
+
+	//Common exit, eax holds amount of executed instructions
+	m_ExitOffset = (uint32_t)m_Code.size();
+	emit({ 0x44, 0x88, 0x63, CTX(AC) });									// mov [rbx+AC], r12b
+	emit({ 0x44, 0x88, 0x6B, CTX(XR) });									// mov [rbx+XR], r13b
+	emit({ 0x44, 0x88, 0x73, CTX(YR) });									// mov [rbx+YR], r14b
+	emit({ 0x44, 0x88, 0x7B, CTX(SR) });									// mov [rbx+SR], r15b
+	emit({ 0x5F, 0x5E, 0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5D, 0x5B });	// pop in reverse order
+	emit({ 0xC3 });															// ret
+
+	memcpy(m_CodeBuffer, m_Code.data(), m_Code.size());
+	m_CodeStart = (uint32_t)((m_Code.size() + 15) & ~15);
+	m_CodeSize = m_CodeStart;
+}
+
+void NESJIT::emit(std::initializer_list<uint8_t> bytes)
+{
+	m_Code.insert(m_Code.end(), bytes);
+}
+
+void NESJIT::emit32(uint32_t value)
+{
+	emit({ (uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24) });
+}
+
+void NESJIT::emit_rr(uint8_t opcode, uint8_t rm, uint8_t reg, bool is_byte)
+{
+	//op r/m32, r32 (or r/m8, r8), REX is forced for byte registers above bl
+	uint8_t rex = 0x40 | ((reg & 8) ? 0x04 : 0x00) | ((rm & 8) ? 0x01 : 0x00);
+	if (rex != 0x40 || (is_byte && (rm >= 4 || reg >= 4))) m_Code.push_back(rex);
+	emit({ opcode, (uint8_t)(0xC0 | ((reg & 7) << 3) | (rm & 7)) });
+}
+
+void NESJIT::emit_nz(uint8_t reg)
+{
+	emit({ 0x41, 0x83, 0xE7, 0x7D });										// and r15d, ~(N|Z)
+	emit({ (uint8_t)(0x44 | ((reg & 8) ? 0x02 : 0x00)), 0x0A, 0x7C, (uint8_t)(((reg & 7) << 3) | 0x05), 0x00 });	// or r15b, [rbp+reg]
+}
+
+void NESJIT::emit_exit_check(uint32_t index)
+{
+	emit({ 0x48, 0x85, 0xF6 });												// test rsi, rsi
+	emit({ 0x0F, 0x84 });													// jz side_exit
+	m_ExitFixups.push_back({ (uint32_t)m_Code.size(), index });
+	emit32(0);
+}
+
+void NESJIT::emit_page_lookup(bool is_write, uint32_t index)
+{
+	//Address in ecx, leaves page in rsi and offset in ecx
+	emit({ 0x89, 0xCA });													// mov edx, ecx
+	emit({ 0xC1, 0xEA, 0x0A });												// shr edx, 10
+	emit({ 0x48, 0x8B, 0x73, is_write ? CTX(WritePages) : CTX(ReadPages) });	// mov rsi, [rbx+pages]
+	emit({ 0x48, 0x8B, 0x34, 0xD6 });										// mov rsi, [rsi+rdx*8]
+	emit_exit_check(index);
+	emit({ 0x81, 0xE1 }); emit32(0x03FF);									// and ecx, 0x3FF
+}
+
+void NESJIT::emit_const_page(bool is_write, uint16_t address, uint32_t index)
+{
+	emit({ 0x48, 0x8B, 0x73, is_write ? CTX(WritePages) : CTX(ReadPages) });	// mov rsi, [rbx+pages]
+	emit({ 0x48, 0x8B, 0xB6 }); emit32((address >> 10) * 8);				// mov rsi, [rsi+page*8]
+	//Internal RAM is always mapped
+	if (address >= 0x2000) emit_exit_check(index);
+}
+
+void NESJIT::emit_penalty(uint32_t index, uint8_t cycles)
+{
+	emit({ 0x83, 0x43, CTX(ExtraCycles), cycles });							// add dword [rbx+ExtraCycles], cycles
+	emit({ 0xC7, 0x43, CTX(ExtraIndex) }); emit32(index);					// mov dword [rbx+ExtraIndex], index
+}
+
+void NESJIT::emit_push()
+{
+	//Value in eax
+	emit({ 0x0F, 0xB6, 0x4B, CTX(SP) });									// movzx ecx, byte [rbx+SP]
+	emit({ 0x48, 0x8B, 0x73, CTX(WritePages) });							// mov rsi, [rbx+WritePages]
+	emit({ 0x48, 0x8B, 0x36 });												// mov rsi, [rsi]
+	emit({ 0x88, 0x84, 0x0E }); emit32(0x0100);								// mov [rsi+rcx+0x100], al
+	emit({ 0xFE, 0x4B, CTX(SP) });											// dec byte [rbx+SP]
+}
+
+void NESJIT::emit_pull()
+{
+	//Value to eax
+	emit({ 0xFE, 0x43, CTX(SP) });											// inc byte [rbx+SP]
+	emit({ 0x0F, 0xB6, 0x4B, CTX(SP) });									// movzx ecx, byte [rbx+SP]
+	emit({ 0x48, 0x8B, 0x73, CTX(ReadPages) });								// mov rsi, [rbx+ReadPages]
+	emit({ 0x48, 0x8B, 0x36 });												// mov rsi, [rsi]
+	emit({ 0x0F, 0xB6, 0x84, 0x0E }); emit32(0x0100);						// movzx eax, byte [rsi+rcx+0x100]
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+#include "NESCPU.h"
+
+//x86-64 hosts only, everywhere else Run never executes anything and cpu is interpreted
+#if defined(__x86_64__) || defined(_M_X64)
+#define NES_JIT_X64
+#endif
+
+class NESDevice;
+
+//Block recompiler : translates straight-line runs of PRG ROM code into native x86-64 code
+// block ends at branch/jump/return, at instruction touching I/O (PPU, APU, mapper registers)
+// or at anything not worth compiling (interrupt flag changes, RTI, BRK, illegal opcodes).
+// Accesses with address known only at runtime exit block before instruction if it hits I/O,
+// so interpreter executes it with proper device sync. Code in RAM is never compiled.
+class NESJIT
+{
+public:
+	NESJIT(NESDevice* nesDevice, uint8_t* const* cpuReadPages, uint8_t* const* cpuWritePages);
+	~NESJIT();
+
+	//False if host isn't supported or executable memory couldn't be allocated
+	// (memory is allocated on first Run, instances which never run JIT don't pay for it)
+	bool IsSupported();
+	//Heap and executable memory owned by recompiler (bytes)
+	size_t GetMemoryFootprint();
+	//Drops all compiled blocks (has to be called when PRG memory is reloaded)
+	void Reset();
+	//Runs compiled block at cpu PC if it can't take longer than 'max_cycles',
+	// returns amount of cycles taken, 0 if nothing was executed (interpreter has to step)
+	uint32_t Run(uint32_t max_cycles);
+
+	//Statistics
+	uint64_t BlocksCompiled;
+	uint64_t InstructionsExecuted;
+
+protected:
+	static const uint32_t MaxBlockInstructions = 32;
+	static const uint32_t BlockCacheSize = 2048;
+	static const uint32_t CodeBufferSize = 2 * 1024 * 1024;
+	static const uint32_t CompileThreshold = 2;	//Executions before block is compiled
+
+	//State shared with generated code (rbx points to it while block runs)
+	struct Context
+	{
+		uint8_t* const* ReadPages;
+		uint8_t* const* WritePages;
+		const uint8_t*  NZFlags;
+		uint32_t ExtraCycles;	//Page crossing and taken branch penalties
+		uint32_t ExtraIndex;	//Instruction which added last penalty
+		uint16_t PC;			//Set by last instruction of fully executed block
+		uint8_t  AC, XR, YR, SR, SP;
+	};
+
+	//Compiled block, direct mapped by address and tagged by pointer to source ROM
+	struct Block
+	{
+		const uint8_t* Source = nullptr;
+		const uint8_t* Code = nullptr;
+		bool	 IsFailed = false;	//First instruction can't be compiled
+		uint32_t Hits = 0;
+		uint32_t Count = 0;
+		uint32_t MaxCycles = 0;
+		uint16_t PC[MaxBlockInstructions];
+		uint16_t Cycles[MaxBlockInstructions + 1];	//Static cycles before instruction
+		uint8_t  OpCode[MaxBlockInstructions];
+		NESCPU::AddrMode Mode[MaxBlockInstructions];
+		uint8_t  Penalty[MaxBlockInstructions];		//Cycles added at runtime (page crossing, taken branch)
+	};
+
+	//Ptr to main device for io operations
+	NESDevice* m_NESDevicePtr;
+	uint8_t* const* m_CPUReadPages;
+	uint8_t* const* m_CPUWritePages;
+
+	Context m_Context;
+	uint8_t m_NZFlags[256];
+	std::vector<Block> m_Blocks;
+
+	//Executable memory, starts with entry/exit trampoline shared by all blocks
+	uint8_t* m_CodeBuffer;
+	bool	 m_IsAllocationFailed;
+	uint32_t m_CodeSize;
+	uint32_t m_CodeStart;
+	uint32_t m_ExitOffset;
+
+	//Block being emitted
+	std::vector<uint8_t> m_Code;
+	std::vector<std::pair<uint32_t, uint32_t>> m_ExitFixups;	//Offset of rel32 to side exit, instruction index
+	std::vector<uint32_t> m_ExitJumps;	//Offsets of rel32 to common exit
+	bool m_Terminated;					//Last instruction already stored PC
+
+	bool compile_block(Block& block, uint16_t address, const uint8_t* source);
+	//Emits single instruction, returns its size, 0 if it can't be compiled
+	uint32_t compile_instruction(Block& block, uint32_t index, uint16_t address, const uint8_t* source, bool* is_terminal);
+	void emit_trampoline();
+	//Allocates code buffer and block cache, false if recompiler can't be used
+	bool allocate();
+
+	//Emitter helpers, 'reg' arguments are x86 register numbers (A:r12, X:r13, Y:r14, SR:r15)
+	void emit(std::initializer_list<uint8_t> bytes);
+	void emit32(uint32_t value);
+	void emit_rr(uint8_t opcode, uint8_t rm, uint8_t reg, bool is_byte = false);
+	void emit_nz(uint8_t reg);
+	void emit_exit_check(uint32_t index);
+	void emit_page_lookup(bool is_write, uint32_t index);
+	void emit_const_page(bool is_write, uint16_t address, uint32_t index);
+	void emit_penalty(uint32_t index, uint8_t cycles);
+	void emit_push();
+	void emit_pull();
+};
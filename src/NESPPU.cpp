@@ -6,12 +6,16 @@ NESPPU::NESPPU(NESDevice* nesDevice)
 {
 	this->m_NESDevicePtr = nesDevice;
 
-	this->m_RGB_Framebuffer = new RGBPixel[256 * 256];
-	this->m_RGB_Patterntable[0] = new RGBPixel[128 * 128];
-	this->m_RGB_Patterntable[1] = new RGBPixel[128 * 128];
-	this->m_RGB_Nametables = new RGBPixel[512 * 512];
+	this->m_Framebuffer = new uint8_t[256 * 240];
+	this->m_RGB_Framebuffer = nullptr;
+	this->m_RGB_Patterntable[0] = nullptr;
+	this->m_RGB_Patterntable[1] = nullptr;
+	this->m_RGB_Nametables = nullptr;
+	this->m_IsDebugBuffersEnabled = true;
+	this->m_CompositorKernel = NESCompositor::GetBestKernel();
 
-	memset(this->m_RGB_Framebuffer, 0x20, 256 * 256 * sizeof(RGBPixel));
+	memset(this->m_Framebuffer, 0x0F, 256 * 240);
+	memset(this->m_LineEmphasis, 0x00, sizeof(this->m_LineEmphasis));
 
 	m_IsFrameReady = false;
 	m_IsLineReady = false;
@@ -21,10 +25,9 @@ NESPPU::NESPPU(NESDevice* nesDevice)
 
 NESPPU::~NESPPU()
 {
+	delete[] this->m_Framebuffer;
 	delete[] this->m_RGB_Framebuffer;
-	delete[] this->m_RGB_Patterntable[0];
-	delete[] this->m_RGB_Patterntable[1];
-	delete[] this->m_RGB_Nametables;
+	release_debug_buffers();
 
 	m_IsFrameReady = false;
 }
@@ -114,7 +117,7 @@ void NESPPU::CPUWrite(uint16_t address, uint8_t data)
 		PPURegisters[PPURegister::OAMADDR] = data;
 		break;
 	case 0x2004: //OAMDATA
-		OAMData[PPURegisters[PPURegister::OAMADDR]] = data;
+		WriteOAMByte(PPURegisters[PPURegister::OAMADDR], data);
 		PPURegisters[PPURegister::OAMADDR]++;
 		break;
 	case 0x2005: //PPUSCROLL
@@ -237,6 +240,7 @@ void NESPPU::Reset()
 	memset(PPURegisters, 0, 8);
 	memset(OAMData, 0xFF, 256);
 	memset(SecondOAMData, 0xFF, 32);
+	m_IsSpriteListsDirty = true;
 
 	//Internal registers
 	VRAMRegister = 0x0000;
@@ -270,12 +274,295 @@ void NESPPU::Reset()
 	DBG_ScrollY = 0;
 	DBG_GlobalCycle = 0;
 
+	this->update_sprite_rows();
+
 	PPUCycle = 0;
 	PPUScanline = 0;
 	PPUFrameCycle = 0;
 	PPUFrameCounter = 0;
 }
 
+//Pixel indices (0-3) of one pattern row, left to right (right to left if flipped)
+inline void NESPPU::expand_pattern(uint8_t lo_plane, uint8_t hi_plane, bool is_flipped, uint8_t* pixels)
+{
+	for (uint32_t column = 0; column < 8; column++)
+	{
+		const uint32_t bit = is_flipped ? column : (7 - column);
+		pixels[column] = (((hi_plane >> bit) & 0x01) << 1) | ((lo_plane >> bit) & 0x01);
+	}
+}
+
+inline void NESPPU::load_background_shifters()
+{
+	//Upload tile planes to shift registers
+	BackgroundLOShiftRegister = (BackgroundLOShiftRegister & 0xFF00) | NextPatternLOByte;
+	BackgroundHIShiftRegister = (BackgroundHIShiftRegister & 0xFF00) | NextPatternHIByte;
+	//Upload attrib to shift register
+	BackgroundAttribRegister = (BackgroundAttribRegister << 2) | NextAttrib;
+}
+
+// Thanks to : https://www.nesdev.org/wiki/PPU_scrolling#Tile_and_attribute_fetching
+// tile address      = 0x2000 | (v & 0x0FFF)
+// attribute address = 0x23C0 | (v & 0x0C00) | ((v >> 4) & 0x38) | ((v >> 2) & 0x07)
+inline void NESPPU::fetch_nametable()
+{
+	//Construct fetch address
+	const uint16_t fetch_addr =
+		0x2000					  |	//Nametables offset on ppu bus
+		(VRAMRegister & 0x0FFF);	//Taking only 12 significant bits
+	//Fetch data
+	NextTile = m_NESDevicePtr->PPURead(fetch_addr);
+}
+
+inline void NESPPU::fetch_attribute()
+{
+	//Construct fetch address
+	const uint16_t fetch_addr =
+		0x23C0						 |	//Attribs offset on the ppu bus
+		(VRAMRegister & 0x0C00)      |	//Nametables offset
+		((VRAMRegister >> 4) & 0x38) |	//Divide coarse y by 4 (>>2) and append it ((>>2)&0x38)
+		((VRAMRegister >> 2) & 0x07);	//Divide coarse x by 4 (>>2) and append it (&0x07)
+	//Contruct attrib offset
+	const uint8_t shift =
+		(VRAMRegister >> 4) & 0x04 |// V: [........ .B....A.] -> SHIFT: [.....BA.]
+		(VRAMRegister >> 0) & 0x02;	// Clever way to get shift for tile in attrib byte 
+	//Fetch data and instantly isolate required attrib
+	// also shift result 2 left, just for convenience in next calc 
+	NextAttrib = ((m_NESDevicePtr->PPURead(fetch_addr) >> shift) & 0x03) << 2;
+}
+
+inline void NESPPU::fetch_pattern_lo()
+{
+	//Construct fetch address
+	const uint16_t fetch_addr = 
+		(uint16_t)	(PPURegisters[PPURegister::PPUCTRL] & 0x10) << 8 |  // Background patterntable 0x0000 or 0x1000
+					(VRAMRegister & 0x7000) >> 12					 |  // y offset (fine_y from V register)
+					(NextTile << 4) + 0;								  // tileId multiplied by 16
+	//Fetch data
+	NextPatternLOByte = m_NESDevicePtr->PPURead(fetch_addr);
+}
+
+inline void NESPPU::fetch_pattern_hi()
+{
+	//Construct fetch address
+	const uint16_t fetch_addr =
+		(uint16_t)	(PPURegisters[PPURegister::PPUCTRL] & 0x10) << 8 |  // Background patterntable 0x0000 or 0x1000
+					(VRAMRegister & 0x7000) >> 12					 |  // y offset (fine_y from V register)
+					(NextTile << 4) + 8;							    // tileId multiplied by 16 (+ HI byte offset)
+	//Fetch data
+	NextPatternHIByte = m_NESDevicePtr->PPURead(fetch_addr);
+}
+
+inline void NESPPU::increment_scroll_x()
+{
+	//if coarse_x == 31
+	if ((VRAMRegister & 0x001F) == 31)
+	{
+		// coarse_x = 0
+		CLEAR_BIT_FIELD(VRAMRegister, PPUInternalRegister::coarse_x);
+		// switch horizontal nametables
+		TOGGLE_BIT_FIELD(VRAMRegister, PPUInternalRegister::nametable_x);
+	}
+	else
+	{
+		VRAMRegister += 1;
+	}
+}
+
+inline void NESPPU::increment_scroll_y()
+{
+	//If fine_y of V != 7 - increment fine_y
+	if ((VRAMRegister & 0x7000) != 0x7000)
+	{
+		VRAMRegister += 0x1000;	
+	}
+	else
+	{
+		//set fine_y = 0
+		VRAMRegister &= ~0x7000;
+		uint8_t coarse_y = READ_BIT_FIELD(VRAMRegister, PPUInternalRegister::coarse_y);
+		if (coarse_y == 29)
+		{
+			// coarse_y = 0
+			CLEAR_BIT_FIELD(VRAMRegister, PPUInternalRegister::coarse_y);
+			// switch vertical nametables
+			TOGGLE_BIT_FIELD(VRAMRegister, PPUInternalRegister::nametable_y);
+		}
+		else if (coarse_y == 31)
+		{
+			// coarse_y = 0
+			CLEAR_BIT_FIELD(VRAMRegister, PPUInternalRegister::coarse_y);
+		}
+		else
+		{
+			// increment coarse_y and store it in register
+			coarse_y++;
+			WRITE_BIT_FIELD(VRAMRegister, coarse_y, PPUInternalRegister::coarse_y);
+		}
+	}
+}
+
+//Index of the lowest set bit (mask != 0)
+static inline uint32_t LowestBit(uint64_t mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return (uint32_t)__builtin_ctzll(mask);
+#else
+	uint32_t bit = 0;
+	while (!(mask & 0x01)) { mask >>= 1; bit++; }
+	return bit;
+#endif
+}
+
+void NESPPU::build_sprite_lists()
+{
+	m_SpriteListsHeight = GET_BIT_FIELD(PPURegisters[PPURegister::PPUCTRL], PPUCTRL::sprite_size) ? 16 : 8;
+	m_IsSpriteListsDirty = false;
+
+	memset(m_SpriteLists, 0, sizeof(m_SpriteLists));
+	for (uint32_t sprite = 0; sprite < 64; sprite++)
+		move_sprite(sprite, 0xFF, OAMData[sprite * 4]);
+}
+
+void NESPPU::move_sprite(uint32_t sprite, uint8_t old_top, uint8_t new_top)
+{
+	//Only lines sprite leaves or enters are touched, order and overflow come from bit positions
+	const uint64_t bit = (uint64_t)1 << sprite;
+	for (uint32_t line = old_top; line < (uint32_t)old_top + m_SpriteListsHeight && line < 240; line++)
+		m_SpriteLists[line] &= ~bit;
+	for (uint32_t line = new_top; line < (uint32_t)new_top + m_SpriteListsHeight && line < 240; line++)
+		m_SpriteLists[line] |= bit;
+}
+
+inline void NESPPU::evaluate_sprites()
+{
+	//Lists follow OAM writes, sprite size may change any time
+	const uint8_t sprite_size = GET_BIT_FIELD(PPURegisters[PPURegister::PPUCTRL], PPUCTRL::sprite_size) ? 16 : 8;
+	if (m_IsSpriteListsDirty || m_SpriteListsHeight != sprite_size)
+		build_sprite_lists();
+
+	uint64_t sprites = m_SpriteLists[PPUScanline];
+	SecondOAMSprites = 0;
+	while (sprites != 0 && SecondOAMSprites < 8)
+	{
+		const uint32_t address = LowestBit(sprites) * 4;
+		sprites &= sprites - 1;
+		memcpy(&SecondOAMData[SecondOAMSprites * 4], &OAMData[address], sizeof(uint8_t) * 4);
+
+		//Using 'unused' bit in byte 2 to indicate sprite 0
+		if (address == 0) OAMData[address + 2] |= 0x1C;
+		SecondOAMSprites++;
+	}
+	//Ninth sprite in range
+	if (sprites != 0)
+		SET_BIT_FIELD(PPURegisters[PPURegister::PPUSTATUS], PPUSTATUS::sprite_overflow);
+}
+
+inline void NESPPU::fetch_sprites()
+{
+	memset(SpriteOutputUnits, 0xFF, sizeof(SpriteOutputUnit) * 8);
+	//Empty units are still drawn at the last dot (see render_line), pattern 0xFF is color 3
+	memset(m_SpriteRows, 0x03, sizeof(m_SpriteRows));
+	for (uint8_t sprite = 0; sprite < SecondOAMSprites; sprite++)
+	{
+		uint8_t address = (sprite << 2);
+		uint16_t pattern_addres = 0x00;
+		uint16_t distance_w = PPUScanline - SecondOAMData[address];
+		uint16_t pattern_line = (SecondOAMData[address + 2] & 0x80) ? 
+									(7 - (distance_w) & 0x07) :
+										 (distance_w) & 0x07  ;
+
+		if (!GET_BIT_FIELD(PPURegisters[PPURegister::PPUCTRL], PPUCTRL::sprite_size))
+		{
+			// sprite size 8x8
+			pattern_addres =
+				((PPURegisters[PPURegister::PPUCTRL] & 0x08) << 9) | //Pattern table offset
+				((SecondOAMData[address + 1])			     << 4) | //Tile offset
+				pattern_line									   ; //Offset to required byte acording Y and HFlip (if present)
+		}
+		else
+		{
+			//sprite size 8x16
+
+			//If V flip is required - inverse distance bit 4
+			if (SecondOAMData[address + 2] & 0x80)
+				distance_w ^= 0x08;
+
+			pattern_addres =
+				((SecondOAMData[address + 1] & 0x01) << 12)	| //Pattern table offset
+				((SecondOAMData[address + 1] & 0xFE) << 4)	| //First tile offset
+				(distance_w & 0x08) << 1					| //Offset to second half if ditance >= 8
+				pattern_line								; //Offset to required byte acording inside tile
+		}
+		
+		//Transfer info
+		SpriteOutputUnits[sprite].x_offset = SecondOAMData[address + 3];
+		SpriteOutputUnits[sprite].attrib = SecondOAMData[address + 2];
+		//Fetch bytes
+		SpriteOutputUnits[sprite].pattern_lo = m_NESDevicePtr->PPURead(pattern_addres);
+		SpriteOutputUnits[sprite].pattern_hi = m_NESDevicePtr->PPURead(pattern_addres + 8);
+		//Pixels come from tile cache, flipped copy of the row if sprite is flipped
+		const bool is_flipped = (SpriteOutputUnits[sprite].attrib & 0x40) != 0;
+		const uint8_t* decoded = m_NESDevicePtr->GetPPUTile(pattern_addres);
+		if (decoded != nullptr)
+			memcpy(m_SpriteRows[sprite], &decoded[(is_flipped ? 64 : 0) + (pattern_addres & 0x07) * 8], 8);
+		else
+			expand_pattern(SpriteOutputUnits[sprite].pattern_lo, SpriteOutputUnits[sprite].pattern_hi, is_flipped, m_SpriteRows[sprite]);
+	}
+}
+
+inline void NESPPU::render_pixel(uint8_t x)
+{
+	uint8_t screen_color = 0x00;
+	uint8_t screen_palette = 0x00;
+
+	//If background enabled - get it color
+	if (GET_BIT_FIELD(PPURegisters[PPURegister::PPUMASK], PPUMASK::render_background))
+	{
+		const uint8_t attrib_offset = ((FineX + (x & 0x07) < 8) ? 2 : 0);
+		screen_color = (
+			(((BackgroundLOShiftRegister << FineX) & 0x8000) >> 15) |
+			(((BackgroundHIShiftRegister << FineX) & 0x8000) >> 14)
+		);
+		screen_palette = ((BackgroundAttribRegister >> attrib_offset) & 0x0C);
+	}
+
+	//Check sprites
+	if (GET_BIT_FIELD(PPURegisters[PPURegister::PPUMASK], PPUMASK::render_sprites))
+	{
+		for (uint8_t sprite = 0; sprite < SecondOAMSprites; sprite++)
+		{
+			uint8_t sprite_color = 0x00;
+			int16_t offset = x - SpriteOutputUnits[sprite].x_offset;
+			if (offset >= 0 && offset < 8)
+				sprite_color = m_SpriteRows[sprite][offset];
+
+			//If sprite with not transparent color 
+			if (sprite_color != 0x00)
+			{
+				//Check zero sprite hit
+				if (screen_color != 0x00 && (SpriteOutputUnits[sprite].attrib & 0x1C))
+					SET_BIT_FIELD(PPURegisters[PPURegister::PPUSTATUS], PPUSTATUS::sprite_zero_hit);
+
+				//If screen color not present or current sprite has priority
+				if (screen_color == 0x00 || !(SpriteOutputUnits[sprite].attrib & 0x20))
+				{
+					screen_color = sprite_color;
+					screen_palette = 0x10 | ((SpriteOutputUnits[sprite].attrib & 0x03) << 2);
+				}
+				break;
+			}
+		}
+	}
+
+	if (GET_BIT_FIELD(PPURegisters[PPURegister::PPUMASK], PPUMASK::rendering_enabled))
+	{
+		if (x == 0)
+			m_LineEmphasis[PPUScanline] = PPURegisters[PPURegister::PPUMASK] >> 5;
+		m_Framebuffer[(PPUScanline * 256) + x] = Palettes[(screen_color & 0x03) ? (screen_palette + screen_color) : 0x00] & 0x3F;
+	}
+}
+
 void NESPPU::Update()
 {
 	//ohhh.... yeah... this... thing...
@@ -334,118 +621,29 @@ void NESPPU::Update()
 			BackgroundLOShiftRegister <<= 1;
 			BackgroundHIShiftRegister <<= 1;
 
-			// Thanks to : https://www.nesdev.org/wiki/PPU_scrolling#Tile_and_attribute_fetching
-			// tile address      = 0x2000 | (v & 0x0FFF)
-			// attribute address = 0x23C0 | (v & 0x0C00) | ((v >> 4) & 0x38) | ((v >> 2) & 0x07)
 			switch (PPUCycle & 0x07)
 			{
 			case 1: //Fetch nametable byte
-				{
-					//Upload tile planes to shift registers
-					BackgroundLOShiftRegister = (BackgroundLOShiftRegister & 0xFF00) | NextPatternLOByte;
-					BackgroundHIShiftRegister = (BackgroundHIShiftRegister & 0xFF00) | NextPatternHIByte;
-					//Upload attrib to shift register
-					BackgroundAttribRegister = (BackgroundAttribRegister << 2) | NextAttrib;
-
-
-					//Construct fetch address
-					const uint16_t fetch_addr =
-						0x2000					  |	//Nametables offset on ppu bus
-						(VRAMRegister & 0x0FFF);	//Taking only 12 significant bits
-					//Fetch data
-					NextTile = m_NESDevicePtr->PPURead(fetch_addr);
-				}
+				load_background_shifters();
+				fetch_nametable();
 				break;
 			case 3: //Fetch attribute table byte
-				{
-					//Construct fetch address
-					const uint16_t fetch_addr =
-						0x23C0						 |	//Attribs offset on the ppu bus
-						(VRAMRegister & 0x0C00)      |	//Nametables offset
-						((VRAMRegister >> 4) & 0x38) |	//Divide coarse y by 4 (>>2) and append it ((>>2)&0x38)
-						((VRAMRegister >> 2) & 0x07);	//Divide coarse x by 4 (>>2) and append it (&0x07)
-					//Contruct attrib offset
-					const uint8_t shift =
-						(VRAMRegister >> 4) & 0x04 |// V: [........ .B....A.] -> SHIFT: [.....BA.]
-						(VRAMRegister >> 0) & 0x02;	// Clever way to get shift for tile in attrib byte 
-					//Fetch data and instantly isolate required attrib
-					// also shift result 2 left, just for convenience in next calc 
-					NextAttrib = ((m_NESDevicePtr->PPURead(fetch_addr) >> shift) & 0x03) << 2;
-				}
+				fetch_attribute();
 				break;
 			case 5: //Fetch pattern table tile low
-				{
-					//Construct fetch address
-					const uint16_t fetch_addr = 
-						(uint16_t)	(PPURegisters[PPURegister::PPUCTRL] & 0x10) << 8 |  // Background patterntable 0x0000 or 0x1000
-									(VRAMRegister & 0x7000) >> 12					 |  // y offset (fine_y from V register)
-									(NextTile << 4) + 0;								  // tileId multiplied by 16
-					//Fetch data
-					NextPatternLOByte = m_NESDevicePtr->PPURead(fetch_addr);
-				}
+				fetch_pattern_lo();
 				break;
 			case 7: //Fetch pattern table tile high 
-				{
-					//Construct fetch address
-					const uint16_t fetch_addr =
-						(uint16_t)	(PPURegisters[PPURegister::PPUCTRL] & 0x10) << 8 |  // Background patterntable 0x0000 or 0x1000
-									(VRAMRegister & 0x7000) >> 12					 |  // y offset (fine_y from V register)
-									(NextTile << 4) + 8;							    // tileId multiplied by 16 (+ HI byte offset)
-					//Fetch data
-					NextPatternHIByte = m_NESDevicePtr->PPURead(fetch_addr);
-				}
+				fetch_pattern_hi();
 				break;
 			}
 			// ******************************** Scroll operations ********************************
 			//Scrolling X
 			if ((PPUCycle % 8) == 0)
-			{
-				//if coarse_x == 31
-				if ((VRAMRegister & 0x001F) == 31)
-				{
-					// coarse_x = 0
-					CLEAR_BIT_FIELD(VRAMRegister, PPUInternalRegister::coarse_x);
-					// switch horizontal nametables
-					TOGGLE_BIT_FIELD(VRAMRegister, PPUInternalRegister::nametable_x);
-				}
-				else
-				{
-					VRAMRegister += 1;
-				}
-			}
+				increment_scroll_x();
 			//Scrolling Y
 			if (PPUCycle == 256)
-			{
-				//If fine_y of V != 7 - increment fine_y
-				if ((VRAMRegister & 0x7000) != 0x7000)
-				{
-					VRAMRegister += 0x1000;	
-				}
-				else
-				{
-					//set fine_y = 0
-					VRAMRegister &= ~0x7000;
-					uint8_t coarse_y = READ_BIT_FIELD(VRAMRegister, PPUInternalRegister::coarse_y);
-					if (coarse_y == 29)
-					{
-						// coarse_y = 0
-						CLEAR_BIT_FIELD(VRAMRegister, PPUInternalRegister::coarse_y);
-						// switch vertical nametables
-						TOGGLE_BIT_FIELD(VRAMRegister, PPUInternalRegister::nametable_y);
-					}
-					else if (coarse_y == 31)
-					{
-						// coarse_y = 0
-						CLEAR_BIT_FIELD(VRAMRegister, PPUInternalRegister::coarse_y);
-					}
-					else
-					{
-						// increment coarse_y and store it in register
-						coarse_y++;
-						WRITE_BIT_FIELD(VRAMRegister, coarse_y, PPUInternalRegister::coarse_y);
-					}
-				}
-			}
+				increment_scroll_y();
 			// ******************************** Sprites Evaluation ********************************
 			//Clear Secondary OAM (Cycles 1 - 64)
 			// no need to do it every cycle, we will clear everything at once at the last cycle
@@ -456,75 +654,11 @@ void NESPPU::Update()
 			//Sprite evaluation (Cycles 65 - 256)
 			// again... we will do it at once at 256
 			if (PPUScanline >= 0 && PPUCycle == 256) 
-			{
-				SecondOAMSprites = 0; //Reset sprite counter
-				for (uint32_t address = 0; address < 256; address += 4)
-				{
-					int16_t distance_y = PPUScanline - (int16_t)OAMData[address];
-					uint8_t sprite_size = GET_BIT_FIELD(PPURegisters[PPURegister::PPUCTRL], PPUCTRL::sprite_size) ? 16 : 8;
-					if (distance_y >= 0 && distance_y < sprite_size)
-					{
-						if (SecondOAMSprites < 8)
-						{
-							memcpy(&SecondOAMData[SecondOAMSprites*4], &OAMData[address], sizeof(uint8_t) * 4);
-
-							//Using 'unused' bit in byte 2 to indicate sprite 0
-							if (address == 0) OAMData[address + 2] |= 0x1C;
-						}
-						else
-						{
-							SET_BIT_FIELD(PPURegisters[PPURegister::PPUSTATUS], PPUSTATUS::sprite_overflow);
-							break; //overflow detected, we done here
-						}
-						SecondOAMSprites++;
-					}
-				}
-			}
+				evaluate_sprites();
 			//Sprite fetches (Cycles 257-320)
 			// and again... we will do it at once at 321
 			if (PPUScanline >= 0 && PPUCycle == 321)
-			{
-				memset(SpriteOutputUnits, 0xFF, sizeof(SpriteOutputUnit) * 8);
-				for (uint8_t sprite = 0; sprite < SecondOAMSprites; sprite++)
-				{
-					uint8_t address = (sprite << 2);
-					uint16_t pattern_addres = 0x00;
-					uint16_t distance_w = PPUScanline - SecondOAMData[address];
-					uint16_t pattern_line = (SecondOAMData[address + 2] & 0x80) ? 
-												(7 - (distance_w) & 0x07) :
-													 (distance_w) & 0x07  ;
-
-					if (!GET_BIT_FIELD(PPURegisters[PPURegister::PPUCTRL], PPUCTRL::sprite_size))
-					{
-						// sprite size 8x8
-						pattern_addres =
-							((PPURegisters[PPURegister::PPUCTRL] & 0x08) << 9) | //Pattern table offset
-							((SecondOAMData[address + 1])			     << 4) | //Tile offset
-							pattern_line									   ; //Offset to required byte acording Y and HFlip (if present)
-					}
-					else
-					{
-						//sprite size 8x16
-
-						//If V flip is required - inverse distance bit 4
-						if (SecondOAMData[address + 2] & 0x80)
-							distance_w ^= 0x08;
-
-						pattern_addres =
-							((SecondOAMData[address + 1] & 0x01) << 12)	| //Pattern table offset
-							((SecondOAMData[address + 1] & 0xFE) << 4)	| //First tile offset
-							(distance_w & 0x08) << 1					| //Offset to second half if ditance >= 8
-							pattern_line								; //Offset to required byte acording inside tile
-					}
-					
-					//Transfer info
-					SpriteOutputUnits[sprite].x_offset = SecondOAMData[address + 3];
-					SpriteOutputUnits[sprite].attrib = SecondOAMData[address + 2];
-					//Fetch bytes
-					SpriteOutputUnits[sprite].pattern_lo = m_NESDevicePtr->PPURead(pattern_addres);
-					SpriteOutputUnits[sprite].pattern_hi = m_NESDevicePtr->PPURead(pattern_addres + 8);
-				}
-			}
+				fetch_sprites();
 		}
 
 		if (PPUScanline == -1 && PPUCycle >= 280 && PPUCycle <= 304)
@@ -553,72 +687,7 @@ void NESPPU::Update()
 
 	//'Actual' rendering
 	if (PPUScanline >= 0 && PPUScanline < 240 && PPUCycle >= 1 && PPUCycle < 257)
-	{
-		uint8_t screen_color = 0x00;
-		uint8_t screen_palette = 0x00;
-
-		//If background enabled - get it color
-		if (GET_BIT_FIELD(PPURegisters[PPURegister::PPUMASK], PPUMASK::render_background))
-		{
-			const uint8_t attrib_offset = ((FineX + ((PPUCycle-1) & 0x07) < 8) ? 2 : 0);
-			screen_color = (
-				(((BackgroundLOShiftRegister << FineX) & 0x8000) >> 15) |
-				(((BackgroundHIShiftRegister << FineX) & 0x8000) >> 14)
-			);
-			screen_palette = ((BackgroundAttribRegister >> attrib_offset) & 0x0C);
-		}
-
-		//Check sprites
-		if (GET_BIT_FIELD(PPURegisters[PPURegister::PPUMASK], PPUMASK::render_sprites))
-		{
-			for (uint8_t sprite = 0; sprite < SecondOAMSprites; sprite++)
-			{
-				uint8_t sprite_color = 0x00;
-				int16_t offset = (PPUCycle - 1) - SpriteOutputUnits[sprite].x_offset;
-				if (offset >= 0 && offset < 8)
-				{
-					if (SpriteOutputUnits[sprite].attrib & 0x40)
-					{
-						sprite_color = (
-							(((SpriteOutputUnits[sprite].pattern_hi >> offset) & 0x01) << 1) |
-							(((SpriteOutputUnits[sprite].pattern_lo >> offset) & 0x01) << 0)
-							);
-					}
-					else
-					{
-						sprite_color = (
-							(((SpriteOutputUnits[sprite].pattern_hi << offset) & 0x80) >> 6) |
-							(((SpriteOutputUnits[sprite].pattern_lo << offset) & 0x80) >> 7)
-							);
-					}
-				}
-
-				//If sprite with not transparent color 
-				if (sprite_color != 0x00)
-				{
-					//Check zero sprite hit
-					if (screen_color != 0x00 && (SpriteOutputUnits[sprite].attrib & 0x1C))
-						SET_BIT_FIELD(PPURegisters[PPURegister::PPUSTATUS], PPUSTATUS::sprite_zero_hit);
-
-					//If screen color not present or current sprite has priority
-					if (screen_color == 0x00 || !(SpriteOutputUnits[sprite].attrib & 0x20))
-					{
-						screen_color = sprite_color;
-						screen_palette = 0x10 | ((SpriteOutputUnits[sprite].attrib & 0x03) << 2);
-					}
-					break;
-				}
-			}
-		}
-
-		if(GET_BIT_FIELD(PPURegisters[PPURegister::PPUMASK], PPUMASK::rendering_enabled))
-			m_RGB_Framebuffer[((PPUScanline * 256) + (PPUCycle-1))] = 
-			m_RGB_Palette[
-				Palettes[
-					(screen_color & 0x03) ? (screen_palette + screen_color) : 0x00
-				]
-			];
-	}
+		render_pixel((uint8_t)(PPUCycle - 1));
 
 	//Advance PPU Cycles
 	PPUCycle++;
@@ -641,6 +710,124 @@ void NESPPU::Update()
 	DBG_GlobalCycle++;
 }
 
+void NESPPU::Run(uint32_t cycles, bool render_lines)
+{
+	while (cycles > 0)
+	{
+		//Whole visible part of line fits into this run, so nothing (register write, bank switch)
+		// can happen in the middle of it, otherwise dot renderer takes the line
+		if (render_lines && PPUCycle == 1 && cycles >= 256 && PPUScanline >= 0 && PPUScanline < 240)
+		{
+			this->render_line();
+			cycles -= 256;
+			continue;
+		}
+		this->Update();
+		cycles--;
+	}
+}
+
+void NESPPU::render_line()
+{
+	const uint8_t mask = PPURegisters[PPURegister::PPUMASK];
+	if (GET_BIT_FIELD(mask, PPUMASK::rendering_enabled))
+	{
+		const bool is_background = GET_BIT_FIELD(mask, PPUMASK::render_background);
+		const bool is_sprites = GET_BIT_FIELD(mask, PPUMASK::render_sprites);
+
+		//Background tiles in order they pass through shift registers, 8 pixels each, pixel x is at x + FineX
+		// first two were fetched on previous line (they are in shift registers and next pattern bytes),
+		// the rest comes from fetches of this line. Every 8 dots shift registers move by whole tile,
+		// so they are advanced once per tile (reload at first dot, 7 more shifts).
+		// Pixels are palette indices (palette << 2 | color), line is composed straight from them
+		uint8_t tile_pixels[33 * 8];
+		auto set_tile_palette = [&tile_pixels](uint32_t tile, uint8_t palette)
+		{
+			for (uint32_t pixel = 0; pixel < 8; pixel++)
+				tile_pixels[tile * 8 + pixel] |= palette;
+		};
+		expand_pattern((uint8_t)(BackgroundLOShiftRegister >> 7), (uint8_t)(BackgroundHIShiftRegister >> 7), false, &tile_pixels[0]);
+		set_tile_palette(0, BackgroundAttribRegister & 0x0C);
+		expand_pattern(NextPatternLOByte, NextPatternHIByte, false, &tile_pixels[8]);
+		set_tile_palette(1, NextAttrib);
+
+		for (uint32_t tile = 0; tile < 32; tile++)
+		{
+			//Dots 8 * tile + 1 ... 8 * tile + 8
+			BackgroundLOShiftRegister = (uint16_t)((((BackgroundLOShiftRegister << 1) & 0xFF00) | NextPatternLOByte) << 7);
+			BackgroundHIShiftRegister = (uint16_t)((((BackgroundHIShiftRegister << 1) & 0xFF00) | NextPatternHIByte) << 7);
+			BackgroundAttribRegister = (BackgroundAttribRegister << 2) | NextAttrib;
+
+			fetch_nametable();
+			fetch_attribute();
+			fetch_pattern_lo();
+			fetch_pattern_hi();
+			increment_scroll_x();
+
+			//Last fetched tile is never visible
+			if (tile < 31)
+			{
+				const uint16_t pattern_address =
+					(uint16_t)(PPURegisters[PPURegister::PPUCTRL] & 0x10) << 8 | (VRAMRegister & 0x7000) >> 12 | (NextTile << 4);
+				const uint8_t* decoded = m_NESDevicePtr->GetPPUTile(pattern_address);
+				if (decoded != nullptr)
+					memcpy(&tile_pixels[(tile + 2) * 8], &decoded[(pattern_address & 0x07) * 8], 8);
+				else
+					expand_pattern(NextPatternLOByte, NextPatternHIByte, false, &tile_pixels[(tile + 2) * 8]);
+				set_tile_palette(tile + 2, NextAttrib);
+			}
+		}
+
+		//First opaque sprite of every pixel (units were fetched on previous line), see NESCompositor
+		// last pixel is left to render_pixel, sprite evaluation at dot 256 changes sprite count before it
+		alignas(32) uint8_t sprite_pixels[256] = {};
+		alignas(32) uint8_t sprite_behind[256] = {};
+		alignas(32) uint8_t sprite_zero[256] = {};
+		if (is_sprites)
+		{
+			for (int32_t sprite = SecondOAMSprites - 1; sprite >= 0; sprite--)
+			{
+				const SpriteOutputUnit& unit = SpriteOutputUnits[sprite];
+				const uint8_t palette = 0x10 | ((unit.attrib & 0x03) << 2);
+				const uint8_t behind = (unit.attrib & 0x20) ? 0xFF : 0x00;
+				const uint8_t zero = (unit.attrib & 0x1C) ? 0xFF : 0x00;
+				for (uint32_t offset = 0; offset < 8 && unit.x_offset + offset < 255; offset++)
+				{
+					if (m_SpriteRows[sprite][offset] != 0x00)
+					{
+						sprite_pixels[unit.x_offset + offset] = m_SpriteRows[sprite][offset] | palette;
+						sprite_behind[unit.x_offset + offset] = behind;
+						sprite_zero[unit.x_offset + offset] = zero;
+					}
+				}
+			}
+		}
+
+		//Disabled background is transparent, as are sprites outside of the line
+		alignas(32) static const uint8_t transparent_line[256] = {};
+		alignas(32) uint8_t line_indices[256];
+		const uint32_t hit = NESCompositor::ComposeLine(m_CompositorKernel, is_background ? &tile_pixels[FineX] : transparent_line,
+			sprite_pixels, sprite_behind, sprite_zero, line_indices, 256);
+		if (hit < 255)
+			SET_BIT_FIELD(PPURegisters[PPURegister::PPUSTATUS], PPUSTATUS::sprite_zero_hit);
+
+		uint8_t* line = &m_Framebuffer[PPUScanline * 256];
+		for (uint32_t x = 0; x < 255; x++)
+			line[x] = Palettes[line_indices[x]] & 0x3F;
+		m_LineEmphasis[PPUScanline] = mask >> 5;
+
+		//Rest of dot 256
+		increment_scroll_y();
+		memset(SecondOAMData, 0xFF, 32);
+		evaluate_sprites();
+		render_pixel(255);
+	}
+
+	PPUCycle += 256;
+	PPUFrameCycle += 256;
+	DBG_GlobalCycle += 256;
+}
+
 bool NESPPU::IsLineReady()
 {
 	return m_IsLineReady;
@@ -651,6 +838,61 @@ bool NESPPU::IsFrameReady()
 	return m_IsFrameReady;
 }
 
+uint32_t NESPPU::CyclesUntil(int16_t scanline, int16_t cycle)
+{
+	const uint32_t frame_cycles = 341 * 262;
+	const uint32_t skip_position = 341; //scanline 0, cycle 0
+
+	//Positions counted from start of pre-render line (-1)
+	const uint32_t current = (PPUScanline + 1) * 341 + PPUCycle;
+	const uint32_t target = (scanline + 1) * 341 + cycle;
+	const bool rendering = GET_BIT_FIELD(PPURegisters[PPURegister::PPUMASK], PPUMASK::rendering_enabled);
+
+	uint32_t cycles;
+	if (target >= current)
+	{
+		cycles = target - current;
+		if (rendering && (PPUFrameCounter & 0x01) && current <= skip_position && target > skip_position)
+			cycles--;
+	}
+	else
+	{
+		//Target is in the next frame
+		cycles = frame_cycles - current + target;
+		if (rendering && (PPUFrameCounter & 0x01) && current <= skip_position)
+			cycles--;
+		if (rendering && !(PPUFrameCounter & 0x01) && target > skip_position)
+			cycles--;
+	}
+	return cycles;
+}
+
+bool NESPPU::IsOAMIdle(uint32_t cycles)
+{
+	if (!GET_BIT_FIELD(PPURegisters[PPURegister::PPUMASK], PPUMASK::rendering_enabled))
+		return true;
+	//Post-render and vblank lines, up to start of pre-render line
+	return PPUScanline >= 240 && CyclesUntil(-1, 0) >= cycles;
+}
+
+void NESPPU::WriteOAM(const uint8_t* data)
+{
+	for (uint32_t i = 0; i < 256; i++)
+	{
+		WriteOAMByte(PPURegisters[PPURegister::OAMADDR], data[i]);
+		PPURegisters[PPURegister::OAMADDR]++;
+	}
+}
+
+void NESPPU::WriteOAMByte(uint8_t address, uint8_t data)
+{
+	//Only Y coordinates move sprites between lines, tile/attribute/X writes keep the lists
+	// (stale lists are rebuilt as a whole anyway, no need to follow them)
+	if ((address & 0x03) == 0 && OAMData[address] != data && !m_IsSpriteListsDirty)
+		move_sprite(address >> 2, OAMData[address], data);
+	OAMData[address] = data;
+}
+
 bool NESPPU::SaveState(NESState& state)
 {
 	state.Write(Palettes, sizeof(uint8_t) * 32);
@@ -690,6 +932,7 @@ bool NESPPU::LoadState(NESState& state)
 {
 	state.Read(Palettes, sizeof(uint8_t) * 32);
 	state.Read(OAMData, sizeof(uint8_t) * 256);
+	m_IsSpriteListsDirty = true;
 	state.Read(SecondOAMData, sizeof(uint8_t) * 32);
 	state.Read(&SecondOAMSprites, sizeof(uint8_t));
 
@@ -710,6 +953,7 @@ bool NESPPU::LoadState(NESState& state)
 	state.Read(&NextAttrib, sizeof(uint8_t));
 
 	state.Read(SpriteOutputUnits, sizeof(NESPPU::SpriteOutputUnit) * 8);
+	this->update_sprite_rows();
 
 	state.Read(&IsEmitingNMI, sizeof(bool));
 
@@ -721,6 +965,66 @@ bool NESPPU::LoadState(NESState& state)
 	return true;
 }
 
+void NESPPU::update_sprite_rows()
+{
+	for (uint32_t sprite = 0; sprite < 8; sprite++)
+	{
+		const SpriteOutputUnit& unit = SpriteOutputUnits[sprite];
+		expand_pattern(unit.pattern_lo, unit.pattern_hi, (unit.attrib & 0x40) != 0, m_SpriteRows[sprite]);
+	}
+}
+
+void NESPPU::CloneInto(NESPPU& target, bool include_framebuffer)
+{
+	memcpy(target.Palettes, Palettes, sizeof(Palettes));
+	memcpy(target.OAMData, OAMData, sizeof(OAMData));
+	memcpy(target.m_SpriteLists, m_SpriteLists, sizeof(m_SpriteLists));
+	target.m_IsSpriteListsDirty = m_IsSpriteListsDirty;
+	target.m_SpriteListsHeight = m_SpriteListsHeight;
+	memcpy(target.SecondOAMData, SecondOAMData, sizeof(SecondOAMData));
+	target.SecondOAMSprites = SecondOAMSprites;
+
+	memcpy(target.PPURegisters, PPURegisters, sizeof(PPURegisters));
+	target.VRAMRegister = VRAMRegister;
+	target.TRAMRegister = TRAMRegister;
+	target.FineX = FineX;
+	target.InternalWriteLatch = InternalWriteLatch;
+	target.InternalReadBuffer = InternalReadBuffer;
+
+	target.BackgroundLOShiftRegister = BackgroundLOShiftRegister;
+	target.BackgroundHIShiftRegister = BackgroundHIShiftRegister;
+	target.BackgroundAttribRegister = BackgroundAttribRegister;
+
+	target.NextPatternLOByte = NextPatternLOByte;
+	target.NextPatternHIByte = NextPatternHIByte;
+	target.NextTile = NextTile;
+	target.NextAttrib = NextAttrib;
+
+	memcpy(target.SpriteOutputUnits, SpriteOutputUnits, sizeof(SpriteOutputUnits));
+	memcpy(target.m_SpriteRows, m_SpriteRows, sizeof(m_SpriteRows));
+
+	target.IsEmitingNMI = IsEmitingNMI;
+	target.SupressVBL = SupressVBL;
+
+	target.PPUCycle = PPUCycle;
+	target.PPUScanline = PPUScanline;
+	target.PPUFrameCycle = PPUFrameCycle;
+	target.PPUFrameCounter = PPUFrameCounter;
+
+	target.DBG_ScrollX = DBG_ScrollX;
+	target.DBG_ScrollY = DBG_ScrollY;
+	target.DBG_GlobalCycle = DBG_GlobalCycle;
+
+	target.m_IsLineReady = m_IsLineReady;
+	target.m_IsFrameReady = m_IsFrameReady;
+
+	if (include_framebuffer)
+	{
+		memcpy(target.m_Framebuffer, m_Framebuffer, 256 * 240);
+		memcpy(target.m_LineEmphasis, m_LineEmphasis, sizeof(m_LineEmphasis));
+	}
+}
+
 void NESPPU::SetRGBPalette(NESPPU::RGBPixel* newPalette)
 {
 	memcpy(m_RGB_Palette, newPalette, 64 * sizeof(NESPPU::RGBPixel));
@@ -736,13 +1040,64 @@ const NESPPU::RGBPixel& NESPPU::GetRGBColor(uint8_t nesColor)
 	return m_RGB_Palette[nesColor & 0x3F];
 }
 
+const uint8_t* NESPPU::GetIndexFramebuffer()
+{
+	return m_Framebuffer;
+}
+
+const uint8_t* NESPPU::GetLineEmphasis()
+{
+	return m_LineEmphasis;
+}
+
+void NESPPU::ConvertFramebuffer(NESVideo::Format format, uint8_t* output)
+{
+	NESVideo::Convert(format, m_Framebuffer, m_LineEmphasis, (const uint8_t*)m_RGB_Palette, 240, output);
+}
+
 uint8_t* NESPPU::GetFramebuffer()
 {
+	if (m_RGB_Framebuffer == nullptr)
+	{
+		m_RGB_Framebuffer = new RGBPixel[256 * 256];
+		memset(m_RGB_Framebuffer, 0x00, 256 * 256 * sizeof(RGBPixel));
+	}
+	ConvertFramebuffer(NESVideo::Format::RGB24, (uint8_t*)m_RGB_Framebuffer);
 	return (uint8_t*)m_RGB_Framebuffer;
 }
 
+void NESPPU::SetDebugBuffersEnabled(bool enabled)
+{
+	m_IsDebugBuffersEnabled = enabled;
+	if (!enabled) release_debug_buffers();
+}
+
+size_t NESPPU::GetMemoryFootprint()
+{
+	size_t size = 256 * 240;
+	if (m_RGB_Framebuffer) size += 256 * 256 * sizeof(RGBPixel);
+	if (m_RGB_Patterntable[0]) size += 128 * 128 * sizeof(RGBPixel);
+	if (m_RGB_Patterntable[1]) size += 128 * 128 * sizeof(RGBPixel);
+	if (m_RGB_Nametables) size += 512 * 512 * sizeof(RGBPixel);
+	return size;
+}
+
+void NESPPU::release_debug_buffers()
+{
+	delete[] this->m_RGB_Patterntable[0];
+	delete[] this->m_RGB_Patterntable[1];
+	delete[] this->m_RGB_Nametables;
+	this->m_RGB_Patterntable[0] = nullptr;
+	this->m_RGB_Patterntable[1] = nullptr;
+	this->m_RGB_Nametables = nullptr;
+}
+
 uint8_t* NESPPU::ResterizePatterntable(uint8_t id,uint8_t palette)
 {
+	if (!m_IsDebugBuffersEnabled) return nullptr;
+	if (m_RGB_Patterntable[id] == nullptr)
+		m_RGB_Patterntable[id] = new RGBPixel[128 * 128];
+
 	for (uint16_t tile = 0; tile < 256; tile++)
 	{
 		//This piece of cra.. code will convert tile index to target RGB buffer position
@@ -750,6 +1105,21 @@ uint8_t* NESPPU::ResterizePatterntable(uint8_t id,uint8_t palette)
 		// ((tile & 0x0F) * 8) - 'horizontal' offset
 		uint32_t target_offset = ((tile & 0xF0) * 64) + ((tile & 0x0F) * 8);
 
+		//Decoded tile if CHR is plain memory there
+		const uint8_t* decoded = m_NESDevicePtr->GetPPUTile((0x1000 * id) + (tile * 16));
+		if (decoded != nullptr)
+		{
+			for (uint8_t row = 0; row < 8; row++)
+			{
+				for (uint8_t column = 0; column < 8; column++)
+				{
+					uint8_t color_nes = Palettes[(palette << 2) + decoded[row * 8 + column]];
+					m_RGB_Patterntable[id][target_offset + ((row * 128) + column)] = m_RGB_Palette[color_nes];
+				}
+			}
+			continue;
+		}
+
 		for (uint8_t row = 0; row < 8; row++)
 		{
 			uint16_t byte_address = (0x1000 * id) + (tile * 16) + row;
@@ -779,6 +1149,10 @@ uint8_t* NESPPU::ResterizeNametables(uint8_t background_table)
 	// for vertical or horizontal mirroring explicitly
 	// but i wanna keep this piece of code more universal
 
+	if (!m_IsDebugBuffersEnabled) return nullptr;
+	if (m_RGB_Nametables == nullptr)
+		m_RGB_Nametables = new RGBPixel[512 * 512];
+
 	if (background_table > 1)
 		background_table = READ_BIT_FIELD(PPURegisters[PPURegister::PPUCTRL], PPUCTRL::background_table);
 	
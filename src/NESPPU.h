@@ -4,7 +4,9 @@
 #include <cstdio>
 #include <memory>
 
+#include "NESCompositor.h"
 #include "NESState.h"
+#include "NESVideo.h"
 
 class NESDevice;
 
@@ -28,11 +30,27 @@ public:
 
 	void Reset();
 	void Update();
+	//Runs specified amount of cycles at once (used when PPU catches up with cpu)
+	// 'render_lines' - visible lines run completely within this call are rendered at once (see render_line),
+	// caller guarantees nothing touches ppu in the middle of the run and nobody watches ppu bus accesses
+	void Run(uint32_t cycles, bool render_lines = false);
 	bool IsLineReady();
 	bool IsFrameReady();
+	//Amount of ppu cycles (Update calls) left before the one processing specified dot
+	// (takes odd frame skip into account, valid until PPUMASK changes)
+	uint32_t CyclesUntil(int16_t scanline, int16_t cycle);
+	//True if ppu won't access OAM during next 'cycles' ppu cycles (rendering disabled or vblank)
+	bool IsOAMIdle(uint32_t cycles);
+	//Copies whole page into OAM, same as 256 writes into OAMDATA (used by OAM DMA)
+	void WriteOAM(const uint8_t* data);
+	//Single OAM byte at 'address' (OAMDATA writes, debugger)
+	void WriteOAMByte(uint8_t address, uint8_t data);
 
 	bool SaveState(NESState& state);
 	bool LoadState(NESState& state);
+	//Copies ppu state into target (fast path of SaveState/LoadState, see NESDevice::CloneInto)
+	// framebuffer is the biggest part of it, skip it if target won't look at current frame
+	void CloneInto(NESPPU& target, bool include_framebuffer = true);
 
 	//Simple structure for rgb pixel
 	struct RGBPixel	{ uint8_t r, g, b; };
@@ -42,11 +60,24 @@ public:
 	RGBPixel* GetRGBPalette();
 	const RGBPixel& GetRGBColor(uint8_t nesColor);
 
+	//Frame as PPU outputs it : 256 x 240 bytes, NES color (0-63) of every pixel
+	const uint8_t* GetIndexFramebuffer();
+	//Color emphasis bits (PPUMASK >> 5) of every visible line, sampled at its first pixel
+	const uint8_t* GetLineEmphasis();
+	//Converts current frame into 'format' (see NESVideo::GetFrameSize for size of 'output')
+	void ConvertFramebuffer(NESVideo::Format format, uint8_t* output);
+	//256 x 256 RGB24 frame for display, converted from index framebuffer on every call
+	// (allocated on first call, lines below 240 are black)
 	uint8_t* GetFramebuffer();
 	//Function for requesting resterization of PPU memory chunks
+	// debug buffers are allocated on first call, nullptr if they are disabled (see SetDebugBuffersEnabled)
 	uint8_t* ResterizePatterntable(uint8_t id,uint8_t palette = 0);
 	//If background_table > 1 setting from PPUCTRL will be used to determine it
 	uint8_t* ResterizeNametables(uint8_t background_table = 0xFF);
+	//Disabling releases debug buffers (lean headless instances)
+	void SetDebugBuffersEnabled(bool enabled);
+	//Heap memory owned by ppu (bytes)
+	size_t GetMemoryFootprint();
 
 //All things below should be in class::private space but... 
 //	im lazy to write get/set for every register
@@ -55,7 +86,7 @@ public:
 
 	//Internal palette memory
 	uint8_t		Palettes[32];
-	//Internal object attrib memory
+	//Internal object attrib memory (write through WriteOAM/WriteOAMByte, sprite lists follow them)
 	uint8_t		OAMData[256];
 	uint8_t		SecondOAMData[32];
 	uint8_t		SecondOAMSprites;
@@ -113,11 +144,51 @@ protected:
 	bool	 m_IsLineReady;
 	bool	 m_IsFrameReady;
 	
-	//Frame buffer for main Viewport
+	//Frame buffer for main Viewport, NES colors (see GetIndexFramebuffer)
+	uint8_t*  m_Framebuffer;
+	uint8_t	  m_LineEmphasis[240];
+	//Converted frame handed out by GetFramebuffer (allocated on demand)
 	RGBPixel* m_RGB_Framebuffer;
-	//Debug buffers for PPU data viewer
+	//Debug buffers for PPU data viewer (allocated on demand)
 	RGBPixel* m_RGB_Patterntable[2];
 	RGBPixel* m_RGB_Nametables;
+	bool	  m_IsDebugBuffersEnabled;
+
+	void release_debug_buffers();
+
+	//Pixels (0-3) of sprite output units, left to right with flip applied
+	// filled from tile cache when sprites are fetched (see NESROMImage::DecodedTileSize)
+	uint8_t	 m_SpriteRows[8][8];
+
+	//Sprites in range of every visible line, bit n is OAM sprite n : evaluation takes the lowest 8 bits,
+	// any bit above them is overflow. Y writes move sprite between lines (move_sprite),
+	// whole table is rebuilt only after sprite size change or state load
+	uint64_t m_SpriteLists[240];
+	bool	 m_IsSpriteListsDirty;
+	uint8_t	 m_SpriteListsHeight;
+	void build_sprite_lists();
+	void move_sprite(uint32_t sprite, uint8_t old_top, uint8_t new_top);
+	//Rebuilds m_SpriteRows from pattern bytes of units (after they were loaded from outside)
+	void update_sprite_rows();
+	static void expand_pattern(uint8_t lo_plane, uint8_t hi_plane, bool is_flipped, uint8_t* pixels);
+
+	//Rendering steps, shared by dot renderer (Update) and scanline renderer (render_line)
+	void load_background_shifters();
+	void fetch_nametable();
+	void fetch_attribute();
+	void fetch_pattern_lo();
+	void fetch_pattern_hi();
+	void increment_scroll_x();
+	void increment_scroll_y();
+	void evaluate_sprites();
+	void fetch_sprites();
+	//Background and sprites composition of single pixel at current scanline
+	void render_pixel(uint8_t x);
+	//Dots 1-256 of visible line at once, exactly the same state as 256 Update calls
+	// sprites of the line are merged up front, background pixels are copied from tile cache tile by tile,
+	// both layers are composed by the fastest kernel host supports
+	void render_line();
+	NESCompositor::Kernel m_CompositorKernel;
 
 	//Predefined palette for color conversion
 	RGBPixel m_RGB_Palette[64] = {
@@ -0,0 +1,243 @@
+#include "NESROMImage.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+//Images currently alive, keyed by canonical path
+struct NESROMImageRegistry
+{
+	std::mutex Mutex;
+	std::map<std::string, std::weak_ptr<const NESROMImage>> Images;
+};
+
+static NESROMImageRegistry& GetRegistry()
+{
+	static NESROMImageRegistry registry;
+	return registry;
+}
+
+NESROMImage::NESROMImage() :
+	m_FileSize(0),
+	m_FileTime(0),
+	m_Data(nullptr),
+	m_MappedSize(0),
+	m_PRGOffset(0),
+	m_PRGSize(0),
+	m_CHROffset(0),
+	m_CHRSize(0)
+{
+}
+
+NESROMImage::~NESROMImage()
+{
+	unmap_file();
+}
+
+std::shared_ptr<const NESROMImage> NESROMImage::Load(const std::string& file_name)
+{
+	std::error_code error;
+	std::filesystem::path path = std::filesystem::weakly_canonical(file_name, error);
+	if (error) path = file_name;
+
+	const uint64_t file_size = std::filesystem::file_size(path, error);
+	if (error || file_size < 16) return nullptr;
+	const int64_t file_time = (int64_t)std::filesystem::last_write_time(path, error).time_since_epoch().count();
+
+	NESROMImageRegistry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.Mutex);
+
+	const std::string key = path.string();
+	auto entry = registry.Images.find(key);
+	if (entry != registry.Images.end())
+	{
+		std::shared_ptr<const NESROMImage> image = entry->second.lock();
+		if (image != nullptr && image->m_FileSize == file_size && image->m_FileTime == file_time)
+			return image;
+	}
+
+	std::shared_ptr<NESROMImage> image(new NESROMImage());
+	image->m_FileName = file_name;
+	image->m_FileSize = file_size;
+	image->m_FileTime = file_time;
+
+	if (!image->map_file(key, (size_t)file_size))
+	{
+		std::ifstream ifs(key, std::ifstream::binary);
+		if (!ifs.is_open()) return nullptr;
+		image->m_Buffer.resize((size_t)file_size);
+		ifs.read((char*)image->m_Buffer.data(), image->m_Buffer.size());
+		image->m_Data = image->m_Buffer.data();
+	}
+
+	//Layout : header, optional trainer, PRG ROM, CHR ROM
+	const uint8_t* header = image->m_Data;
+	image->m_PRGOffset = 16 + ((header[6] & 0x04) ? 512 : 0);
+	image->m_PRGSize = header[4] * 0x4000;
+	image->m_CHROffset = image->m_PRGOffset + image->m_PRGSize;
+	image->m_CHRSize = header[5] * 0x2000;
+
+	//Truncated file, missing data reads as zero
+	const size_t required_size = (size_t)image->m_CHROffset + image->m_CHRSize;
+	if (file_size < required_size)
+	{
+		std::vector<uint8_t> buffer(required_size, 0);
+		memcpy(buffer.data(), image->m_Data, (size_t)file_size);
+		image->unmap_file();
+		image->m_Buffer = std::move(buffer);
+		image->m_Data = image->m_Buffer.data();
+	}
+
+	image->decode_tiles();
+
+	//Forget images nobody holds anymore
+	for (auto it = registry.Images.begin(); it != registry.Images.end();)
+	{
+		if (it->second.expired()) it = registry.Images.erase(it);
+		else ++it;
+	}
+	registry.Images[key] = image;
+
+	return image;
+}
+
+std::shared_ptr<const NESROMImage> NESROMImage::CreateBlank(uint32_t prg_size, uint32_t chr_size)
+{
+	std::shared_ptr<NESROMImage> image(new NESROMImage());
+	image->m_FileName = "dummy";
+	image->m_Buffer.assign(16 + (size_t)prg_size + chr_size, 0);
+	image->m_Buffer[4] = (uint8_t)(prg_size / 0x4000);
+	image->m_Buffer[5] = (uint8_t)(chr_size / 0x2000);
+	image->m_Data = image->m_Buffer.data();
+	image->m_PRGOffset = 16;
+	image->m_PRGSize = prg_size;
+	image->m_CHROffset = 16 + prg_size;
+	image->m_CHRSize = chr_size;
+	return image;
+}
+
+const std::string& NESROMImage::GetFileName() const
+{
+	return m_FileName;
+}
+
+bool NESROMImage::IsMapped() const
+{
+	return m_MappedSize != 0;
+}
+
+const uint8_t* NESROMImage::GetHeader() const
+{
+	return m_Data;
+}
+
+const uint8_t* NESROMImage::GetPRG() const
+{
+	return m_PRGSize ? m_Data + m_PRGOffset : nullptr;
+}
+
+uint32_t NESROMImage::GetPRGSize() const
+{
+	return m_PRGSize;
+}
+
+const uint8_t* NESROMImage::GetCHR() const
+{
+	return m_CHRSize ? m_Data + m_CHROffset : nullptr;
+}
+
+uint32_t NESROMImage::GetCHRSize() const
+{
+	return m_CHRSize;
+}
+
+const uint8_t* NESROMImage::GetCHRTiles() const
+{
+	return m_CHRTiles.empty() ? nullptr : m_CHRTiles.data();
+}
+
+void NESROMImage::DecodeTileRow(const uint8_t* chr, uint32_t address, uint8_t* tiles)
+{
+	const uint32_t row = address & 0x07;
+	const uint8_t lo_plane = chr[(address & ~0x0F) + row];
+	const uint8_t hi_plane = chr[(address & ~0x0F) + row + 8];
+
+	uint8_t* decoded = &tiles[(address >> 4) * DecodedTileSize + row * 8];
+	for (uint32_t column = 0; column < 8; column++)
+	{
+		const uint8_t pixel = (((hi_plane >> (7 - column)) & 0x01) << 1) | ((lo_plane >> (7 - column)) & 0x01);
+		decoded[column] = pixel;
+		decoded[64 + 7 - column] = pixel;
+	}
+}
+
+void NESROMImage::decode_tiles()
+{
+	//Image is immutable, so tiles are decoded once for every instance sharing it
+	if (m_CHRSize == 0) return;
+	m_CHRTiles.resize((m_CHRSize / 16) * DecodedTileSize);
+	for (uint32_t address = 0; address < m_CHRSize; address += 16)
+	{
+		for (uint32_t row = 0; row < 8; row++)
+			DecodeTileRow(GetCHR(), address + row, m_CHRTiles.data());
+	}
+}
+
+size_t NESROMImage::GetMemoryFootprint() const
+{
+	return (IsMapped() ? m_MappedSize : m_Buffer.capacity()) + m_CHRTiles.capacity();
+}
+
+uint32_t NESROMImage::GetSharedCount()
+{
+	NESROMImageRegistry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.Mutex);
+	return (uint32_t)std::count_if(registry.Images.begin(), registry.Images.end(), [](const auto& entry) { return !entry.second.expired(); });
+}
+
+bool NESROMImage::map_file(const std::string& file_name, size_t size)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return false;
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (mapping == nullptr) return false;
+	void* memory = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size);
+	CloseHandle(mapping);
+	if (memory == nullptr) return false;
+#else
+	int file = open(file_name.c_str(), O_RDONLY);
+	if (file < 0) return false;
+	void* memory = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (memory == MAP_FAILED) return false;
+#endif
+	m_Data = (const uint8_t*)memory;
+	m_MappedSize = size;
+	return true;
+}
+
+void NESROMImage::unmap_file()
+{
+	if (m_MappedSize == 0) return;
+#ifdef _WIN32
+	UnmapViewOfFile(m_Data);
+#else
+	munmap((void*)m_Data, m_MappedSize);
+#endif
+	m_Data = nullptr;
+	m_MappedSize = 0;
+}
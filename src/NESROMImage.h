@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+//Immutable iNES file image, loaded once and shared (reference counted) by every cartrige
+// which loads the same file, so many instances of one game keep single copy of PRG/CHR ROM.
+// File is memory-mapped where possible and read into memory otherwise (or if it is truncated).
+// Writable memory (PRG RAM, CHR RAM) is never part of image and stays with cartrige.
+class NESROMImage
+{
+public:
+	~NESROMImage();
+
+	//Image of file, reused while anybody holds it (and file didn't change), nullptr if file can't be read
+	static std::shared_ptr<const NESROMImage> Load(const std::string& file_name);
+	//Zero-filled image (not shared), used by dummy cartrige
+	static std::shared_ptr<const NESROMImage> CreateBlank(uint32_t prg_size, uint32_t chr_size);
+
+	const std::string& GetFileName() const;
+	bool IsMapped() const;
+
+	//iNES header (16 bytes)
+	const uint8_t* GetHeader() const;
+	const uint8_t* GetPRG() const;
+	uint32_t	   GetPRGSize() const;
+	//nullptr if ROM uses CHR RAM
+	const uint8_t* GetCHR() const;
+	uint32_t	   GetCHRSize() const;
+	//CHR ROM decoded into tiles (see DecodeTileRow), tile of CHR address is at (address >> 4) * DecodedTileSize
+	// nullptr if ROM uses CHR RAM
+	const uint8_t* GetCHRTiles() const;
+
+	//Decoded tile : 8 rows of 8 pixel indices (0-3, leftmost pixel first), followed by
+	// the same 8 rows horizontally flipped, so renderers never pick bits out of planes
+	static const uint32_t DecodedTileSize = 128;
+	//Decodes row containing CHR byte at 'address' (of either plane) into 'tiles' (whole CHR decoded)
+	static void DecodeTileRow(const uint8_t* chr, uint32_t address, uint8_t* tiles);
+
+	//Memory held by image (file data and decoded tiles), bytes
+	size_t GetMemoryFootprint() const;
+
+	//Images alive at the moment (statistics)
+	static uint32_t GetSharedCount();
+
+protected:
+	NESROMImage();
+
+	std::string m_FileName;
+	uint64_t m_FileSize;
+	int64_t  m_FileTime;
+
+	//Mapped file or copy in memory
+	const uint8_t* m_Data;
+	size_t m_MappedSize;
+	std::vector<uint8_t> m_Buffer;
+
+	uint32_t m_PRGOffset;
+	uint32_t m_PRGSize;
+	uint32_t m_CHROffset;
+	uint32_t m_CHRSize;
+	std::vector<uint8_t> m_CHRTiles;
+
+	void decode_tiles();
+
+	bool map_file(const std::string& file_name, size_t size);
+	void unmap_file();
+};
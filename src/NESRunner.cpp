@@ -0,0 +1,202 @@
+#include "NESRunner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "NESDevice.h"
+
+using chrono_clock = std::chrono::steady_clock;
+
+struct NESRunner::WorkQueue
+{
+	std::mutex Mutex;
+	std::deque<uint32_t> Jobs;
+};
+
+NESRunner::NESRunner(uint32_t threads) :
+	JobsStolen(0)
+{
+	if (threads == 0)
+		threads = std::thread::hardware_concurrency();
+	m_ThreadCount = (threads == 0) ? 1 : threads;
+}
+
+uint32_t NESRunner::GetThreadCount()
+{
+	return m_ThreadCount;
+}
+
+std::vector<NESJobResult> NESRunner::Run(const std::vector<NESJob>& jobs)
+{
+	std::vector<NESJobResult> results(jobs.size());
+	JobsStolen = 0;
+	if (jobs.empty()) return results;
+
+	const uint32_t workers = std::min<uint32_t>(m_ThreadCount, (uint32_t)jobs.size());
+	std::vector<WorkQueue> queues(workers);
+	for (uint32_t job = 0; job < jobs.size(); job++)
+		queues[job % workers].Jobs.push_back(job);
+
+	std::atomic<uint64_t> stolen(0);
+	auto worker_fn = [&](uint32_t worker)
+	{
+		while (true)
+		{
+			uint32_t job = 0;
+			bool is_found = false;
+			{
+				std::lock_guard<std::mutex> lock(queues[worker].Mutex);
+				if (!queues[worker].Jobs.empty())
+				{
+					job = queues[worker].Jobs.back();
+					queues[worker].Jobs.pop_back();
+					is_found = true;
+				}
+			}
+			for (uint32_t offset = 1; offset < workers && !is_found; offset++)
+			{
+				WorkQueue& victim = queues[(worker + offset) % workers];
+				std::lock_guard<std::mutex> lock(victim.Mutex);
+				if (!victim.Jobs.empty())
+				{
+					job = victim.Jobs.front();
+					victim.Jobs.pop_front();
+					is_found = true;
+					stolen++;
+				}
+			}
+			//Nothing is queued after start, so empty queues mean we are done
+			if (!is_found) return;
+
+			run_job(jobs[job], results[job]);
+			results[job].Worker = worker;
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (uint32_t worker = 1; worker < workers; worker++)
+		threads.emplace_back(worker_fn, worker);
+	worker_fn(0);
+	for (std::thread& thread : threads)
+		thread.join();
+
+	JobsStolen = stolen;
+	return results;
+}
+
+uint64_t NESRunner::Hash(const uint8_t* data, size_t size)
+{
+	uint64_t hash = 0xCBF29CE484222325;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= data[i];
+		hash *= 0x00000100000001B3;
+	}
+	return hash;
+}
+
+void NESRunner::run_job(const NESJob& job, NESJobResult& result)
+{
+	std::vector<std::pair<uint32_t, uint8_t>> script;
+	if (!job.InputScript.empty() && !load_script(job.InputScript, script))
+	{
+		printf("Unable to load input script \"%s\"\n", job.InputScript.c_str());
+		return;
+	}
+
+	std::unique_ptr<NESDevice> device = std::make_unique<NESDevice>();
+	device->GetCartrige().Verbose = false;
+	device->SetLeanMode(true);
+	if (!device->GetCartrige().LoadCartrige(job.ROMFile))
+		return;
+	result.Loaded = true;
+
+	device->Reset();
+	device->ExecutionMode = NESDevice::ExecutionMode::PerInstruction;
+	device->IdleLoopSkipping = job.IdleLoopSkipping;
+	device->JITEnabled = job.JITEnabled;
+	device->DeviceMode = NESDevice::DeviceMode::Running;
+
+	//CPU cycle counter is 32 bit, accumulate deltas to survive wrapping
+	uint32_t last_cpu_cycle = device->GetCPU().State.CyclesTotal;
+	size_t script_position = 0;
+
+	chrono_clock::time_point start_timestamp = chrono_clock::now();
+	for (uint32_t frame = 0; frame < job.Frames; frame++)
+	{
+		apply_input(*device, job, script, script_position, frame);
+		device->Update();
+
+		result.CPUCycles += (uint32_t)(device->GetCPU().State.CyclesTotal - last_cpu_cycle);
+		last_cpu_cycle = device->GetCPU().State.CyclesTotal;
+
+		//Device falls back to pause only if cpu is halted
+		if (device->DeviceMode != NESDevice::DeviceMode::Running)
+		{
+			result.Halted = true;
+			break;
+		}
+		result.FramesDone++;
+	}
+	result.Seconds = std::chrono::duration<double>(chrono_clock::now() - start_timestamp).count();
+
+	result.FramebufferHash = Hash(device->GetPPU().GetIndexFramebuffer(), 256 * 240);
+	result.RAM.assign(device->GetRAM(), device->GetRAM() + 0x0800);
+	result.MemoryFootprint = device->GetMemoryFootprint();
+}
+
+bool NESRunner::load_script(const std::string& file_name, std::vector<std::pair<uint32_t, uint8_t>>& script)
+{
+	std::ifstream ifs(file_name);
+	if (!ifs.is_open()) return false;
+
+	std::string line;
+	while (std::getline(ifs, line))
+	{
+		uint32_t frame = 0;
+		uint32_t buttons = 0;
+		if (line.empty() || line[0] == '#') continue;
+		if (sscanf(line.c_str(), "%u %x", &frame, &buttons) != 2) return false;
+		script.emplace_back(frame, (uint8_t)buttons);
+	}
+	return true;
+}
+
+void NESRunner::apply_input(NESDevice& device, const NESJob& job, const std::vector<std::pair<uint32_t, uint8_t>>& script, size_t& script_position, uint32_t frame)
+{
+	uint8_t buttons = 0;
+	if (!script.empty())
+	{
+		while (script_position < script.size() && script[script_position].first <= frame)
+			script_position++;
+		if (script_position == 0) return;
+		buttons = script[script_position - 1].second;
+	}
+	else if (job.Seed != 0)
+	{
+		uint32_t seed = job.Seed * 0x9E3779B9 ^ (frame / 8) * 0x85EBCA6B;
+		seed ^= seed >> 15;
+		seed *= 0x2C1B3C6D;
+		seed ^= seed >> 12;
+		buttons = (uint8_t)seed;
+	}
+	else
+	{
+		return;
+	}
+
+	NESController& controller = device.GetController();
+	controller.ResetButtons(0);
+	for (uint32_t bit = 0; bit < 8; bit++)
+	{
+		if (buttons & (1 << bit))
+			controller.PushButton(0, (NESController::NESButtons)(1 << bit));
+	}
+}
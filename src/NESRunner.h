@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class NESDevice;
+
+//Single emulation run : ROM, frame budget and input
+struct NESJob
+{
+	std::string ROMFile;
+	uint32_t Frames = 600;
+	//Random buttons on controller 1 (new state every 8 frames), 0 - no random input
+	uint32_t Seed = 0;
+	//Input script, every line is "<frame> <buttons>" (buttons as NESButtons mask, hex),
+	// state is held until next line. Takes precedence over Seed
+	std::string InputScript;
+	//Emulation settings
+	bool IdleLoopSkipping = true;
+	bool JITEnabled = false;
+};
+
+struct NESJobResult
+{
+	bool	 Loaded = false;
+	bool	 Halted = false;		//CPU halted before frame budget was used up
+	uint32_t FramesDone = 0;
+	uint64_t CPUCycles = 0;
+	uint64_t FramebufferHash = 0;
+	std::vector<uint8_t> RAM;		//2KB internal RAM at the end of run
+	double	 Seconds = 0.0;
+	uint64_t MemoryFootprint = 0;	//Bytes owned by device (shared ROM image excluded)
+	uint32_t Worker = 0;			//Thread which ran the job
+};
+
+//Runs jobs on pool of worker threads, every job gets its own device
+// jobs are dealt round-robin into per-worker queues, worker takes from the back of its own queue
+// and steals from the front of others when it runs out (runs take very different time)
+class NESRunner
+{
+public:
+	//0 - one worker per hardware thread
+	NESRunner(uint32_t threads = 0);
+
+	uint32_t GetThreadCount();
+	//Blocks until every job is done, results are in the same order as jobs
+	std::vector<NESJobResult> Run(const std::vector<NESJob>& jobs);
+
+	//Statistics of last Run
+	uint64_t JobsStolen;
+
+	//FNV-1a
+	static uint64_t Hash(const uint8_t* data, size_t size);
+
+protected:
+	struct WorkQueue;
+
+	uint32_t m_ThreadCount;
+
+	static void run_job(const NESJob& job, NESJobResult& result);
+	static bool load_script(const std::string& file_name, std::vector<std::pair<uint32_t, uint8_t>>& script);
+	static void apply_input(NESDevice& device, const NESJob& job, const std::vector<std::pair<uint32_t, uint8_t>>& script, size_t& script_position, uint32_t frame);
+};
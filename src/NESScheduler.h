@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+
+//Event queue for the device, timestamps are in master cycles (64 bit, never wraps)
+// every event type has single slot - scheduling event again replaces previous timestamp
+class NESScheduler
+{
+public:
+
+	enum class Event : uint32_t
+	{
+		VBlank,		//PPU reaches scanline 241 (NMI)
+		FrameEnd,	//PPU completes frame
+		MapperIRQ,	//Cartrige mapper asserts IRQ
+
+		Count
+	};
+
+	static const uint64_t Never = UINT64_MAX;
+
+	NESScheduler()
+	{
+		this->Reset();
+	}
+
+	void Reset()
+	{
+		for (uint32_t i = 0; i < (uint32_t)Event::Count; i++)
+			m_Timestamps[i] = Never;
+		m_NextTimestamp = Never;
+	}
+
+	void Schedule(Event event, uint64_t timestamp)
+	{
+		m_Timestamps[(uint32_t)event] = timestamp;
+		update_next();
+	}
+
+	void Cancel(Event event)
+	{
+		m_Timestamps[(uint32_t)event] = Never;
+		update_next();
+	}
+
+	uint64_t GetTimestamp(Event event)
+	{
+		return m_Timestamps[(uint32_t)event];
+	}
+
+	//Timestamp of the earliest scheduled event
+	uint64_t NextTimestamp()
+	{
+		return m_NextTimestamp;
+	}
+
+	//Removes earliest event with timestamp <= 'timestamp', returns false if there is none
+	bool PopEvent(uint64_t timestamp, Event* out_event)
+	{
+		if (m_NextTimestamp > timestamp) return false;
+
+		for (uint32_t i = 0; i < (uint32_t)Event::Count; i++)
+		{
+			if (m_Timestamps[i] == m_NextTimestamp)
+			{
+				*out_event = (Event)i;
+				m_Timestamps[i] = Never;
+				update_next();
+				return true;
+			}
+		}
+		return false;
+	}
+
+private:
+	uint64_t m_Timestamps[(uint32_t)Event::Count];
+	uint64_t m_NextTimestamp;
+
+	void update_next()
+	{
+		m_NextTimestamp = Never;
+		for (uint32_t i = 0; i < (uint32_t)Event::Count; i++)
+			if (m_Timestamps[i] < m_NextTimestamp)
+				m_NextTimestamp = m_Timestamps[i];
+	}
+};
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+//Ahead-of-time recompiled PRG ROM (NROM titles only, see src/recompiler)
+// generated source holds one C++ function per reachable block, it registers its code table
+// at startup and device picks it up on Reset if PRG ROM hash matches.
+// Function may be entered at any instruction of block, it leaves (returns) before instruction
+// which would access anything but plain memory (I/O, mapper registers), so the interpreter
+// executes it with proper device sync. Code never reached by disassembly (jump tables,
+// code in RAM) is interpreted as well.
+
+//CPU state shared with generated functions
+struct NESStaticContext
+{
+	uint8_t* const* ReadPages;	//Device memory map (1KB pages), nullptr page exits to interpreter
+	uint8_t* const* WritePages;
+	uint8_t* RAM;				//2KB internal RAM (zeropage and stack)
+
+	uint32_t Executed;			//Instructions completed
+	uint32_t Cycles;			//Cycles taken by completed instructions
+	uint32_t LastCycles;		//Cycles taken by last completed instruction
+	uint16_t PC;				//Set by instruction which left block (jump, branch, end of block)
+	uint8_t  AC, XR, YR, SR, SP;
+
+	//Plain memory access, false if address isn't plain memory
+	inline bool Read(uint16_t address, uint8_t& value)
+	{
+		const uint8_t* page = ReadPages[address >> 10];
+		if (page == nullptr) return false;
+		value = page[address & 0x03FF];
+		return true;
+	}
+	inline uint8_t* WritePtr(uint16_t address)
+	{
+		uint8_t* page = WritePages[address >> 10];
+		return (page != nullptr && ReadPages[address >> 10] != nullptr) ? page + (address & 0x03FF) : nullptr;
+	}
+	inline uint16_t ZeroPagePtr(uint8_t address)
+	{
+		return (uint16_t)RAM[address] | ((uint16_t)RAM[(uint8_t)(address + 1)] << 8);
+	}
+
+	inline void Push(uint8_t value)
+	{
+		RAM[0x0100 | SP--] = value;
+	}
+	inline uint8_t Pull()
+	{
+		return RAM[0x0100 | ++SP];
+	}
+
+	inline void SetNZ(uint8_t value)
+	{
+		SR = (SR & 0x7D) | (value & 0x80) | (value == 0 ? 0x02 : 0x00);
+	}
+	inline void SetFlag(uint8_t flag, bool value)
+	{
+		SR = value ? (SR | flag) : (SR & ~flag);
+	}
+	inline void Compare(uint8_t reg, uint8_t value)
+	{
+		SetFlag(0x01, reg >= value);
+		SetNZ(reg - value);
+	}
+	//SBC is ADC with inverted operand (no decimal mode on 2A03)
+	inline void AddWithCarry(uint8_t value)
+	{
+		const uint16_t result = (uint16_t)AC + value + (SR & 0x01);
+		SetFlag(0x40, (~(AC ^ value) & (AC ^ result) & 0x80) != 0);
+		SetFlag(0x01, result > 0xFF);
+		AC = (uint8_t)result;
+		SetNZ(AC);
+	}
+
+	inline void Complete(uint32_t cycles)
+	{
+		Executed++;
+		Cycles += cycles;
+		LastCycles = cycles;
+	}
+};
+
+typedef void (*NESStaticBlockFn)(NESStaticContext& context, uint32_t entry);
+
+struct NESStaticBlock
+{
+	uint16_t Address;
+	uint16_t Count;				//Instructions in block
+	NESStaticBlockFn Fn;
+	const uint16_t* PC;			//Address of each instruction
+	const uint8_t*  OpCode;		//Opcode of each instruction
+	const uint16_t* MaxCycles;	//Worst case cycles from each instruction to end of block
+};
+
+struct NESStaticCode
+{
+	const char* ROMName;
+	uint32_t PRGSize;
+	uint64_t PRGHash;
+	uint32_t BlockCount;
+	const NESStaticBlock* Blocks;
+
+	//FNV-1a
+	static inline uint64_t Hash(const uint8_t* data, size_t size)
+	{
+		uint64_t hash = 0xCBF29CE484222325;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= data[i];
+			hash *= 0x00000100000001B3;
+		}
+		return hash;
+	}
+
+	static inline std::vector<const NESStaticCode*>& Registry()
+	{
+		static std::vector<const NESStaticCode*> registry;
+		return registry;
+	}
+	//Called by generated source during static initialization
+	static inline bool Register(const NESStaticCode* code)
+	{
+		Registry().push_back(code);
+		return true;
+	}
+	//Code recompiled from exactly this PRG ROM, nullptr if there is none
+	static inline const NESStaticCode* Find(const uint8_t* prg, uint32_t size)
+	{
+		if (prg == nullptr || Registry().empty()) return nullptr;
+		const uint64_t hash = Hash(prg, size);
+		for (const NESStaticCode* code : Registry())
+		{
+			if (code->PRGSize == size && code->PRGHash == hash)
+				return code;
+		}
+		return nullptr;
+	}
+};
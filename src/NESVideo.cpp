@@ -0,0 +1,253 @@
+#include "NESVideo.h"
+
+#ifdef NES_VIDEO_AVX2
+#include <immintrin.h>
+#define NES_VIDEO_AVX2_FN __attribute__((target("avx2")))
+#endif
+
+size_t NESVideo::GetFrameSize(Format format, uint32_t lines)
+{
+	switch (format)
+	{
+	case Format::RGB24:	 return (size_t)256 * lines * 3;
+	case Format::RGBA32: return (size_t)256 * lines * 4;
+	case Format::RGB565: return (size_t)256 * lines * 2;
+	case Format::YUV420: return (size_t)256 * lines + 2 * (size_t)128 * (lines / 2);
+	default:			 return 0;
+	}
+}
+
+const char* NESVideo::GetFormatName(Format format)
+{
+	switch (format)
+	{
+	case Format::RGB24:	 return "rgb24";
+	case Format::RGBA32: return "rgba32";
+	case Format::RGB565: return "rgb565";
+	case Format::YUV420: return "yuv420";
+	default:			 return "unknown";
+	}
+}
+
+bool NESVideo::IsAVX2Supported()
+{
+#ifdef NES_VIDEO_AVX2
+	static const bool is_supported = __builtin_cpu_supports("avx2") != 0;
+	return is_supported;
+#else
+	return false;
+#endif
+}
+
+void NESVideo::Convert(Format format, const uint8_t* indices, const uint8_t* emphasis, const uint8_t* palette,
+	uint32_t lines, uint8_t* output)
+{
+	//Table is rebuilt on every call, palette may change any time and it is tiny next to the frame
+	uint32_t table[8 * 64];
+	build_rgba_table(palette, table);
+
+#ifdef NES_VIDEO_AVX2
+	if (IsAVX2Supported())
+	{
+		switch (format)
+		{
+		case Format::RGB24:	 convert_rgb24_avx2(indices, emphasis, table, lines, output); return;
+		case Format::RGBA32: convert_rgba32_avx2(indices, emphasis, table, lines, output); return;
+		case Format::RGB565: convert_rgb565_avx2(indices, emphasis, table, lines, output); return;
+		default:			 break;
+		}
+	}
+#endif
+
+	switch (format)
+	{
+	case Format::RGB24:	 convert_rgb24(indices, emphasis, table, lines, output); break;
+	case Format::RGBA32: convert_rgba32(indices, emphasis, table, lines, output); break;
+	case Format::RGB565: convert_rgb565(indices, emphasis, table, lines, output); break;
+	case Format::YUV420: convert_yuv420(indices, emphasis, table, lines, output); break;
+	default:			 break;
+	}
+}
+
+void NESVideo::build_rgba_table(const uint8_t* palette, uint32_t* table)
+{
+	//Emphasized channel keeps its level, the other two are dimmed (about 0.816, NTSC)
+	for (uint32_t bits = 0; bits < 8; bits++)
+	{
+		for (uint32_t color = 0; color < 64; color++)
+		{
+			uint32_t rgb[3] = { palette[color * 3 + 0], palette[color * 3 + 1], palette[color * 3 + 2] };
+			for (uint32_t channel = 0; channel < 3; channel++)
+			{
+				for (uint32_t emphasized = 0; emphasized < 3; emphasized++)
+				{
+					if ((bits & (1 << emphasized)) && emphasized != channel)
+						rgb[channel] = rgb[channel] * 209 / 256;
+				}
+			}
+			table[bits * 64 + color] = rgb[0] | (rgb[1] << 8) | (rgb[2] << 16) | 0xFF000000;
+		}
+	}
+}
+
+void NESVideo::convert_rgb24(const uint8_t* indices, const uint8_t* emphasis, const uint32_t* table, uint32_t lines, uint8_t* output)
+{
+	for (uint32_t line = 0; line < lines; line++)
+	{
+		const uint32_t* colors = &table[(emphasis[line] & 0x07) * 64];
+		for (uint32_t x = 0; x < 256; x++)
+		{
+			const uint32_t color = colors[indices[line * 256 + x] & 0x3F];
+			output[0] = (uint8_t)color;
+			output[1] = (uint8_t)(color >> 8);
+			output[2] = (uint8_t)(color >> 16);
+			output += 3;
+		}
+	}
+}
+
+void NESVideo::convert_rgba32(const uint8_t* indices, const uint8_t* emphasis, const uint32_t* table, uint32_t lines, uint8_t* output)
+{
+	for (uint32_t line = 0; line < lines; line++)
+	{
+		const uint32_t* colors = &table[(emphasis[line] & 0x07) * 64];
+		for (uint32_t x = 0; x < 256; x++)
+		{
+			const uint32_t color = colors[indices[line * 256 + x] & 0x3F];
+			output[0] = (uint8_t)color;
+			output[1] = (uint8_t)(color >> 8);
+			output[2] = (uint8_t)(color >> 16);
+			output[3] = (uint8_t)(color >> 24);
+			output += 4;
+		}
+	}
+}
+
+static uint32_t ToRGB565(uint32_t color)
+{
+	return ((color & 0xF8) << 8) | ((color >> 5) & 0x07E0) | ((color >> 19) & 0x1F);
+}
+
+void NESVideo::convert_rgb565(const uint8_t* indices, const uint8_t* emphasis, const uint32_t* table, uint32_t lines, uint8_t* output)
+{
+	uint16_t* pixels = (uint16_t*)output;
+	for (uint32_t line = 0; line < lines; line++)
+	{
+		const uint32_t* colors = &table[(emphasis[line] & 0x07) * 64];
+		for (uint32_t x = 0; x < 256; x++)
+			*pixels++ = (uint16_t)ToRGB565(colors[indices[line * 256 + x] & 0x3F]);
+	}
+}
+
+void NESVideo::convert_yuv420(const uint8_t* indices, const uint8_t* emphasis, const uint32_t* table, uint32_t lines, uint8_t* output)
+{
+	//Y, U, V of every table entry, chroma of 2x2 block is average of its pixels
+	uint8_t y_table[8 * 64];
+	int16_t u_table[8 * 64];
+	int16_t v_table[8 * 64];
+	for (uint32_t entry = 0; entry < 8 * 64; entry++)
+	{
+		const int32_t r = table[entry] & 0xFF;
+		const int32_t g = (table[entry] >> 8) & 0xFF;
+		const int32_t b = (table[entry] >> 16) & 0xFF;
+		y_table[entry] = (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+		u_table[entry] = (int16_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+		v_table[entry] = (int16_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+	}
+
+	uint8_t* y_plane = output;
+	uint8_t* u_plane = y_plane + 256 * lines;
+	uint8_t* v_plane = u_plane + 128 * (lines / 2);
+	for (uint32_t line = 0; line < lines; line++)
+	{
+		const uint32_t base = (emphasis[line] & 0x07) * 64;
+		for (uint32_t x = 0; x < 256; x++)
+			y_plane[line * 256 + x] = y_table[base + (indices[line * 256 + x] & 0x3F)];
+	}
+	for (uint32_t line = 0; line + 1 < lines; line += 2)
+	{
+		const uint32_t top = (emphasis[line] & 0x07) * 64;
+		const uint32_t bottom = (emphasis[line + 1] & 0x07) * 64;
+		for (uint32_t x = 0; x < 256; x += 2)
+		{
+			const uint32_t entries[4] = {
+				top + (indices[line * 256 + x] & 0x3F), top + (indices[line * 256 + x + 1] & 0x3F),
+				bottom + (indices[(line + 1) * 256 + x] & 0x3F), bottom + (indices[(line + 1) * 256 + x + 1] & 0x3F)
+			};
+			int32_t u = 0, v = 0;
+			for (uint32_t entry : entries)
+			{
+				u += u_table[entry];
+				v += v_table[entry];
+			}
+			u_plane[(line / 2) * 128 + x / 2] = (uint8_t)((u + 2) >> 2);
+			v_plane[(line / 2) * 128 + x / 2] = (uint8_t)((v + 2) >> 2);
+		}
+	}
+}
+
+#ifdef NES_VIDEO_AVX2
+//8 colors of line 'colors' for indices at 'source'
+NES_VIDEO_AVX2_FN static inline __m256i GatherColors(const uint32_t* colors, const uint8_t* source)
+{
+	const __m256i index = _mm256_and_si256(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)source)), _mm256_set1_epi32(0x3F));
+	return _mm256_i32gather_epi32((const int*)colors, index, 4);
+}
+
+NES_VIDEO_AVX2_FN void NESVideo::convert_rgba32_avx2(const uint8_t* indices, const uint8_t* emphasis, const uint32_t* table, uint32_t lines, uint8_t* output)
+{
+	for (uint32_t line = 0; line < lines; line++)
+	{
+		const uint32_t* colors = &table[(emphasis[line] & 0x07) * 64];
+		for (uint32_t x = 0; x < 256; x += 8)
+			_mm256_storeu_si256((__m256i*)&output[(line * 256 + x) * 4], GatherColors(colors, &indices[line * 256 + x]));
+	}
+}
+
+NES_VIDEO_AVX2_FN void NESVideo::convert_rgb24_avx2(const uint8_t* indices, const uint8_t* emphasis, const uint32_t* table, uint32_t lines, uint8_t* output)
+{
+	//RGBA of 4 pixels in every 128 bit half packed into 12 bytes, halves are stored with overlap
+	// (4 garbage bytes are overwritten by next store), last 8 pixels of line can't overlap and go scalar
+	const __m256i pack = _mm256_setr_epi8(
+		0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+		0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+	for (uint32_t line = 0; line < lines; line++)
+	{
+		const uint32_t* colors = &table[(emphasis[line] & 0x07) * 64];
+		uint8_t* target = &output[line * 256 * 3];
+		for (uint32_t x = 0; x < 248; x += 8)
+		{
+			const __m256i rgb = _mm256_shuffle_epi8(GatherColors(colors, &indices[line * 256 + x]), pack);
+			_mm_storeu_si128((__m128i*)&target[x * 3], _mm256_castsi256_si128(rgb));
+			_mm_storeu_si128((__m128i*)&target[x * 3 + 12], _mm256_extracti128_si256(rgb, 1));
+		}
+		for (uint32_t x = 248; x < 256; x++)
+		{
+			const uint32_t color = colors[indices[line * 256 + x] & 0x3F];
+			target[x * 3 + 0] = (uint8_t)color;
+			target[x * 3 + 1] = (uint8_t)(color >> 8);
+			target[x * 3 + 2] = (uint8_t)(color >> 16);
+		}
+	}
+}
+
+NES_VIDEO_AVX2_FN void NESVideo::convert_rgb565_avx2(const uint8_t* indices, const uint8_t* emphasis, const uint32_t* table, uint32_t lines, uint8_t* output)
+{
+	uint32_t table565[8 * 64];
+	for (uint32_t entry = 0; entry < 8 * 64; entry++)
+		table565[entry] = ToRGB565(table[entry]);
+
+	for (uint32_t line = 0; line < lines; line++)
+	{
+		const uint32_t* colors = &table565[(emphasis[line] & 0x07) * 64];
+		for (uint32_t x = 0; x < 256; x += 16)
+		{
+			//Pack works within 128 bit halves, permute puts pixels back in order
+			const __m256i lo = GatherColors(colors, &indices[line * 256 + x]);
+			const __m256i hi = GatherColors(colors, &indices[line * 256 + x + 8]);
+			const __m256i pixels = _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xD8);
+			_mm256_storeu_si256((__m256i*)&output[(line * 256 + x) * 2], pixels);
+		}
+	}
+}
+#endif
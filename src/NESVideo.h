@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+//AVX2 conversion needs x86-64 host (and cpu support checked at runtime),
+// everywhere else frames are converted by scalar code
+#if (defined(__x86_64__) || defined(_M_X64)) && (defined(__GNUC__) || defined(__clang__))
+#define NES_VIDEO_AVX2
+#endif
+
+//Conversion of PPU output (NES color of every pixel, see NESPPU::GetIndexFramebuffer) into
+// pixel formats consumers need. PPU never touches RGB, frames are converted only when somebody looks at them.
+class NESVideo
+{
+public:
+	enum class Format : uint32_t
+	{
+		RGB24,		//R, G, B bytes
+		RGBA32,		//R, G, B, A (0xFF) bytes
+		RGB565,		//uint16_t per pixel, red in high bits
+		YUV420,		//I420 planes : Y (width x height), U and V (width / 2 x height / 2), BT.601 limited range
+	};
+
+	//Bytes of 256 x 'lines' frame in 'format'
+	static size_t GetFrameSize(Format format, uint32_t lines);
+	static const char* GetFormatName(Format format);
+
+	//Converts 256 x 'lines' frame ('lines' is even for YUV420)
+	// indices  - 6 bit NES color of every pixel
+	// emphasis - color emphasis bits (PPUMASK >> 5) of every line
+	// palette  - 64 RGB colors (3 bytes each)
+	static void Convert(Format format, const uint8_t* indices, const uint8_t* emphasis, const uint8_t* palette,
+		uint32_t lines, uint8_t* output);
+
+	static bool IsAVX2Supported();
+
+protected:
+	//Colors of every emphasis (8 x 64 entries) as R | G << 8 | B << 16 | A << 24
+	static void build_rgba_table(const uint8_t* palette, uint32_t* table);
+
+	static void convert_rgb24(const uint8_t* indices, const uint8_t* emphasis, const uint32_t* table, uint32_t lines, uint8_t* output);
+	static void convert_rgba32(const uint8_t* indices, const uint8_t* emphasis, const uint32_t* table, uint32_t lines, uint8_t* output);
+	static void convert_rgb565(const uint8_t* indices, const uint8_t* emphasis, const uint32_t* table, uint32_t lines, uint8_t* output);
+	static void convert_yuv420(const uint8_t* indices, const uint8_t* emphasis, const uint32_t* table, uint32_t lines, uint8_t* output);
+#ifdef NES_VIDEO_AVX2
+	static void convert_rgb24_avx2(const uint8_t* indices, const uint8_t* emphasis, const uint32_t* table, uint32_t lines, uint8_t* output);
+	static void convert_rgba32_avx2(const uint8_t* indices, const uint8_t* emphasis, const uint32_t* table, uint32_t lines, uint8_t* output);
+	static void convert_rgb565_avx2(const uint8_t* indices, const uint8_t* emphasis, const uint32_t* table, uint32_t lines, uint8_t* output);
+#endif
+};
@@ -0,0 +1,174 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "NESBatch.h"
+
+// Batch benchmark : runs the same ROM on N independent devices and on NESBatch with N lanes,
+// reports aggregate instances x frames per second of both and checks that every lane ended
+// up exactly where its independent twin did.
+
+using chrono_clock = std::chrono::steady_clock;
+
+static void PrintUsage(const char* exe)
+{
+	printf("Usage : %s <rom_file> [options]\n", exe);
+	printf("\t-n, --instances <count> : amount of emulated consoles (default 64)\n");
+	printf("\t-f, --frames <count>    : amount of frames to emulate (default 300)\n");
+	printf("\t    --random-input      : press random buttons on every instance (lanes diverge)\n");
+	printf("\t-h, --help              : show this message\n");
+}
+
+//FNV-1a, just to compare results between runs
+static uint64_t HashBytes(const uint8_t* data, size_t size)
+{
+	uint64_t hash = 0xCBF29CE484222325;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= data[i];
+		hash *= 0x00000100000001B3;
+	}
+	return hash;
+}
+
+//Same input sequence for instance in both runs
+static void SetInput(NESDevice& device, uint32_t instance, uint32_t frame)
+{
+	uint32_t seed = (instance + 1) * 0x9E3779B9 ^ (frame / 8) * 0x85EBCA6B;
+	seed ^= seed >> 15;
+	seed *= 0x2C1B3C6D;
+	seed ^= seed >> 12;
+
+	device.GetController().ResetButtons(0);
+	for (uint32_t bit = 0; bit < 8; bit++)
+	{
+		if (seed & (1 << bit))
+			device.GetController().PushButton(0, (NESController::NESButtons)(1 << bit));
+	}
+}
+
+static void PrepareDevice(NESDevice& device)
+{
+	device.Reset();
+	device.ExecutionMode = NESDevice::ExecutionMode::PerInstruction;
+	device.DeviceMode = NESDevice::DeviceMode::Running;
+}
+
+static uint64_t HashDevice(NESDevice& device)
+{
+	uint64_t hash = HashBytes(device.GetPPU().GetIndexFramebuffer(), 256 * 240);
+	hash ^= HashBytes(device.GetRAM(), 0x0800) * 31;
+	return hash;
+}
+
+int main(int argc, char** argv)
+{
+	std::string rom_file;
+	uint32_t instances = 64;
+	uint32_t frames = 300;
+	bool random_input = false;
+
+	for (int arg = 1; arg < argc; arg++)
+	{
+		if (!strcmp(argv[arg], "-h") || !strcmp(argv[arg], "--help"))
+		{
+			PrintUsage(argv[0]);
+			return 0;
+		}
+		else if ((!strcmp(argv[arg], "-n") || !strcmp(argv[arg], "--instances")) && (arg + 1) < argc)
+		{
+			instances = (uint32_t)strtoul(argv[++arg], nullptr, 10);
+		}
+		else if ((!strcmp(argv[arg], "-f") || !strcmp(argv[arg], "--frames")) && (arg + 1) < argc)
+		{
+			frames = (uint32_t)strtoul(argv[++arg], nullptr, 10);
+		}
+		else if (!strcmp(argv[arg], "--random-input"))
+		{
+			random_input = true;
+		}
+		else if (argv[arg][0] != '-' && rom_file.empty())
+		{
+			rom_file = argv[arg];
+		}
+		else
+		{
+			printf("Unknown argument \"%s\"\n", argv[arg]);
+			PrintUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (rom_file.empty() || instances == 0)
+	{
+		PrintUsage(argv[0]);
+		return 1;
+	}
+
+	//Independent devices
+	std::vector<std::unique_ptr<NESDevice>> devices;
+	for (uint32_t instance = 0; instance < instances; instance++)
+	{
+		devices.push_back(std::make_unique<NESDevice>());
+		if (!devices.back()->GetCartrige().LoadCartrige(rom_file))
+			return 2;
+		PrepareDevice(*devices.back());
+	}
+
+	chrono_clock::time_point start_timestamp = chrono_clock::now();
+	for (uint32_t frame = 0; frame < frames; frame++)
+	{
+		for (uint32_t instance = 0; instance < instances; instance++)
+		{
+			if (random_input)
+				SetInput(*devices[instance], instance, frame);
+			devices[instance]->Update();
+		}
+	}
+	double devices_seconds = std::chrono::duration<double>(chrono_clock::now() - start_timestamp).count();
+	if (devices_seconds <= 0.0) devices_seconds = 1e-9;
+
+	//Batch
+	NESBatch batch(instances);
+	if (!batch.LoadCartrige(rom_file))
+		return 2;
+	batch.Reset();
+	for (uint32_t instance = 0; instance < instances; instance++)
+		PrepareDevice(batch.GetLane(instance));
+
+	start_timestamp = chrono_clock::now();
+	for (uint32_t frame = 0; frame < frames; frame++)
+	{
+		if (random_input)
+		{
+			for (uint32_t instance = 0; instance < instances; instance++)
+				SetInput(batch.GetLane(instance), instance, frame);
+		}
+		batch.Update();
+	}
+	double batch_seconds = std::chrono::duration<double>(chrono_clock::now() - start_timestamp).count();
+	if (batch_seconds <= 0.0) batch_seconds = 1e-9;
+
+	uint32_t mismatches = 0;
+	for (uint32_t instance = 0; instance < instances; instance++)
+	{
+		if (HashDevice(*devices[instance]) != HashDevice(batch.GetLane(instance)))
+			mismatches++;
+	}
+
+	const double instance_frames = (double)instances * frames;
+	printf("Instances        : %d\n", instances);
+	printf("Frames           : %d\n", frames);
+	printf("AVX2             : %s\n", batch.IsAVX2Supported() ? "yes" : "no");
+	printf("Devices          : %.3f s, %.2f instance-frames/sec\n", devices_seconds, instance_frames / devices_seconds);
+	printf("Batch            : %.3f s, %.2f instance-frames/sec (%.2fx)\n", batch_seconds, instance_frames / batch_seconds, devices_seconds / batch_seconds);
+	printf("Lockstep blocks  : %llu\n", (unsigned long long)batch.LockstepBlocks);
+	printf("Lockstep instr.  : %llu\n", (unsigned long long)batch.LockstepInstructions);
+	printf("Mismatching lanes: %d\n", mismatches);
+
+	return mismatches == 0 ? 0 : 3;
+}
@@ -0,0 +1,172 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <vector>
+
+#include "NESCompositor.h"
+
+// Compositor benchmark : composes the same set of random scanlines with every kernel host supports,
+// reports lines per second of each and checks that all of them match scalar kernel exactly
+// (palette indices and sprite 0 hit position).
+
+using chrono_clock = std::chrono::steady_clock;
+
+static void PrintUsage(const char* exe)
+{
+	printf("Usage : %s [options]\n", exe);
+	printf("\t-l, --lines <count>      : amount of distinct random lines (default 240)\n");
+	printf("\t-r, --repeat <count>     : passes over all lines per kernel (default 20000)\n");
+	printf("\t-d, --density <percent>  : share of pixels covered by sprites (default 25)\n");
+	printf("\t-h, --help               : show this message\n");
+}
+
+//xorshift, the same lines on every run
+static uint32_t NextRandom(uint32_t& state)
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+struct ScanlineSet
+{
+	std::vector<uint8_t> Background;
+	std::vector<uint8_t> Sprites;
+	std::vector<uint8_t> Behind;
+	std::vector<uint8_t> Zero;
+};
+
+//Background is random tiles, sprites are 8 pixel runs (like real sprites) with random transparent pixels
+static void GenerateLines(ScanlineSet& set, uint32_t lines, uint32_t density)
+{
+	uint32_t state = 0x12345678;
+	set.Background.assign(lines * 256, 0);
+	set.Sprites.assign(lines * 256, 0);
+	set.Behind.assign(lines * 256, 0);
+	set.Zero.assign(lines * 256, 0);
+
+	for (uint32_t line = 0; line < lines; line++)
+	{
+		uint8_t* background = &set.Background[line * 256];
+		for (uint32_t x = 0; x < 256; x++)
+			background[x] = (uint8_t)(((x / 8 + line) & 0x03) << 2 | (NextRandom(state) & 0x03));
+
+		const uint32_t sprites = (density * 256 / 100 + 7) / 8;
+		for (uint32_t sprite = 0; sprite < sprites; sprite++)
+		{
+			const uint32_t sprite_x = NextRandom(state) & 0xFF;
+			const uint8_t palette = 0x10 | (uint8_t)((NextRandom(state) & 0x03) << 2);
+			const uint8_t behind = (NextRandom(state) & 0x03) == 0 ? 0xFF : 0x00;
+			const uint8_t zero = (sprite == 0 && (line & 0x01)) ? 0xFF : 0x00;
+			for (uint32_t offset = 0; offset < 8 && sprite_x + offset < 256; offset++)
+			{
+				const uint8_t color = NextRandom(state) & 0x03;
+				if (color == 0 || set.Sprites[line * 256 + sprite_x + offset] != 0) continue;
+				set.Sprites[line * 256 + sprite_x + offset] = palette | color;
+				set.Behind[line * 256 + sprite_x + offset] = behind;
+				set.Zero[line * 256 + sprite_x + offset] = zero;
+			}
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t lines = 240;
+	uint32_t repeat = 20000;
+	uint32_t density = 25;
+
+	for (int arg = 1; arg < argc; arg++)
+	{
+		if (!strcmp(argv[arg], "-h") || !strcmp(argv[arg], "--help"))
+		{
+			PrintUsage(argv[0]);
+			return 0;
+		}
+		else if ((!strcmp(argv[arg], "-l") || !strcmp(argv[arg], "--lines")) && (arg + 1) < argc)
+		{
+			lines = (uint32_t)strtoul(argv[++arg], nullptr, 10);
+		}
+		else if ((!strcmp(argv[arg], "-r") || !strcmp(argv[arg], "--repeat")) && (arg + 1) < argc)
+		{
+			repeat = (uint32_t)strtoul(argv[++arg], nullptr, 10);
+		}
+		else if ((!strcmp(argv[arg], "-d") || !strcmp(argv[arg], "--density")) && (arg + 1) < argc)
+		{
+			density = (uint32_t)strtoul(argv[++arg], nullptr, 10);
+		}
+		else
+		{
+			printf("Unknown argument \"%s\"\n", argv[arg]);
+			PrintUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (lines == 0 || repeat == 0 || density > 100)
+	{
+		PrintUsage(argv[0]);
+		return 1;
+	}
+
+	ScanlineSet set;
+	GenerateLines(set, lines, density);
+
+	//Reference output
+	std::vector<uint8_t> expected(lines * 256);
+	std::vector<uint32_t> expected_hits(lines);
+	for (uint32_t line = 0; line < lines; line++)
+	{
+		expected_hits[line] = NESCompositor::ComposeLine(NESCompositor::Kernel::Scalar,
+			&set.Background[line * 256], &set.Sprites[line * 256], &set.Behind[line * 256], &set.Zero[line * 256],
+			&expected[line * 256], 256);
+	}
+
+	printf("Lines            : %d x %d\n", lines, repeat);
+	printf("Sprite density   : %d%%\n", density);
+	printf("Best kernel      : %s\n", NESCompositor::GetKernelName(NESCompositor::GetBestKernel()));
+
+	uint32_t mismatches = 0;
+	double scalar_seconds = 0.0;
+	std::vector<uint8_t> output(lines * 256);
+	for (uint32_t kernel_index = 0; kernel_index < (uint32_t)NESCompositor::Kernel::Count; kernel_index++)
+	{
+		const NESCompositor::Kernel kernel = (NESCompositor::Kernel)kernel_index;
+		if (!NESCompositor::IsSupported(kernel))
+		{
+			printf("%-16s : not supported\n", NESCompositor::GetKernelName(kernel));
+			continue;
+		}
+
+		//Results are summed so composition can't be thrown away
+		uint64_t hit_sum = 0;
+		chrono_clock::time_point start_timestamp = chrono_clock::now();
+		for (uint32_t pass = 0; pass < repeat; pass++)
+		{
+			for (uint32_t line = 0; line < lines; line++)
+			{
+				hit_sum += NESCompositor::ComposeLine(kernel,
+					&set.Background[line * 256], &set.Sprites[line * 256], &set.Behind[line * 256], &set.Zero[line * 256],
+					&output[line * 256], 256);
+			}
+		}
+		double seconds = std::chrono::duration<double>(chrono_clock::now() - start_timestamp).count();
+		if (seconds <= 0.0) seconds = 1e-9;
+		if (kernel == NESCompositor::Kernel::Scalar) scalar_seconds = seconds;
+
+		bool is_matching = (output == expected);
+		uint64_t expected_sum = 0;
+		for (uint32_t line = 0; line < lines; line++)
+			expected_sum += expected_hits[line];
+		is_matching &= (hit_sum == expected_sum * repeat);
+		if (!is_matching) mismatches++;
+
+		const double composed = (double)lines * repeat;
+		printf("%-16s : %.3f s, %.2f Mlines/sec (%.2fx)%s\n", NESCompositor::GetKernelName(kernel), seconds,
+			composed / seconds / 1e6, scalar_seconds / seconds, is_matching ? "" : " MISMATCH");
+	}
+
+	return mismatches == 0 ? 0 : 3;
+}
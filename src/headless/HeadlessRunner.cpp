@@ -0,0 +1,206 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "NESDevice.h"
+
+// Headless runner : loads ROM, runs requested amount of frames as fast as possible
+// and reports throughput. No window, no audio, no input - only the emulator core.
+
+using chrono_clock = std::chrono::steady_clock;
+
+static void PrintUsage(const char* exe)
+{
+	printf("Usage : %s <rom_file> [options]\n", exe);
+	printf("\t-f, --frames <count>  : amount of frames to emulate (default 600)\n");
+	printf("\t    --per-cycle       : run cpu and ppu in lockstep (slow reference mode)\n");
+	printf("\t    --no-idle-skip    : execute idle loops instead of skipping to next event\n");
+	printf("\t    --no-fusion       : execute common instruction pairs one by one\n");
+	printf("\t    --no-line-render  : render every dot separately, even on lines without raster effects\n");
+	printf("\t    --jit             : run PRG ROM code through block recompiler (x86-64 only)\n");
+	printf("\t    --no-static       : ignore ahead-of-time recompiled code linked in (see nes_recompiler)\n");
+	printf("\t    --convert <format>: convert every frame like frontend would (rgb24, rgba32, rgb565, yuv420)\n");
+	printf("\t-h, --help            : show this message\n");
+}
+
+//FNV-1a, just to compare results between runs
+static uint64_t HashBytes(const uint8_t* data, size_t size)
+{
+	uint64_t hash = 0xCBF29CE484222325;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= data[i];
+		hash *= 0x00000100000001B3;
+	}
+	return hash;
+}
+
+int main(int argc, char** argv)
+{
+	std::string rom_file;
+	uint32_t frames = 600;
+	bool per_cycle = false;
+	bool idle_skip = true;
+	bool fusion = true;
+	bool line_render = true;
+	bool jit = false;
+	bool static_code = true;
+	bool convert = false;
+	NESVideo::Format convert_format = NESVideo::Format::RGB24;
+
+	for (int arg = 1; arg < argc; arg++)
+	{
+		if (!strcmp(argv[arg], "-h") || !strcmp(argv[arg], "--help"))
+		{
+			PrintUsage(argv[0]);
+			return 0;
+		}
+		else if ((!strcmp(argv[arg], "-f") || !strcmp(argv[arg], "--frames")) && (arg + 1) < argc)
+		{
+			frames = (uint32_t)strtoul(argv[++arg], nullptr, 10);
+		}
+		else if (!strcmp(argv[arg], "--per-cycle"))
+		{
+			per_cycle = true;
+		}
+		else if (!strcmp(argv[arg], "--no-idle-skip"))
+		{
+			idle_skip = false;
+		}
+		else if (!strcmp(argv[arg], "--no-fusion"))
+		{
+			fusion = false;
+		}
+		else if (!strcmp(argv[arg], "--no-line-render"))
+		{
+			line_render = false;
+		}
+		else if (!strcmp(argv[arg], "--jit"))
+		{
+			jit = true;
+		}
+		else if (!strcmp(argv[arg], "--no-static"))
+		{
+			static_code = false;
+		}
+		else if (!strcmp(argv[arg], "--convert") && (arg + 1) < argc)
+		{
+			const char* format_name = argv[++arg];
+			if (!strcmp(format_name, "rgb24")) convert_format = NESVideo::Format::RGB24;
+			else if (!strcmp(format_name, "rgba32")) convert_format = NESVideo::Format::RGBA32;
+			else if (!strcmp(format_name, "rgb565")) convert_format = NESVideo::Format::RGB565;
+			else if (!strcmp(format_name, "yuv420")) convert_format = NESVideo::Format::YUV420;
+			else
+			{
+				printf("Unknown format \"%s\"\n", format_name);
+				return 1;
+			}
+			convert = true;
+		}
+		else if (argv[arg][0] != '-' && rom_file.empty())
+		{
+			rom_file = argv[arg];
+		}
+		else
+		{
+			printf("Unknown argument \"%s\"\n", argv[arg]);
+			PrintUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (rom_file.empty())
+	{
+		PrintUsage(argv[0]);
+		return 1;
+	}
+
+	NESDevice nesDevice;
+	if (!nesDevice.GetCartrige().LoadCartrige(rom_file))
+		return 2;
+
+	//No PPU viewers here
+	nesDevice.SetLeanMode(true);
+	nesDevice.Reset();
+	nesDevice.ExecutionMode = per_cycle ? NESDevice::ExecutionMode::PerCycle : NESDevice::ExecutionMode::PerInstruction;
+	nesDevice.IdleLoopSkipping = idle_skip;
+	nesDevice.InstructionFusion = fusion;
+	nesDevice.ScanlineRendering = line_render;
+	nesDevice.JITEnabled = jit;
+	nesDevice.StaticCodeEnabled = static_code;
+	if (static_code && nesDevice.GetStaticCode() != nullptr)
+		printf("Running recompiled code for \"%s\"\n", nesDevice.GetStaticCode()->ROMName);
+	if (jit && !nesDevice.GetJIT().IsSupported())
+		printf("Recompiler isn't supported on this host, running interpreter\n");
+	nesDevice.DeviceMode = NESDevice::DeviceMode::Running;
+
+	//CPU cycle counter is 32 bit, accumulate deltas to survive wrapping
+	uint64_t cpu_cycles = 0;
+	uint64_t first_device_cycle = nesDevice.DeviceCycle;
+	uint32_t last_cpu_cycle = nesDevice.GetCPU().State.CyclesTotal;
+
+	//PPU outputs NES colors only, conversion is paid by whoever needs pixels
+	std::vector<uint8_t> converted(convert ? NESVideo::GetFrameSize(convert_format, 240) : 0);
+	double convert_seconds = 0.0;
+
+	uint32_t frames_done = 0;
+	chrono_clock::time_point start_timestamp = chrono_clock::now();
+	while (frames_done < frames)
+	{
+		nesDevice.Update();
+		if (convert)
+		{
+			chrono_clock::time_point convert_timestamp = chrono_clock::now();
+			nesDevice.GetPPU().ConvertFramebuffer(convert_format, converted.data());
+			convert_seconds += std::chrono::duration<double>(chrono_clock::now() - convert_timestamp).count();
+		}
+
+		cpu_cycles += (uint32_t)(nesDevice.GetCPU().State.CyclesTotal - last_cpu_cycle);
+		last_cpu_cycle = nesDevice.GetCPU().State.CyclesTotal;
+
+		//Device falls back to pause only if cpu is halted
+		if (nesDevice.DeviceMode != NESDevice::DeviceMode::Running)
+		{
+			printf("CPU halted after %d frames\n", frames_done);
+			break;
+		}
+		frames_done++;
+	}
+	chrono_clock::time_point end_timestamp = chrono_clock::now();
+
+	uint64_t master_cycles = nesDevice.DeviceCycle - first_device_cycle;
+
+	double seconds = std::chrono::duration<double>(end_timestamp - start_timestamp).count();
+	if (seconds <= 0.0) seconds = 1e-9;
+
+	printf("Frames           : %d\n", frames_done);
+	printf("Time             : %.3f s\n", seconds);
+	printf("Frames/sec       : %.2f\n", frames_done / seconds);
+	printf("CPU cycles/sec   : %.0f (%.2fx realtime)\n", cpu_cycles / seconds, (cpu_cycles / seconds) / 1789773.0);
+	printf("Master cycles/sec: %.0f\n", master_cycles / seconds);
+	printf("Idle cycles skip.: %llu\n", (unsigned long long)nesDevice.IdleLoopCyclesSkipped);
+	printf("Fused instr.     : %llu\n", (unsigned long long)nesDevice.GetCPU().FusedInstructions);
+	if (jit)
+	{
+		printf("JIT instructions : %llu (%llu blocks compiled)\n",
+			(unsigned long long)nesDevice.GetJIT().InstructionsExecuted, (unsigned long long)nesDevice.GetJIT().BlocksCompiled);
+	}
+	if (static_code && nesDevice.GetStaticCode() != nullptr)
+	{
+		printf("Static instr.    : %llu\n", (unsigned long long)nesDevice.StaticCodeInstructions);
+	}
+	if (convert)
+	{
+		printf("Conversion       : %s, %.1f us/frame\n", NESVideo::GetFormatName(convert_format),
+			frames_done ? convert_seconds * 1e6 / frames_done : 0.0);
+	}
+	const NESROMImage* rom_image = nesDevice.GetCartrige().GetROMImage();
+	printf("Instance memory  : %.1f KB (+%.1f KB shared ROM image)\n", nesDevice.GetMemoryFootprint() / 1024.0,
+		rom_image ? rom_image->GetMemoryFootprint() / 1024.0 : 0.0);
+	printf("Framebuffer hash : %016llX\n", (unsigned long long)HashBytes(nesDevice.GetPPU().GetIndexFramebuffer(), 256 * 240));
+
+	return 0;
+}
@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "NESRunner.h"
+
+// Job runner : runs many independent emulator instances (ROMs x seeds) on all cores
+// and prints per-job results (framebuffer/RAM hash, halt status) and aggregate throughput.
+
+using chrono_clock = std::chrono::steady_clock;
+
+static void PrintUsage(const char* exe)
+{
+	printf("Usage : %s <rom_file> [rom_file...] [options]\n", exe);
+	printf("\t-f, --frames <count>  : frame budget of every job (default 600)\n");
+	printf("\t-j, --threads <count> : worker threads (default - all hardware threads)\n");
+	printf("\t-s, --seeds <count>   : jobs per ROM with random input seeds 1..count (default 1 job without input)\n");
+	printf("\t    --input <file>    : input script for every job, lines \"<frame> <buttons hex>\"\n");
+	printf("\t    --dump-ram <dir>  : write RAM snapshot of every job into <dir>/job_<index>.ram\n");
+	printf("\t    --no-idle-skip    : execute idle loops instead of skipping to next event\n");
+	printf("\t    --jit             : run PRG ROM code through block recompiler (x86-64 only)\n");
+	printf("\t-q, --quiet           : print only summary\n");
+	printf("\t-h, --help            : show this message\n");
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> rom_files;
+	uint32_t frames = 600;
+	uint32_t threads = 0;
+	uint32_t seeds = 0;
+	std::string input_script;
+	std::string dump_dir;
+	bool idle_skip = true;
+	bool jit = false;
+	bool quiet = false;
+
+	for (int arg = 1; arg < argc; arg++)
+	{
+		if (!strcmp(argv[arg], "-h") || !strcmp(argv[arg], "--help"))
+		{
+			PrintUsage(argv[0]);
+			return 0;
+		}
+		else if ((!strcmp(argv[arg], "-f") || !strcmp(argv[arg], "--frames")) && (arg + 1) < argc)
+		{
+			frames = (uint32_t)strtoul(argv[++arg], nullptr, 10);
+		}
+		else if ((!strcmp(argv[arg], "-j") || !strcmp(argv[arg], "--threads")) && (arg + 1) < argc)
+		{
+			threads = (uint32_t)strtoul(argv[++arg], nullptr, 10);
+		}
+		else if ((!strcmp(argv[arg], "-s") || !strcmp(argv[arg], "--seeds")) && (arg + 1) < argc)
+		{
+			seeds = (uint32_t)strtoul(argv[++arg], nullptr, 10);
+		}
+		else if (!strcmp(argv[arg], "--input") && (arg + 1) < argc)
+		{
+			input_script = argv[++arg];
+		}
+		else if (!strcmp(argv[arg], "--dump-ram") && (arg + 1) < argc)
+		{
+			dump_dir = argv[++arg];
+		}
+		else if (!strcmp(argv[arg], "--no-idle-skip"))
+		{
+			idle_skip = false;
+		}
+		else if (!strcmp(argv[arg], "--jit"))
+		{
+			jit = true;
+		}
+		else if (!strcmp(argv[arg], "-q") || !strcmp(argv[arg], "--quiet"))
+		{
+			quiet = true;
+		}
+		else if (argv[arg][0] != '-')
+		{
+			rom_files.push_back(argv[arg]);
+		}
+		else
+		{
+			printf("Unknown argument \"%s\"\n", argv[arg]);
+			PrintUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (rom_files.empty())
+	{
+		PrintUsage(argv[0]);
+		return 1;
+	}
+
+	std::vector<NESJob> jobs;
+	for (const std::string& rom_file : rom_files)
+	{
+		for (uint32_t seed = (seeds == 0) ? 0 : 1; seed <= seeds; seed++)
+		{
+			NESJob job;
+			job.ROMFile = rom_file;
+			job.Frames = frames;
+			job.Seed = seed;
+			job.InputScript = input_script;
+			job.IdleLoopSkipping = idle_skip;
+			job.JITEnabled = jit;
+			jobs.push_back(job);
+		}
+	}
+
+	NESRunner runner(threads);
+	chrono_clock::time_point start_timestamp = chrono_clock::now();
+	std::vector<NESJobResult> results = runner.Run(jobs);
+	double seconds = std::chrono::duration<double>(chrono_clock::now() - start_timestamp).count();
+	if (seconds <= 0.0) seconds = 1e-9;
+
+	uint64_t frames_done = 0;
+	uint32_t failed = 0;
+	uint32_t halted = 0;
+	uint64_t max_footprint = 0;
+	for (size_t index = 0; index < results.size(); index++)
+	{
+		const NESJobResult& result = results[index];
+		frames_done += result.FramesDone;
+		if (!result.Loaded) failed++;
+		if (result.Halted) halted++;
+		max_footprint = std::max(max_footprint, result.MemoryFootprint);
+
+		if (!quiet)
+		{
+			printf("Job %4d : %s seed %d : %s, %d frames, fb %016llX, ram %016llX, %.3f s (worker %d)\n",
+				(int)index, jobs[index].ROMFile.c_str(), jobs[index].Seed,
+				!result.Loaded ? "FAILED" : result.Halted ? "halted" : "ok", result.FramesDone,
+				(unsigned long long)result.FramebufferHash,
+				(unsigned long long)(result.RAM.empty() ? 0 : NESRunner::Hash(result.RAM.data(), result.RAM.size())),
+				result.Seconds, result.Worker);
+		}
+
+		if (!dump_dir.empty() && !result.RAM.empty())
+		{
+			std::ofstream ofs(dump_dir + "/job_" + std::to_string(index) + ".ram", std::ofstream::binary);
+			ofs.write((const char*)result.RAM.data(), result.RAM.size());
+		}
+	}
+
+	printf("Jobs             : %d (%d failed, %d halted)\n", (int)jobs.size(), failed, halted);
+	printf("Threads          : %d\n", runner.GetThreadCount());
+	printf("Jobs stolen      : %llu\n", (unsigned long long)runner.JobsStolen);
+	printf("Time             : %.3f s\n", seconds);
+	printf("Frames           : %llu\n", (unsigned long long)frames_done);
+	printf("Frames/sec       : %.2f\n", frames_done / seconds);
+	printf("Instance memory  : %.1f KB (largest)\n", max_footprint / 1024.0);
+
+	return failed == 0 ? 0 : 2;
+}
@@ -1,22 +1,45 @@
 #pragma once
 
+#include <memory>
+
 #include "NESState.h"
 
 class NESMapper
 {
 public:
 
+	//When mapper wants its Update to be called by device
+	enum class ClockMode : uint32_t
+	{
+		None,		//Update is never called
+		CPUCycle,	//Every cpu cycle (cpu cycle counters)
+		Scanline,	//Every time ppu completes scanline
+		PPUA12		//On rising edge of PPU address line A12 (MMC3-like scanline counters)
+	};
+
+	//Mappers are owned and replaced through NESMapper pointers
+	virtual ~NESMapper() = default;
+
 	virtual void Reset() = 0;
 	virtual void Update() = 0;
+	virtual ClockMode GetClockMode() = 0;
 
 	virtual bool SaveState(NESState& state) = 0;
 	virtual bool LoadState(NESState& state) = 0;
+	//Copies mapper with its state into target (reuses target if it is the same mapper)
+	virtual void CloneInto(std::unique_ptr<NESMapper>& target) = 0;
 
 	//if any of XXXIntercept (except InterceptVRAM) functions return true
 	//  then no read/write operation should be performed on cartrige data
 
 	virtual bool CPUReadIntercept(uint16_t address, uint32_t* out_address) = 0;
 	virtual bool CPUWriteIntercept(uint16_t address, uint32_t* out_address, uint8_t data) = 0;
+	//Should return true if cpu write may change anything used by PPU (CHR banks, mirroring)
+	// PPU is brought up to date before such writes when it runs behind cpu
+	virtual bool IsPPUAffectedByWrite(uint16_t address) = 0;
+	//Should return true if cpu write is going to switch PRG/CHR banks or mirroring (checked before the write)
+	// device rebuilds its memory map only after such writes
+	virtual bool IsMemoryMapAffectedByWrite(uint16_t address, uint8_t data) = 0;
 
 	virtual bool PPUReadIntercept(uint16_t address, uint32_t* out_address) = 0;
 	virtual bool PPUWriteIntercept(uint16_t address, uint32_t* out_address, uint8_t data) = 0;
@@ -27,4 +50,10 @@ public:
 	virtual bool PPUInterceptVRAM(uint16_t address, uint16_t* out_address) = 0;
 
 protected:
+	template<typename Mapper>
+	static void clone_mapper(const Mapper& mapper, std::unique_ptr<NESMapper>& target)
+	{
+		if (Mapper* same = dynamic_cast<Mapper*>(target.get())) *same = mapper;
+		else target = std::make_unique<Mapper>(mapper);
+	}
 };
\ No newline at end of file
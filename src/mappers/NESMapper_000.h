@@ -4,7 +4,7 @@
 
 #include "NESMapper.h"
 
-class NESMapper_000 : public NESMapper
+class NESMapper_000 final : public NESMapper
 {
 public:
 	NESMapper_000(uint32_t prg_chunks, uint32_t chr_chunks, uint8_t mirroring_mode)
@@ -24,6 +24,11 @@ public:
 		// ...same for update
 	}
 
+	ClockMode GetClockMode()
+	{
+		return ClockMode::None; //Update does nothing
+	}
+
 	bool SaveState(NESState& state)
 	{
 		// this mapper doesnt require to save its state
@@ -36,6 +41,11 @@ public:
 		return true;
 	}
 
+	void CloneInto(std::unique_ptr<NESMapper>& target)
+	{
+		clone_mapper(*this, target);
+	}
+
 	//CPU Bus RW operations
 	bool CPUReadIntercept(uint16_t address, uint32_t* out_address)
 	{
@@ -54,6 +64,16 @@ public:
 		return true; //intercept write
 	}
 
+	bool IsPPUAffectedByWrite(uint16_t /*address*/)
+	{
+		return false; //nothing to switch
+	}
+
+	bool IsMemoryMapAffectedByWrite(uint16_t /*address*/, uint8_t /*data*/)
+	{
+		return false; //nothing to switch
+	}
+
 	//PPU Buss RW operations
 	bool PPUReadIntercept(uint16_t address, uint32_t* out_address)
 	{
@@ -8,7 +8,7 @@
 //							Placeholder for mapper 001								 //
 ///////////////////////////////////////////////////////////////////////////////////////
 
-class NESMapper_001 : public NESMapper
+class NESMapper_001 final : public NESMapper
 {
 public:
 	NESMapper_001(uint32_t prg_chunks, uint32_t chr_chunks)
@@ -19,6 +19,8 @@ public:
 
 	void Reset()
 	{
+		m_ShiftRegister = 0;
+		m_ShiftPosition = 0;
 		m_ControlRegister = 0x0C;
 
 		m_CHRActiveLOBank = 0;
@@ -35,6 +37,11 @@ public:
 
 	}
 
+	ClockMode GetClockMode()
+	{
+		return ClockMode::None; //Update does nothing
+	}
+
 	bool SaveState(NESState& state)
 	{
 		state.Write(&m_ShiftRegister, sizeof(uint8_t));
@@ -69,6 +76,11 @@ public:
 		return true;
 	}
 
+	void CloneInto(std::unique_ptr<NESMapper>& target)
+	{
+		clone_mapper(*this, target);
+	}
+
 	//CPU Bus RW operations
 	bool CPUReadIntercept(uint16_t address, uint32_t* out_address)
 	{
@@ -159,6 +171,17 @@ public:
 		return true;
 	}
 
+	bool IsPPUAffectedByWrite(uint16_t address)
+	{
+		return address >= 0x8000; //CHR banks and mirroring control
+	}
+
+	bool IsMemoryMapAffectedByWrite(uint16_t address, uint8_t data)
+	{
+		//Registers are loaded only by 5th write into shift register (reset bit changes nothing else)
+		return address >= 0x8000 && !(data & 0x80) && m_ShiftPosition == 4;
+	}
+
 	//PPU Buss RW operations
 	bool PPUReadIntercept(uint16_t address, uint32_t* out_address)
 	{
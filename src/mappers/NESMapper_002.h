@@ -4,7 +4,7 @@
 
 #include "NESMapper.h"
 
-class NESMapper_002 : public NESMapper
+class NESMapper_002 final : public NESMapper
 {
 public:
 	NESMapper_002(uint32_t prg_chunks, uint32_t chr_chunks, uint8_t mirroring_mode)
@@ -26,6 +26,11 @@ public:
 		// ...same for update
 	}
 
+	ClockMode GetClockMode()
+	{
+		return ClockMode::None; //Update does nothing
+	}
+
 	bool SaveState(NESState& state)
 	{
 		state.Write(&m_PRGActiveBank, sizeof(uint8_t));
@@ -38,6 +43,11 @@ public:
 		return true;
 	}
 
+	void CloneInto(std::unique_ptr<NESMapper>& target)
+	{
+		clone_mapper(*this, target);
+	}
+
 	//CPU Bus RW operations
 	bool CPUReadIntercept(uint16_t address, uint32_t* out_address)
 	{
@@ -54,15 +64,29 @@ public:
 
 	bool CPUWriteIntercept(uint16_t address, uint32_t* out_address, uint8_t data)
 	{
-		data &= 0x0F;
-		if (data < m_PRGChunksCount-1)
-			m_PRGActiveBank = data;
-		else
-			m_PRGActiveBank = 0;
+		//Bank select register is at $8000-$FFFF
+		if (address >= 0x8000)
+		{
+			data &= 0x0F;
+			if (data < m_PRGChunksCount-1)
+				m_PRGActiveBank = data;
+			else
+				m_PRGActiveBank = 0;
+		}
 		*out_address = address;
 		return true; //intercept write
 	}
 
+	bool IsPPUAffectedByWrite(uint16_t /*address*/)
+	{
+		return false; //only PRG is switched
+	}
+
+	bool IsMemoryMapAffectedByWrite(uint16_t address, uint8_t /*data*/)
+	{
+		return address >= 0x8000; //PRG bank select
+	}
+
 	//PPU Buss RW operations
 	bool PPUReadIntercept(uint16_t address, uint32_t* out_address)
 	{
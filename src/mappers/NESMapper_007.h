@@ -4,7 +4,7 @@
 
 #include "NESMapper.h"
 
-class NESMapper_007 : public NESMapper
+class NESMapper_007 final : public NESMapper
 {
 public:
 	NESMapper_007(uint32_t prg_chunks, uint32_t chr_chunks)
@@ -26,6 +26,11 @@ public:
 		// ...same for update
 	}
 
+	ClockMode GetClockMode()
+	{
+		return ClockMode::None; //Update does nothing
+	}
+
 	bool SaveState(NESState& state)
 	{
 		state.Write(&m_PRGActiveBank, sizeof(uint8_t));
@@ -40,6 +45,11 @@ public:
 		return true;
 	}
 
+	void CloneInto(std::unique_ptr<NESMapper>& target)
+	{
+		clone_mapper(*this, target);
+	}
+
 	//CPU Bus RW operations
 	bool CPUReadIntercept(uint16_t address, uint32_t* out_address)
 	{
@@ -49,20 +59,34 @@ public:
 
 	bool CPUWriteIntercept(uint16_t address, uint32_t* out_address, uint8_t data)
 	{
-		//VRAM table switching
-		m_VRAMTable = data & 0x10 >> 4;
-
-		//PRG bank switching
-		data &= 0x07;
-		if ( (uint32_t)(data << 1) < m_PRGChunksCount)
-			m_PRGActiveBank = data;
-		else
-			m_PRGActiveBank = 0;
+		//Bank select register is at $8000-$FFFF
+		if (address >= 0x8000)
+		{
+			//VRAM table switching
+			m_VRAMTable = data & 0x10 >> 4;
+
+			//PRG bank switching
+			data &= 0x07;
+			if ( (uint32_t)(data << 1) < m_PRGChunksCount)
+				m_PRGActiveBank = data;
+			else
+				m_PRGActiveBank = 0;
+		}
 
 		*out_address = address;
 		return true; //intercept write
 	}
 
+	bool IsPPUAffectedByWrite(uint16_t address)
+	{
+		return address >= 0x8000; //VRAM table is switched on any register write
+	}
+
+	bool IsMemoryMapAffectedByWrite(uint16_t address, uint8_t /*data*/)
+	{
+		return address >= 0x8000; //PRG bank and VRAM table select
+	}
+
 	//PPU Buss RW operations
 	bool PPUReadIntercept(uint16_t address, uint32_t* out_address)
 	{
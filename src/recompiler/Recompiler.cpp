@@ -0,0 +1,549 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdarg>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "NESDevice.h"
+
+// Static recompiler : translates PRG ROM of NROM (mapper 0) title into C++ source.
+// Code is found by recursive descent disassembly from reset/nmi/irq vectors (branches, JSR, JMP abs),
+// every block becomes one function (see NESStaticCode.h). Indirect jumps (JMP ind, RTI, BRK) are
+// left to the interpreter, as is anything reached only through them. Generated file registers itself
+// on startup, so it only has to be compiled into executable (see NES_STATIC_SOURCES in CMakeLists.txt).
+
+using AddrMode = NESCPU::AddrMode;
+
+static void PrintUsage(const char* exe)
+{
+	printf("Usage : %s <rom_file> [options]\n", exe);
+	printf("\t-o, --output <file>   : generated source file (default <rom_file>.static.cpp)\n");
+	printf("\t-h, --help            : show this message\n");
+}
+
+class Recompiler
+{
+public:
+	Recompiler(NESDevice& nesDevice) : m_NESDevice(nesDevice), m_CPU(nesDevice.GetCPU()) {}
+
+	bool Analyze();
+	bool Write(const std::string& file_name);
+
+	uint32_t InstructionCount() { return (uint32_t)m_Instructions.size(); }
+	uint32_t BlockCount() { return (uint32_t)m_Blocks.size(); }
+
+protected:
+	enum class Flow
+	{
+		Next,		//Execution continues with following instruction
+		Branch,		//Conditional branch
+		Jump,		//JMP abs
+		Call,		//JSR, returns to following instruction
+		End,		//RTS, JMP ind, RTI, BRK, illegal opcode - target unknown
+	};
+
+	NESDevice& m_NESDevice;
+	NESCPU& m_CPU;
+
+	std::set<uint16_t> m_Instructions;	//Every reachable instruction
+	std::set<uint16_t> m_Leaders;		//First instructions of blocks
+	std::vector<std::vector<uint16_t>> m_Blocks;
+	std::string m_Source;
+
+	uint8_t  peek(uint16_t address) { return m_NESDevice.CPUPeek(address); }
+	uint16_t peek16(uint16_t address) { return (uint16_t)peek(address) | ((uint16_t)peek(address + 1) << 8); }
+	Flow	 flow(uint16_t address, uint16_t* target);
+	//Instructions executed by interpreter, generated code returns before them
+	bool	 is_interpreted(uint8_t opcode);
+	//Worst case cycles (with page crossing and taken branch penalties)
+	uint32_t max_cycles(uint16_t address);
+
+	void out(const char* format, ...);
+	void write_block(const std::vector<uint16_t>& block);
+	void write_instruction(uint16_t address, bool is_last);
+	//Emits code fetching operand to 'm' (reads) or pointer to 'w' (stores and rmw), returns penalty expression
+	std::string write_operand(uint16_t address, bool is_write, bool is_rmw);
+};
+
+Recompiler::Flow Recompiler::flow(uint16_t address, uint16_t* target)
+{
+	const uint8_t opcode = peek(address);
+	const std::string name = m_CPU.GetInstructionName(opcode);
+	const AddrMode mode = m_CPU.GetInstructionMode(opcode);
+
+	if (mode == AddrMode::XXX) return Flow::End;
+	if (mode == AddrMode::REL)
+	{
+		*target = (uint16_t)(address + 2 + (int8_t)peek(address + 1));
+		return Flow::Branch;
+	}
+	if (name == "JMP" && mode == AddrMode::ABS)
+	{
+		*target = peek16(address + 1);
+		return Flow::Jump;
+	}
+	if (name == "JSR")
+	{
+		*target = peek16(address + 1);
+		return Flow::Call;
+	}
+	if (name == "JMP" || name == "RTS" || name == "RTI" || name == "BRK") return Flow::End;
+	return Flow::Next;
+}
+
+bool Recompiler::is_interpreted(uint8_t opcode)
+{
+	//Interrupt flag changes are left to interpreter, so pending irq is taken at the right instruction
+	const std::string name = m_CPU.GetInstructionName(opcode);
+	return m_CPU.GetInstructionMode(opcode) == AddrMode::XXX || name == "BRK" || name == "RTI" ||
+		(name == "JMP" && m_CPU.GetInstructionMode(opcode) == AddrMode::IND) ||
+		name == "CLI" || name == "SEI" || name == "PLP";
+}
+
+uint32_t Recompiler::max_cycles(uint16_t address)
+{
+	const uint8_t opcode = peek(address);
+	const std::string name = m_CPU.GetInstructionName(opcode);
+	const AddrMode mode = m_CPU.GetInstructionMode(opcode);
+
+	if (mode == AddrMode::REL) return 4;
+	if (name == "JMP") return 3;
+	if (name == "JSR" || name == "RTS") return 6;
+	if (name == "PHA" || name == "PHP") return 3;
+	if (name == "PLA") return 4;
+
+	const bool is_rmw = (name == "ASL" || name == "LSR" || name == "ROL" || name == "ROR" || name == "INC" || name == "DEC");
+	switch (mode)
+	{
+	case AddrMode::IMM: return 2;
+	case AddrMode::IMP: return 2;
+	case AddrMode::ACC: return 2;
+	case AddrMode::ZPG: return is_rmw ? 5 : 3;
+	case AddrMode::ZPX: return is_rmw ? 6 : 4;
+	case AddrMode::ZPY: return 4;
+	case AddrMode::ABS: return is_rmw ? 6 : 4;
+	case AddrMode::ABX: return is_rmw ? 7 : 5;
+	case AddrMode::ABY: return 5;
+	case AddrMode::XIN: return 6;
+	case AddrMode::INY: return 6;
+	default: return 7;
+	}
+}
+
+bool Recompiler::Analyze()
+{
+	std::vector<uint16_t> pending = { peek16(0xFFFC), peek16(0xFFFA), peek16(0xFFFE) };
+	for (uint16_t root : pending) m_Leaders.insert(root);
+
+	while (!pending.empty())
+	{
+		uint16_t address = pending.back();
+		pending.pop_back();
+
+		while (address >= 0x8000)
+		{
+			//Already walked from there (also when streams converge), has to start its own block
+			if (m_Instructions.count(address))
+			{
+				m_Leaders.insert(address);
+				break;
+			}
+
+			const uint8_t size = m_CPU.GetInstructionSize(peek(address));
+			if ((uint32_t)address + size > 0x10000) break;
+			m_Instructions.insert(address);
+
+			uint16_t target = 0;
+			const Flow next = flow(address, &target);
+			const uint16_t next_address = address + size;
+
+			if (next == Flow::Branch || next == Flow::Jump || next == Flow::Call)
+			{
+				if (target >= 0x8000)
+				{
+					m_Leaders.insert(target);
+					pending.push_back(target);
+				}
+			}
+			if (next == Flow::Jump || next == Flow::End) break;
+			if (next == Flow::Branch || next == Flow::Call) m_Leaders.insert(next_address);
+			address = next_address;
+		}
+	}
+
+	//Split code into blocks, block ends at control transfer or in front of next leader
+	for (uint16_t leader : m_Leaders)
+	{
+		if (!m_Instructions.count(leader)) continue;
+
+		std::vector<uint16_t> block;
+		uint16_t address = leader;
+		while (true)
+		{
+			block.push_back(address);
+			uint16_t target = 0;
+			if (flow(address, &target) != Flow::Next) break;
+
+			const uint32_t next_address = (uint32_t)address + m_CPU.GetInstructionSize(peek(address));
+			if (next_address > 0xFFFF || !m_Instructions.count((uint16_t)next_address) || m_Leaders.count((uint16_t)next_address)) break;
+			address = (uint16_t)next_address;
+		}
+		m_Blocks.push_back(block);
+	}
+
+	return !m_Blocks.empty();
+}
+
+void Recompiler::out(const char* format, ...)
+{
+	char buffer[512];
+	va_list args;
+	va_start(args, format);
+	vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+	m_Source += buffer;
+}
+
+std::string Recompiler::write_operand(uint16_t address, bool is_write, bool is_rmw)
+{
+	const uint8_t  opcode = peek(address);
+	const AddrMode mode = m_CPU.GetInstructionMode(opcode);
+	const uint8_t  op8 = peek(address + 1);
+	const uint16_t op16 = peek16(address + 1);
+	std::string penalty = "0";
+
+	//Zeropage and internal RAM are always plain memory
+	std::string ram;
+	char expression[96];
+	switch (mode)
+	{
+	case AddrMode::IMM:
+		out("\t\tconst uint8_t m = 0x%02X;\n", op8);
+		return penalty;
+	case AddrMode::ZPG:
+		snprintf(expression, sizeof(expression), "c.RAM[0x%02X]", op8);
+		ram = expression;
+		break;
+	case AddrMode::ZPX:
+	case AddrMode::ZPY:
+		snprintf(expression, sizeof(expression), "c.RAM[(uint8_t)(0x%02X + c.%s)]", op8, mode == AddrMode::ZPX ? "XR" : "YR");
+		ram = expression;
+		break;
+	case AddrMode::ABS:
+		if (op16 < 0x2000)
+		{
+			snprintf(expression, sizeof(expression), "c.RAM[0x%03X]", op16 & 0x07FF);
+			ram = expression;
+		}
+		else
+		{
+			out("\t\tconst uint16_t a = 0x%04X;\n", op16);
+		}
+		break;
+	case AddrMode::ABX:
+	case AddrMode::ABY:
+		out("\t\tconst uint16_t a = (uint16_t)(0x%04X + c.%s);\n", op16, mode == AddrMode::ABX ? "XR" : "YR");
+		snprintf(expression, sizeof(expression), "(((a ^ 0x%04X) & 0xFF00) ? 1 : 0)", op16);
+		penalty = expression;
+		break;
+	case AddrMode::XIN:
+		out("\t\tconst uint16_t a = c.ZeroPagePtr((uint8_t)(0x%02X + c.XR));\n", op8);
+		break;
+	case AddrMode::INY:
+		out("\t\tconst uint16_t p = c.ZeroPagePtr(0x%02X);\n", op8);
+		out("\t\tconst uint16_t a = (uint16_t)(p + c.YR);\n");
+		penalty = "(((a ^ p) & 0xFF00) ? 1 : 0)";
+		break;
+	default:
+		break;
+	}
+
+	//Penalty applies to reads only, indexed stores and rmw always take the extra cycle
+	if (is_write || is_rmw)
+	{
+		if (!ram.empty())
+			out("\t\tuint8_t* const w = &%s;\n", ram.c_str());
+		else
+			out("\t\tuint8_t* const w = c.WritePtr(a);\n\t\tif (w == nullptr) return;\n");
+		if (is_rmw) out("\t\tuint8_t m = *w;\n");
+		return "0";
+	}
+
+	if (!ram.empty())
+		out("\t\tconst uint8_t m = %s;\n", ram.c_str());
+	else
+		out("\t\tuint8_t m;\n\t\tif (!c.Read(a, m)) return;\n");
+	return penalty;
+}
+
+void Recompiler::write_instruction(uint16_t address, bool is_last)
+{
+	const uint8_t  opcode = peek(address);
+	const std::string name = m_CPU.GetInstructionName(opcode);
+	const AddrMode mode = m_CPU.GetInstructionMode(opcode);
+	const uint16_t next_address = address + m_CPU.GetInstructionSize(opcode);
+
+	if (is_interpreted(opcode))
+	{
+		out("\t\treturn;\n");
+		return;
+	}
+
+	uint32_t cycles = max_cycles(address);
+	std::string penalty = "0";
+
+	//Control transfer
+	if (mode == AddrMode::REL)
+	{
+		static const struct { const char* Name; const char* Condition; } conditions[] = {
+			{ "BPL", "!(c.SR & 0x80)" }, { "BMI", "(c.SR & 0x80)" }, { "BVC", "!(c.SR & 0x40)" }, { "BVS", "(c.SR & 0x40)" },
+			{ "BCC", "!(c.SR & 0x01)" }, { "BCS", "(c.SR & 0x01)" }, { "BNE", "!(c.SR & 0x02)" }, { "BEQ", "(c.SR & 0x02)" },
+		};
+		const char* condition = "false";
+		for (auto& entry : conditions)
+		{
+			if (name == entry.Name) condition = entry.Condition;
+		}
+		const uint16_t target = (uint16_t)(next_address + (int8_t)peek(address + 1));
+		const uint32_t taken = ((target ^ next_address) & 0xFF00) ? 4 : 3;
+		out("\t\tif (%s) { c.PC = 0x%04X; c.Complete(%d); }\n", condition, target, taken);
+		out("\t\telse { c.PC = 0x%04X; c.Complete(2); }\n", next_address);
+		out("\t\treturn;\n");
+		return;
+	}
+	if (name == "JMP")
+	{
+		out("\t\tc.PC = 0x%04X;\n\t\tc.Complete(3);\n\t\treturn;\n", peek16(address + 1));
+		return;
+	}
+	if (name == "JSR")
+	{
+		const uint16_t return_address = address + 2;
+		out("\t\tc.Push(0x%02X);\n\t\tc.Push(0x%02X);\n", return_address >> 8, return_address & 0xFF);
+		out("\t\tc.PC = 0x%04X;\n\t\tc.Complete(6);\n\t\treturn;\n", peek16(address + 1));
+		return;
+	}
+	if (name == "RTS")
+	{
+		out("\t\tconst uint16_t low = c.Pull();\n\t\tconst uint16_t high = c.Pull();\n");
+		out("\t\tc.PC = (uint16_t)(((high << 8) | low) + 1);\n\t\tc.Complete(6);\n\t\treturn;\n");
+		return;
+	}
+
+	//Implied
+	static const struct { const char* Name; const char* Code; } implied[] = {
+		{ "TAX", "c.XR = c.AC; c.SetNZ(c.XR);" }, { "TXA", "c.AC = c.XR; c.SetNZ(c.AC);" },
+		{ "TAY", "c.YR = c.AC; c.SetNZ(c.YR);" }, { "TYA", "c.AC = c.YR; c.SetNZ(c.AC);" },
+		{ "TSX", "c.XR = c.SP; c.SetNZ(c.XR);" }, { "TXS", "c.SP = c.XR;" },
+		{ "INX", "c.XR++; c.SetNZ(c.XR);" }, { "DEX", "c.XR--; c.SetNZ(c.XR);" },
+		{ "INY", "c.YR++; c.SetNZ(c.YR);" }, { "DEY", "c.YR--; c.SetNZ(c.YR);" },
+		{ "CLC", "c.SetFlag(0x01, false);" }, { "SEC", "c.SetFlag(0x01, true);" },
+		{ "CLD", "c.SetFlag(0x08, false);" }, { "SED", "c.SetFlag(0x08, true);" },
+		{ "CLV", "c.SetFlag(0x40, false);" }, { "NOP", "" },
+		{ "PHA", "c.Push(c.AC);" }, { "PHP", "c.Push(c.SR | 0x20);" },
+		{ "PLA", "c.AC = c.Pull(); c.SetNZ(c.AC);" },
+	};
+	bool is_done = false;
+	if (mode == AddrMode::IMP)
+	{
+		for (auto& entry : implied)
+		{
+			if (name != entry.Name) continue;
+			if (entry.Code[0] != 0) out("\t\t%s\n", entry.Code);
+			is_done = true;
+		}
+	}
+
+	//Memory operations
+	static const struct { const char* Name; const char* Code; } reads[] = {
+		{ "LDA", "c.AC = m; c.SetNZ(c.AC);" }, { "LDX", "c.XR = m; c.SetNZ(c.XR);" }, { "LDY", "c.YR = m; c.SetNZ(c.YR);" },
+		{ "ORA", "c.AC |= m; c.SetNZ(c.AC);" }, { "AND", "c.AC &= m; c.SetNZ(c.AC);" }, { "EOR", "c.AC ^= m; c.SetNZ(c.AC);" },
+		{ "ADC", "c.AddWithCarry(m);" }, { "SBC", "c.AddWithCarry((uint8_t)~m);" },
+		{ "CMP", "c.Compare(c.AC, m);" }, { "CPX", "c.Compare(c.XR, m);" }, { "CPY", "c.Compare(c.YR, m);" },
+		{ "BIT", "c.SR = (c.SR & 0x3D) | (m & 0xC0) | ((c.AC & m) == 0 ? 0x02 : 0x00);" },
+	};
+	static const struct { const char* Name; const char* Code; } stores[] = {
+		{ "STA", "*w = c.AC;" }, { "STX", "*w = c.XR;" }, { "STY", "*w = c.YR;" },
+	};
+	static const struct { const char* Name; const char* Code; } rmws[] = {
+		{ "ASL", "c.SetFlag(0x01, (m & 0x80) != 0); m = (uint8_t)(m << 1);" },
+		{ "LSR", "c.SetFlag(0x01, (m & 0x01) != 0); m = (uint8_t)(m >> 1);" },
+		{ "ROL", "{ const uint8_t r = (uint8_t)((m << 1) | (c.SR & 0x01)); c.SetFlag(0x01, (m & 0x80) != 0); m = r; }" },
+		{ "ROR", "{ const uint8_t r = (uint8_t)((m >> 1) | ((c.SR & 0x01) << 7)); c.SetFlag(0x01, (m & 0x01) != 0); m = r; }" },
+		{ "INC", "m++;" }, { "DEC", "m--;" },
+	};
+	for (auto& entry : reads)
+	{
+		if (is_done || name != entry.Name) continue;
+		penalty = write_operand(address, false, false);
+		out("\t\t%s\n", entry.Code);
+		is_done = true;
+	}
+	for (auto& entry : stores)
+	{
+		if (is_done || name != entry.Name) continue;
+		write_operand(address, true, false);
+		out("\t\t%s\n", entry.Code);
+		is_done = true;
+	}
+	for (auto& entry : rmws)
+	{
+		if (is_done || name != entry.Name) continue;
+		if (mode == AddrMode::ACC)
+		{
+			out("\t\tuint8_t m = c.AC;\n\t\t%s\n\t\tc.AC = m;\n\t\tc.SetNZ(m);\n", entry.Code);
+		}
+		else
+		{
+			write_operand(address, false, true);
+			out("\t\t%s\n\t\t*w = m;\n\t\tc.SetNZ(m);\n", entry.Code);
+		}
+		is_done = true;
+	}
+
+	if (!is_done)
+	{
+		//Shouldn't happen for legal opcodes, interpreter takes care of it
+		out("\t\treturn;\n");
+		return;
+	}
+
+	//Worst case includes page crossing, static cycles are one less when penalty is added at runtime
+	if (penalty != "0")
+		out("\t\tc.Complete(%d + %s);\n", cycles - 1, penalty.c_str());
+	else
+		out("\t\tc.Complete(%d);\n", cycles);
+
+	if (is_last)
+		out("\t\tc.PC = 0x%04X;\n\t\treturn;\n", next_address);
+}
+
+void Recompiler::write_block(const std::vector<uint16_t>& block)
+{
+	const uint16_t start = block[0];
+
+	out("static void Block_%04X(NESStaticContext& c, uint32_t entry)\n{\n\tswitch (entry)\n\t{\n", start);
+	for (size_t index = 0; index < block.size(); index++)
+	{
+		std::string listing = m_CPU.Disassemble(block[index], 1)[0];
+		while (!listing.empty() && listing.back() == ' ') listing.pop_back();
+
+		out("\tcase %d: // %s\n\t{\n", (int)index, listing.c_str());
+		write_instruction(block[index], index + 1 == block.size());
+		out("\t}\n");
+		if (index + 1 < block.size()) out("\t[[fallthrough]];\n");
+	}
+	out("\tdefault:\n\t\treturn;\n\t}\n}\n");
+
+	//Worst case cycles from every instruction up to first one left to interpreter
+	std::vector<uint32_t> cycles(block.size() + 1, 0);
+	for (size_t index = block.size(); index-- > 0;)
+		cycles[index] = is_interpreted(peek(block[index])) ? 0 : cycles[index + 1] + max_cycles(block[index]);
+
+	out("static const uint16_t PC_%04X[] = {", start);
+	for (size_t index = 0; index < block.size(); index++) out("%s0x%04X", index ? ", " : " ", block[index]);
+	out(" };\nstatic const uint8_t OpCode_%04X[] = {", start);
+	for (size_t index = 0; index < block.size(); index++) out("%s0x%02X", index ? ", " : " ", peek(block[index]));
+	out(" };\nstatic const uint16_t MaxCycles_%04X[] = {", start);
+	for (size_t index = 0; index < block.size(); index++) out("%s%d", index ? ", " : " ", cycles[index]);
+	out(" };\n\n");
+}
+
+bool Recompiler::Write(const std::string& file_name)
+{
+	NESCartrige& cartrige = m_NESDevice.GetCartrige();
+
+	m_Source.clear();
+	out("// Generated by nes_recompiler from \"%s\", do not edit\n", cartrige.GetROMName().c_str());
+	out("// %d instructions in %d blocks\n\n", InstructionCount(), BlockCount());
+	out("#include \"NESStaticCode.h\"\n\n");
+
+	for (const std::vector<uint16_t>& block : m_Blocks)
+		write_block(block);
+
+	out("static const NESStaticBlock s_Blocks[] = {\n");
+	for (const std::vector<uint16_t>& block : m_Blocks)
+	{
+		const uint16_t start = block[0];
+		out("\t{ 0x%04X, %d, Block_%04X, PC_%04X, OpCode_%04X, MaxCycles_%04X },\n", start, (int)block.size(), start, start, start, start);
+	}
+	out("};\n\n");
+
+	std::string rom_name;
+	for (char c : cartrige.GetROMName())
+		rom_name += (c == '"' || c == '\\') ? '_' : c;
+	out("static const NESStaticCode s_StaticCode = { \"%s\", 0x%X, 0x%016llXULL, %d, s_Blocks };\n", rom_name.c_str(),
+		cartrige.GetPRGSize(), (unsigned long long)NESStaticCode::Hash(cartrige.GetPRGMemory(), cartrige.GetPRGSize()), BlockCount());
+	out("static const bool s_IsRegistered = NESStaticCode::Register(&s_StaticCode);\n");
+
+	FILE* file = fopen(file_name.c_str(), "wb");
+	if (file == nullptr)
+	{
+		printf("Unable to create \"%s\"\n", file_name.c_str());
+		return false;
+	}
+	fwrite(m_Source.data(), 1, m_Source.size(), file);
+	fclose(file);
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	std::string rom_file;
+	std::string output_file;
+
+	for (int arg = 1; arg < argc; arg++)
+	{
+		if (!strcmp(argv[arg], "-h") || !strcmp(argv[arg], "--help"))
+		{
+			PrintUsage(argv[0]);
+			return 0;
+		}
+		else if ((!strcmp(argv[arg], "-o") || !strcmp(argv[arg], "--output")) && (arg + 1) < argc)
+		{
+			output_file = argv[++arg];
+		}
+		else if (argv[arg][0] != '-' && rom_file.empty())
+		{
+			rom_file = argv[arg];
+		}
+		else
+		{
+			printf("Unknown argument \"%s\"\n", argv[arg]);
+			PrintUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (rom_file.empty())
+	{
+		PrintUsage(argv[0]);
+		return 1;
+	}
+	if (output_file.empty())
+		output_file = rom_file + ".static.cpp";
+
+	NESDevice nesDevice;
+	if (!nesDevice.GetCartrige().LoadCartrige(rom_file))
+		return 2;
+	if (nesDevice.GetCartrige().GetMapperID() != 0)
+	{
+		printf("Only NROM (mapper 0) titles can be recompiled, \"%s\" uses mapper %d\n", rom_file.c_str(), nesDevice.GetCartrige().GetMapperID());
+		return 2;
+	}
+	nesDevice.Reset();
+
+	Recompiler recompiler(nesDevice);
+	if (!recompiler.Analyze())
+	{
+		printf("No code found in \"%s\"\n", rom_file.c_str());
+		return 3;
+	}
+	if (!recompiler.Write(output_file))
+		return 3;
+
+	printf("%d instructions in %d blocks written to \"%s\"\n", recompiler.InstructionCount(), recompiler.BlockCount(), output_file.c_str());
+	return 0;
+}